@@ -97,7 +97,11 @@
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES			( 10 )
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 384 ) /* Can be as low as 60 but some of the demo tasks that use this constant require it to be higher. */
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 50 * 1024 ) )
+/* Only kernel objects created at startup (LibXR threads, semaphores) come from
+ * heap_4; check the minimum free heap with SYS_Stats before growing them. */
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 20 * 1024 ) )
+#define configSUPPORT_STATIC_ALLOCATION	1
+#define configSUPPORT_DYNAMIC_ALLOCATION	1
 #define configMAX_TASK_NAME_LEN			( 16 )
 #define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			0
@@ -109,7 +113,7 @@
 #define configUSE_MALLOC_FAILED_HOOK	0
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
 #define configRECORD_STACK_HIGH_ADDRESS 1
 #define configISR_STACK_SIZE_WORDS      256
@@ -143,6 +147,20 @@ to exclude the API function. */
 
 #include "ch32v30x.h"
 
+/* Task switches go to the probe event trace (EVENT_Read) */
+#ifndef __ASSEMBLER__
+extern void dap_trace_task_switched_in(unsigned long task_number);
+#endif
+#define traceTASK_SWITCHED_IN() \
+    dap_trace_task_switched_in( ( unsigned long ) pxCurrentTCB->uxTCBNumber )
+
+/* Run-time stats clock, see runtime_stats_timer.h (SYS_Stats) */
+#ifndef __ASSEMBLER__
+#include "runtime_stats_timer.h"
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() runtime_stats_timer_init()
+#define portGET_RUN_TIME_COUNTER_VALUE() runtime_stats_timer_count()
+
 /* Normal assert() semantics without relying on the provision of an assert.h
 header file. */
 #define configASSERT( x ) if( ( x ) == 0 ) { taskDISABLE_INTERRUPTS(); while(1); }
@@ -0,0 +1,74 @@
+#include "runtime_stats_timer.h"
+
+#include "ch32v30x.h"
+
+void TIM7_IRQHandler(void) __attribute__((interrupt));
+
+static volatile uint32_t overflows;
+
+void runtime_stats_timer_init(void)
+{
+  RCC_ClocksTypeDef clocks;
+  RCC_GetClocksFreq(&clocks);
+
+  /* APB1 timers run at twice PCLK1 whenever APB1 is divided */
+  uint32_t timer_clock = clocks.PCLK1_Frequency;
+  if (clocks.PCLK1_Frequency != clocks.HCLK_Frequency)
+  {
+    timer_clock *= 2;
+  }
+
+  RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM7, ENABLE);
+
+  TIM_TimeBaseInitTypeDef base = {0};
+  base.TIM_Prescaler = (uint16_t)(timer_clock / RUNTIME_STATS_TIMER_HZ - 1);
+  base.TIM_Period = 0xFFFF;
+  base.TIM_CounterMode = TIM_CounterMode_Up;
+  base.TIM_ClockDivision = TIM_CKD_DIV1;
+  TIM_TimeBaseInit(TIM7, &base);
+
+  /* TimeBaseInit loads the prescaler through an update event, drop its flag */
+  TIM_ClearITPendingBit(TIM7, TIM_IT_Update);
+  TIM_ITConfig(TIM7, TIM_IT_Update, ENABLE);
+
+  /* Highest preemption priority, so no reader can run between clearing the
+   * flag and counting the overflow. It fires every 0.65 s. */
+  NVIC_InitTypeDef nvic = {0};
+  nvic.NVIC_IRQChannel = TIM7_IRQn;
+  nvic.NVIC_IRQChannelPreemptionPriority = 0;
+  nvic.NVIC_IRQChannelSubPriority = 0;
+  nvic.NVIC_IRQChannelCmd = ENABLE;
+  NVIC_Init(&nvic);
+
+  TIM_Cmd(TIM7, ENABLE);
+}
+
+unsigned long runtime_stats_timer_count(void)
+{
+  uint32_t before;
+  uint32_t high;
+  uint32_t low;
+  do
+  {
+    before = overflows;
+    high = before;
+    low = TIM7->CNT;
+    /* Wrapped, but the interrupt has not run yet (interrupts masked during a
+     * context switch). CNT is read again so it belongs to the new period. */
+    if (TIM_GetFlagStatus(TIM7, TIM_FLAG_Update) == SET)
+    {
+      low = TIM7->CNT;
+      high++;
+    }
+    /* Only retried if the interrupt counted a wrap meanwhile, so this also
+     * ends with interrupts masked */
+  } while (before != overflows);
+
+  return (unsigned long)((high << 16) | low);
+}
+
+void TIM7_IRQHandler(void)
+{
+  TIM_ClearITPendingBit(TIM7, TIM_IT_Update);
+  overflows++;
+}
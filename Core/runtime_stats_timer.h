@@ -0,0 +1,23 @@
+#ifndef RUNTIME_STATS_TIMER_H
+#define RUNTIME_STATS_TIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* FreeRTOS run-time stats clock: TIM7 counting at RUNTIME_STATS_TIMER_HZ,
+ * extended to 32 bits by its overflow interrupt. Wraps after about 11.9 hours,
+ * like the 32-bit run-time counters of the kernel. */
+#define RUNTIME_STATS_TIMER_HZ 100000U
+
+void runtime_stats_timer_init(void);
+unsigned long runtime_stats_timer_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RUNTIME_STATS_TIMER_H */
@@ -1,15 +1,22 @@
 #include <cmath>
 
+#include "cdc_rtt_stream.hpp"
+#include "cdc_uart_bridge.hpp"
+#include "ch32_crc_unit.hpp"
 #include "ch32_gpio.hpp"
 #include "ch32_spi.hpp"
+#include "ch32_swd_pins.hpp"
 #include "ch32_timebase.hpp"
 #include "ch32_uart.hpp"
 #include "ch32_usb.hpp"
 #include "ch32_usb_dev.hpp"
 #include "ch32v30x_gpio.h"
+#include "dap_config.hpp"
 #include "dap_io.hpp"
+#include "freertos_system_stats.hpp"
 #include "hid_dap.hpp"
 #include "libxr.hpp"
+#include "swd_bitbang.hpp"
 
 // EP0: Control, 64 bytes
 static uint8_t ep0_buffer_hs[64];
@@ -26,24 +33,53 @@ static uint8_t ep5_buffer_tx_hs[64];
 
 uint8_t spi_dma_tx_buffer[64], spi_dma_rx_buffer[64];
 
+// USART2 DMA buffers backing the CDC-ACM virtual COM port
+static uint8_t uart_dma_rx_buffer[DAP::kCdcUartDmaRxSize];
+static uint8_t uart_dma_tx_buffer[DAP::kCdcUartDmaTxSize];
+
 extern "C" void app_main()
 {
-  LibXR::CH32SPI spi1(CH32_SPI1, {spi_dma_rx_buffer, 64}, {spi_dma_tx_buffer, 64}, GPIOA,
-                      GPIO_Pin_5, GPIOA, GPIO_Pin_6, GPIOA, GPIO_Pin_7);
+  // Everything lives in static storage, so the linker map accounts for it and
+  // DefaultTask only needs a small stack. Constructed here, after clock setup.
+  static LibXR::CH32SPI spi1(CH32_SPI1, {spi_dma_rx_buffer, 64}, {spi_dma_tx_buffer, 64},
+                             GPIOA, GPIO_Pin_5, GPIOA, GPIO_Pin_6, GPIOA, GPIO_Pin_7);
+
+  static LibXR::CH32GPIO gpio_swdio(GPIOA, GPIO_Pin_8);
+  static LibXR::CH32GPIO gpio_tdo(GPIOA, GPIO_Pin_9);
+  static LibXR::CH32GPIO gpio_nreset(GPIOA, GPIO_Pin_10);
+  static LibXR::CH32GPIO gpio_led(GPIOB, GPIO_Pin_4);
+
+  static DAP::CH32CrcUnit crc_unit;
+  static DAP::DapIo dap_io_instance(spi1, gpio_swdio, gpio_tdo, gpio_nreset, gpio_led,
+                                    &crc_unit);
+
+  // GPIO fallback on the same pins, picked per connect with SWD_SelectEngine
+  static DAP::SwdBitbang<DAP::CH32SwdPins> swd_bitbang(dap_io_instance);
+
+  static LibXR::USB::HIDCmsisDap dap_interface(dap_io_instance, 1, 1, nullptr,
+                                                 "PalmDAP CMSIS-DAP");
+  dap_interface.SetSwdBitbang(&swd_bitbang);
+
+  // Task, stack and heap usage for SYS_Stats
+  static DAP::FreeRtosSystemStats system_stats;
+  dap_interface.SetSystemStats(&system_stats);
 
-  LibXR::CH32GPIO gpio_swdio(GPIOA, GPIO_Pin_8);
-  LibXR::CH32GPIO gpio_tdo(GPIOA, GPIO_Pin_9);
-  LibXR::CH32GPIO gpio_nreset(GPIOA, GPIO_Pin_10);
-  LibXR::CH32GPIO gpio_led(GPIOB, GPIO_Pin_4);
+  // Virtual COM port: USART2 TX = PA2, RX = PA3
+  static LibXR::CH32UART uart2(
+      CH32_USART2, {uart_dma_rx_buffer, sizeof(uart_dma_rx_buffer)},
+      {uart_dma_tx_buffer, sizeof(uart_dma_tx_buffer)}, GPIOA, GPIO_Pin_2, GPIOA,
+      GPIO_Pin_3);
 
-  DAP::DapIo dap_io_instance(spi1, gpio_swdio, gpio_tdo, gpio_nreset, gpio_led);
+  static LibXR::USB::CDCUartBridge cdc_interface(uart2);
 
-  LibXR::USB::HIDCmsisDap dap_interface(dap_io_instance, 1, 1);
+  // Second COM port streaming the target's RTT up-buffer (RTT_Start flag bit 0)
+  static LibXR::USB::CDCRttStream rtt_interface;
+  dap_interface.SetRttSink(&rtt_interface);
 
   static constexpr auto LANG_PACK_EN_US = LibXR::USB::DescriptorStrings::MakeLanguagePack(
       LibXR::USB::DescriptorStrings::Language::EN_US, "PalmDAP",
       "CMSIS-DAP(Powered by LibXR)", "12345678900000");
-  LibXR::CH32USBDeviceFS usb_device(
+  static LibXR::CH32USBDeviceFS usb_device(
       /* EP */
       {
           {ep0_buffer_hs},     // EP0: Control
@@ -60,20 +96,20 @@ extern "C" void app_main()
       /* language */
       {&LANG_PACK_EN_US},
       /* config */
-      // HID-only CMSIS-DAP device (simple and focused)
+      // Composite device: CMSIS-DAP HID + UART and RTT CDC-ACM ports
       {
-          {&dap_interface},
+          {&dap_interface, &cdc_interface, &rtt_interface},
       });
 
   usb_device.Init();
   usb_device.Start();
 
   // Initialize GPIO pins used by SPI and DAP
-  LibXR::CH32GPIO spi_sck(GPIOA, GPIO_Pin_5);   // SPI1 SCK
-  LibXR::CH32GPIO spi_miso(GPIOA, GPIO_Pin_6);  // SPI1 MISO
-  LibXR::CH32GPIO spi_mosi(GPIOA, GPIO_Pin_7);  // SPI1 MOSI
+  static LibXR::CH32GPIO spi_sck(GPIOA, GPIO_Pin_5);   // SPI1 SCK
+  static LibXR::CH32GPIO spi_miso(GPIOA, GPIO_Pin_6);  // SPI1 MISO
+  static LibXR::CH32GPIO spi_mosi(GPIOA, GPIO_Pin_7);  // SPI1 MOSI
 
-  LibXR::CH32Timebase timebase;
+  static LibXR::CH32Timebase timebase;
 
   LibXR::PlatformInit(3, 8192);
 
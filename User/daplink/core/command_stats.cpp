@@ -0,0 +1,64 @@
+#include "command_stats.hpp"
+
+namespace DAP
+{
+
+void CommandStats::Record(uint8_t command, uint64_t cycles)
+{
+  const uint8_t slot = Slot(command);
+  if (slot == kNoSlot)
+  {
+    return;
+  }
+
+  auto& entry = entries_[slot];
+  entry.count++;
+  entry.cycles += cycles;
+
+  uint8_t bits = 0;
+  for (uint64_t v = cycles; v != 0; v >>= 1)
+  {
+    bits++;
+  }
+  uint8_t bin = (bits <= 10) ? 0 : static_cast<uint8_t>(bits - 10);
+  bin = (bin >= kBins) ? kBins - 1 : bin;
+
+  if (entry.histogram[bin] != UINT16_MAX)
+  {
+    entry.histogram[bin]++;
+  }
+}
+
+const CommandStats::Entry* CommandStats::Find(uint8_t command) const
+{
+  const uint8_t slot = Slot(command);
+  return (slot == kNoSlot) ? nullptr : &entries_[slot];
+}
+
+uint8_t CommandStats::Slot(uint8_t command)
+{
+  if (command < 0x20)
+  {
+    return command;
+  }
+  if (command >= 0x80 && command < 0xA0)
+  {
+    return static_cast<uint8_t>(command - 0x60);
+  }
+  return kNoSlot;
+}
+
+uint8_t CommandStats::Command(uint8_t slot)
+{
+  return (slot < 0x20) ? slot : static_cast<uint8_t>(slot + 0x60);
+}
+
+void CommandStats::Reset()
+{
+  for (auto& entry : entries_)
+  {
+    entry = Entry();
+  }
+}
+
+}  // namespace DAP
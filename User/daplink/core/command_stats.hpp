@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__riscv)
+extern "C" uint32_t SystemCoreClock;  // CMSIS, kept by SystemCoreClockUpdate()
+#else
+#include <chrono>
+#endif
+
+namespace DAP
+{
+
+/**
+ * @brief Rate of ReadCycles() in Hz
+ */
+inline uint32_t CyclesPerSecond()
+{
+#if defined(__riscv)
+  return SystemCoreClock;
+#else
+  return 1000000000U;
+#endif
+}
+
+/**
+ * @brief Free-running cycle count: mcycle on the probe, nanoseconds on a host
+ */
+inline uint64_t ReadCycles()
+{
+#if defined(__riscv)
+  uint32_t hi = 0;
+  uint32_t lo = 0;
+  uint32_t hi2 = 0;
+  do
+  {
+    asm volatile("csrr %0, mcycleh" : "=r"(hi));
+    asm volatile("csrr %0, mcycle" : "=r"(lo));
+    asm volatile("csrr %0, mcycleh" : "=r"(hi2));
+  } while (hi != hi2);
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+#endif
+}
+
+/**
+ * @class CommandStats
+ * @brief Per-command execution counters and latency histograms.
+ *
+ * Tracks the standard commands 0x00-0x1F and the vendor commands 0x80-0x9F.
+ * Histogram bin 0 counts executions under 2^10 cycles, bin n those in
+ * [2^(9+n), 2^(10+n)), and the last bin everything longer. Bins saturate.
+ */
+class CommandStats
+{
+ public:
+  static constexpr uint8_t kBins = 16;
+  static constexpr uint8_t kSlots = 64;
+  static constexpr uint8_t kNoSlot = 0xFF;
+
+  struct Entry
+  {
+    uint32_t count = 0;
+    uint64_t cycles = 0;
+    uint16_t histogram[kBins] = {};
+  };
+
+  /**
+   * @brief Account one execution
+   * @param command Command ID
+   * @param cycles Execution time in cycles
+   */
+  void Record(uint8_t command, uint64_t cycles);
+
+  /**
+   * @brief Entry of a command
+   * @return Null if the command ID is not tracked
+   */
+  const Entry* Find(uint8_t command) const;
+
+  const Entry& At(uint8_t slot) const { return entries_[slot]; }
+
+  static uint8_t Slot(uint8_t command);
+  static uint8_t Command(uint8_t slot);
+
+  void Reset();
+
+ private:
+  Entry entries_[kSlots];
+};
+
+}  // namespace DAP
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DAP
+{
+
+/**
+ * @class CrcUnit
+ * @brief CRC-32/MPEG-2 engine (poly 0x04C11DB7, init 0xFFFFFFFF, no reflection,
+ *        no final XOR) fed with 32-bit words, MSB of each word first.
+ *
+ * Matches the STM32-style hardware CRC unit, so a platform can plug its
+ * peripheral in through DapIo. Words are fed as read from little-endian memory.
+ */
+class CrcUnit
+{
+ public:
+  virtual ~CrcUnit() = default;
+
+  virtual void Reset() = 0;
+  virtual void Feed(const uint32_t* words, size_t count) = 0;
+  virtual uint32_t Value() const = 0;
+};
+
+// Byte-wise lookup table for the MSB-first CRC-32 polynomial
+struct Crc32Table
+{
+  uint32_t value[256];
+
+  constexpr Crc32Table() : value()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      uint32_t c = i << 24;
+      for (int bit = 0; bit < 8; bit++)
+      {
+        c = (c & 0x80000000UL) ? ((c << 1) ^ 0x04C11DB7UL) : (c << 1);
+      }
+      value[i] = c;
+    }
+  }
+};
+
+inline constexpr Crc32Table kCrc32Table{};
+
+/**
+ * @class SoftwareCrc32
+ * @brief Table-driven CrcUnit used when no hardware unit is provided.
+ */
+class SoftwareCrc32 : public CrcUnit
+{
+ public:
+  void Reset() override { crc_ = 0xFFFFFFFFUL; }
+
+  void Feed(const uint32_t* words, size_t count) override
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      const uint32_t word = words[i];
+      for (int shift = 24; shift >= 0; shift -= 8)
+      {
+        const auto index = static_cast<uint8_t>((crc_ >> 24) ^ (word >> shift));
+        crc_ = (crc_ << 8) ^ kCrc32Table.value[index];
+      }
+    }
+  }
+
+  uint32_t Value() const override { return crc_; }
+
+ private:
+  uint32_t crc_ = 0xFFFFFFFFUL;
+};
+
+}  // namespace DAP
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 namespace DAP
@@ -10,6 +11,63 @@ constexpr const char* PRODUCT_STRING = "PalmDAP CMSIS-DAP";
 constexpr const char* SERIAL_NUMBER_STRING = "1234401";
 constexpr const char* FIRMWARE_VERSION_STRING = "1.0.0";
 
-// TODO: --- Feature Flags and Resource Limits ---
+// --- Feature Flags and Resource Limits ---
+//
+// Buffers sized here are members of the objects app_main.cpp keeps in static
+// storage, so the linker accounts for all of them and none come from the heap.
+
+// RAM of the FLASH/RAM split the firmware is linked for, set by CMake
+// (PALMDAP_RAM_KB). Host builds default to the 64 KB layout.
+#ifndef DAP_RAM_KB
+#define DAP_RAM_KB 64
+#endif
+
+constexpr uint32_t kRamKb = DAP_RAM_KB;
+
+// Deep buffers grow with the RAM beyond the 64 KB layout: x2 at 128 KB, x4 at 192 KB
+// (the 96 KB layout stays at x1). Only queue depths and rings scale.
+constexpr size_t kBufferScale = (kRamKb >= 192) ? 4 : (kRamKb >= 128) ? 2 : 1;
+
+// DAP packet transport (HID, full-speed). The packet size is the 64-byte
+// full-speed interrupt report and does not scale with RAM.
+constexpr uint16_t kPacketSize = 64;   // Bytes per DAP request/response report
+constexpr uint8_t kPacketCount = 8 * kBufferScale;  // Requests queued ahead of the worker
+constexpr size_t kWorkerStackSize = 2048;
+constexpr uint32_t kUsbInTimeoutMs = 500;  // Wait for the host to fetch a response
+
+// CDC-ACM virtual COM port
+constexpr uint32_t kCdcDefaultBaudrate = 115200;
+constexpr size_t kCdcUartDmaRxSize = 1024 * kBufferScale;  // Circular RX DMA, per half
+constexpr size_t kCdcUartDmaTxSize = 1024 * kBufferScale;  // TX DMA, two ping-pong halves
+constexpr size_t kCdcPumpStackSize = 1024;
+constexpr uint32_t kCdcPumpPeriodMs = 1;    // Idle UART->USB poll period
+
+// On-probe RTT
+constexpr size_t kRttRingSize = 1024 * kBufferScale;  // Up-buffer bytes held for RTT_Read
+constexpr size_t kRttStreamSize = 1024 * kBufferScale;  // RTT COM port ring
+constexpr uint32_t kRttPollBudget = 256;    // Max bytes moved per poll
+constexpr uint32_t kRttDefaultPollMs = 10;
+
+// JTAG / RISC-V debug
+constexpr uint8_t kJtagMaxDevices = 8;      // Devices in the scan chain
+constexpr uint32_t kDmiBusyRetries = 100;   // DMI busy recoveries per operation
+constexpr uint32_t kDmiCommandTimeoutMs = 100;  // Abstract command completion
+
+// WCH RVSWD (WCH_Connect). Off until the frame layout in wch_rvswd.cpp has been
+// checked against a WCH-Link capture; WCH_Connect answers DAP_Invalid meanwhile.
+constexpr bool kRvswdEnabled = false;
+
+// Gang programming
+constexpr uint8_t kGangMaxPorts = 4;        // SWD ports driven in parallel
+constexpr size_t kGangWorkerStackSize = 1024;
+
+// On-probe flash algorithm execution
+constexpr uint32_t kFlashTimeoutMs = 5000;  // Longest single algorithm call
+
+// Packet trace capture (TRACE_Control)
+constexpr size_t kTraceRingSize = 2048 * kBufferScale;  // Encoded record bytes held
+
+// Probe event trace (EVENT_Read)
+constexpr size_t kEventTraceSize = 128 * kBufferScale;  // Events kept, 12 bytes each
 
 }  // namespace DAP
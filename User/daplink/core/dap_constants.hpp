@@ -127,7 +127,41 @@ enum class VendorCommandId : uint8_t
   Vendor28 = 0x9C,
   Vendor29 = 0x9D,
   Vendor30 = 0x9E,
-  Vendor31 = 0x9F
+  Vendor31 = 0x9F,
+
+  // PalmDAP assignments
+  RTT_Start = Vendor0,
+  RTT_Stop = Vendor1,
+  RTT_Read = Vendor2,
+  RTT_Write = Vendor3,
+  FLASH_Configure = Vendor4,
+  FLASH_LoadAlgo = Vendor5,
+  FLASH_Init = Vendor6,
+  FLASH_EraseSector = Vendor7,
+  FLASH_PageData = Vendor8,
+  FLASH_ProgramPage = Vendor9,
+  FLASH_Finish = Vendor10,
+  MEM_Crc32 = Vendor11,
+  MEM_SectorDiff = Vendor12,
+  MEM_Read = Vendor13,
+  MEM_Write = Vendor14,
+  MEM_Fill = Vendor15,
+  MEM_BlankCheck = Vendor16,
+  MEM_RamTest = Vendor17,
+  MEM_Search = Vendor18,
+  RV_Connect = Vendor19,
+  RV_DmiBatch = Vendor20,
+  RV_SbaRead = Vendor21,
+  RV_SbaWrite = Vendor22,
+  WCH_Connect = Vendor23,
+  SWD_SwitchTarget = Vendor24,
+  GANG_Connect = Vendor25,
+  GANG_TransferBlock = Vendor26,
+  SWD_SelectEngine = Vendor27,
+  TRACE_Control = Vendor28,
+  STATS_Read = Vendor29,
+  EVENT_Read = Vendor30,
+  SYS_Stats = Vendor31,
 };
 
 // DAP Status and Port Enums
@@ -197,6 +231,7 @@ constexpr uint8_t DP_CTRL_STAT = 0x04;  // R/W
 constexpr uint8_t DP_WCR = 0x04;        // Write only (JTAG specific)
 constexpr uint8_t DP_SELECT = 0x08;     // Write only
 constexpr uint8_t DP_RDBUFF = 0x0C;     // Read only
+constexpr uint8_t DP_TARGETSEL = 0x0C;  // Write only (SWD multi-drop, DPv2)
 
 // AP Registers (APnDP=1, address bits A3:A2 define the register)
 // APBANKSEL in DP_SELECT selects the bank of 4 AP registers
@@ -1,4 +1,6 @@
 #pragma once
+#include "crc_unit.hpp"
+#include "dap_config.hpp"
 #include "gpio.hpp"
 #include "spi.hpp"
 
@@ -10,20 +12,57 @@ namespace DAP
  * @brief
  * A container for injecting LibXR hardware resources into DAP related classes.
  * It holds references to the abstract base classes (SPI&, GPIO&),
+ *
+ * SWD wiring: SCK is SWCLK, MOSI drives SWDIO through a series resistor and
+ * MISO samples SWDIO. gpio_swdio is tied to SWDIO directly and is released
+ * (input) while the SPI engine runs.
+ *
+ * JTAG is bit-banged: TCK on gpio_swclk, TMS on gpio_swdio, TDI on gpio_tdi and
+ * TDO on gpio_tdo. Boards that do not route TCK and TDI to GPIOs leave them
+ * null and only offer SWD.
+ *
+ * Each DAP interface needs its own DapIo. Interfaces run on separate workers,
+ * so a hardware CRC unit may only be given to one of them.
  */
 struct DapIo
 {
   LibXR::SPI& spi;
-  LibXR::GPIO& gpio_swdio;  // Combined read/write pin
+  LibXR::GPIO& gpio_swdio;  // Direct SWDIO line (sense / override)
   LibXR::GPIO& gpio_tdo;    // JTAG TDO, if separate
   LibXR::GPIO& gpio_nreset;
   LibXR::GPIO& gpio_led;    // DAP status LED
+  CrcUnit* crc;             // Hardware CRC unit, software fallback if null
+  LibXR::GPIO* gpio_swclk;  // SWCLK/TCK as a GPIO, null if only SPI-clocked
+  LibXR::GPIO* gpio_tdi;    // JTAG TDI, null if not routed
 
   DapIo(LibXR::SPI& spi_bus, LibXR::GPIO& swdio_pin, LibXR::GPIO& tdo_pin,
-        LibXR::GPIO& nreset_pin, LibXR::GPIO& led_pin)
-      : spi(spi_bus), gpio_swdio(swdio_pin), gpio_tdo(tdo_pin), gpio_nreset(nreset_pin), gpio_led(led_pin)
+        LibXR::GPIO& nreset_pin, LibXR::GPIO& led_pin, CrcUnit* crc_unit = nullptr,
+        LibXR::GPIO* swclk_pin = nullptr, LibXR::GPIO* tdi_pin = nullptr)
+      : spi(spi_bus),
+        gpio_swdio(swdio_pin),
+        gpio_tdo(tdo_pin),
+        gpio_nreset(nreset_pin),
+        gpio_led(led_pin),
+        crc(crc_unit),
+        gpio_swclk(swclk_pin),
+        gpio_tdi(tdi_pin)
   {
   }
 };
 
+/**
+ * @struct DapGangIo
+ * @brief SWD ports for gang programming, each wired like the primary DapIo.
+ *
+ * Every port needs its own SPI (SPI1/SPI2/SPI3 ...) and SWDIO pin so the ports
+ * can shift at the same time. The primary DapIo may be listed as well; it is
+ * then shared with the normal DAP connection, which must not be used while a
+ * gang block runs.
+ */
+struct DapGangIo
+{
+  DapIo* ports[kGangMaxPorts];
+  uint8_t count;
+};
+
 }  // namespace DAP
@@ -1,108 +1,206 @@
 #include "dap_protocol.hpp"
 
 #include <cstring>
-#include <functional>
 
 #include "dap_config.hpp"
 #include "dap_io.hpp"
+#include "dap_utils.hpp"
 namespace DAP
 {
 
-DapProtocol::DapProtocol(DapIo& io) : io_(io) { Setup(); }
+DapProtocol::DapProtocol(DapIo& io, const DapGangIo* gang)
+    : io_(io), swd_(io), transfer_(swd_), mem_ap_(transfer_),
+      rtt_(mem_ap_),
+      flash_(mem_ap_),
+      crc_(io.crc ? *io.crc : soft_crc_),
+      mem_ops_(mem_ap_, crc_),
+      jtag_(io),
+      dmi_(jtag_),
+      rvswd_(io),
+      gang_(gang)
+{
+  Setup();
+}
 
 void DapProtocol::Setup()
 {
   state_ = {};
   state_.debug_port = DapPort::DISABLED;
+  wire_->Configure(state_.swd_config.turnaround, state_.swd_config.data_phase);
+  transfer_.SetConfig({});
+  transfer_.InvalidateSelect();
+  transfer_.InvalidateTarget();
+  rtt_.Stop();
+  dmi_port_ = nullptr;
 }
 
 void DapProtocol::Reset() { Setup(); }
 
-uint32_t DapProtocol::ExecuteCommand(
-    const uint8_t* request, LibXR::Callback<const uint8_t*, size_t> response_callback)
+void DapProtocol::Poll()
 {
-  DapProtocol::CommandResult r = ProcessCommand(request, response_callback);
-  return r.response_generated;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    rtt_.Poll();
+  }
 }
 
-DapProtocol::CommandResult DapProtocol::ProcessCommand(
-    const uint8_t* request, LibXR::Callback<const uint8_t*, size_t> response_callback)
+uint32_t DapProtocol::GetPollInterval() const
 {
-  const auto command = static_cast<CommandId>(request[0]);  ///< Command ID
-  const uint8_t* payload = request + 1;  ///< Pointer to request payload area
+  return rtt_.Active() ? rtt_.GetPollInterval() : UINT32_MAX;
+}
 
-  CommandResult result;  ///< Command processing result
+namespace
+{
 
-  switch (command)
+template <typename Table>
+constexpr bool FitsPacket(const Table& table)
+{
+  for (const auto& entry : table)
   {
-    case CommandId::Info:
-      result = HandleInfo(payload, response_callback);
-      break;
-    case CommandId::HostStatus:
-      result = HandleHostStatus(payload, response_callback);
-      break;
-    case CommandId::Connect:
-      result = HandleConnect(payload, response_callback);
-      break;
-    case CommandId::Disconnect:
-      result = HandleDisconnect(response_callback);
-      break;
+    if (entry.min_request > kPacketSize || entry.max_response > kPacketSize)
+    {
+      return false;
+    }
+  }
+  return true;
+}
 
-    // Essential SWD commands for OpenOCD
-    case CommandId::SWJ_Pins:
-      result = HandleSwjPins(payload, response_callback);
-      break;
-    case CommandId::SWJ_Clock:
-      result = HandleSwjClock(payload, response_callback);
-      break;
-    case CommandId::SWJ_Sequence:
-      result = HandleSwjSequence(payload, response_callback);
-      break;
-    case CommandId::SWD_Configure:
-      result = HandleSwdConfigure(payload, response_callback);
-      break;
-    case CommandId::SWD_Sequence:
-      result = HandleSwdSequence(payload, response_callback);
-      break;
-    case CommandId::TransferConfigure:
-      result = HandleTransferConfigure(payload, response_callback);
-      break;
-    case CommandId::Transfer:
-      result = HandleTransfer(payload, response_callback);
-      break;
-    case CommandId::TransferBlock:
-      result = HandleTransferBlock(payload, response_callback);
-      break;
-    case CommandId::ResetTarget:
-      result = HandleResetTarget(response_callback);
-      break;
+}  // namespace
 
-    default:
-      // Send Invalid command response
-      static uint8_t invalid_response[] = {static_cast<uint8_t>(CommandId::Invalid)};
-      response_callback.Run(true, invalid_response, sizeof(invalid_response));
-      result.response_generated = 1;
-      result.request_consumed = 1;
-      break;
+constexpr std::array<DapProtocol::CommandEntry, 256> DapProtocol::BuildCommandTable()
+{
+  std::array<CommandEntry, 256> table{};
+  auto add = [&table](auto command, Handler handler, uint16_t min_request,
+                      uint16_t max_response)
+  { table[static_cast<uint8_t>(command)] = {handler, min_request, max_response}; };
+
+  // Minimum request: command ID plus the fixed parameters the handler reads
+  add(CommandId::Info, &DapProtocol::HandleInfo, 2, kPacketSize);
+  add(CommandId::HostStatus, &DapProtocol::HandleHostStatus, 3, 2);
+  add(CommandId::Connect, &DapProtocol::HandleConnect, 2, 2);
+  add(CommandId::Disconnect, &DapProtocol::HandleDisconnect, 1, 2);
+  add(CommandId::TransferConfigure, &DapProtocol::HandleTransferConfigure, 6, 2);
+  add(CommandId::Transfer, &DapProtocol::HandleTransfer, 3, kPacketSize);
+  add(CommandId::TransferBlock, &DapProtocol::HandleTransferBlock, 5, kPacketSize);
+  add(CommandId::ResetTarget, &DapProtocol::HandleResetTarget, 1, 2);
+  add(CommandId::SWJ_Pins, &DapProtocol::HandleSwjPins, 7, 2);
+  add(CommandId::SWJ_Clock, &DapProtocol::HandleSwjClock, 5, 2);
+  add(CommandId::SWJ_Sequence, &DapProtocol::HandleSwjSequence, 2, 2);
+  add(CommandId::SWD_Configure, &DapProtocol::HandleSwdConfigure, 2, 2);
+  add(CommandId::SWD_Sequence, &DapProtocol::HandleSwdSequence, 2, kPacketSize);
+  add(CommandId::JTAG_Sequence, &DapProtocol::HandleJtagSequence, 2, kPacketSize);
+  add(CommandId::JTAG_Configure, &DapProtocol::HandleJtagConfigure, 2, 2);
+  add(CommandId::JTAG_IDCODE, &DapProtocol::HandleJtagIdcode, 2, 6);
+
+  // Vendor commands (dap_vendor.cpp)
+  add(VendorCommandId::RTT_Start, &DapProtocol::HandleRttStart, 13, 6);
+  add(VendorCommandId::RTT_Stop, &DapProtocol::HandleRttStop, 1, 2);
+  add(VendorCommandId::RTT_Read, &DapProtocol::HandleRttRead, 1, kPacketSize);
+  add(VendorCommandId::RTT_Write, &DapProtocol::HandleRttWrite, 2, 3);
+  add(VendorCommandId::FLASH_Configure, &DapProtocol::HandleFlashConfigure, 41, 2);
+  add(VendorCommandId::FLASH_LoadAlgo, &DapProtocol::HandleFlashLoadAlgo, 6, 2);
+  add(VendorCommandId::FLASH_Init, &DapProtocol::HandleFlashInit, 10, 6);
+  add(VendorCommandId::FLASH_EraseSector, &DapProtocol::HandleFlashEraseSector, 5, 6);
+  add(VendorCommandId::FLASH_PageData, &DapProtocol::HandleFlashPageData, 4, 2);
+  add(VendorCommandId::FLASH_ProgramPage, &DapProtocol::HandleFlashProgramPage, 7, 6);
+  add(VendorCommandId::FLASH_Finish, &DapProtocol::HandleFlashFinish, 2, 6);
+  add(VendorCommandId::MEM_Crc32, &DapProtocol::HandleMemCrc32, 9, 6);
+  add(VendorCommandId::MEM_SectorDiff, &DapProtocol::HandleMemSectorDiff, 2, kPacketSize);
+  add(VendorCommandId::MEM_Read, &DapProtocol::HandleMemRead, 6, kPacketSize);
+  add(VendorCommandId::MEM_Write, &DapProtocol::HandleMemWrite, 6, 2);
+  add(VendorCommandId::MEM_Fill, &DapProtocol::HandleMemFill, 17, 2);
+  add(VendorCommandId::MEM_BlankCheck, &DapProtocol::HandleMemBlankCheck, 9, 6);
+  add(VendorCommandId::MEM_RamTest, &DapProtocol::HandleMemRamTest, 9, 6);
+  add(VendorCommandId::MEM_Search, &DapProtocol::HandleMemSearch, 11, kPacketSize);
+  add(VendorCommandId::RV_Connect, &DapProtocol::HandleRvConnect, 2, 10);
+  add(VendorCommandId::RV_DmiBatch, &DapProtocol::HandleRvDmiBatch, 2, kPacketSize);
+  add(VendorCommandId::RV_SbaRead, &DapProtocol::HandleRvSbaRead, 6, kPacketSize);
+  add(VendorCommandId::RV_SbaWrite, &DapProtocol::HandleRvSbaWrite, 6, 2);
+  if (kRvswdEnabled)
+  {
+    add(VendorCommandId::WCH_Connect, &DapProtocol::HandleWchConnect, 1, 6);
   }
+  add(VendorCommandId::SWD_SwitchTarget, &DapProtocol::HandleSwdSwitchTarget, 5, 6);
+  add(VendorCommandId::GANG_Connect, &DapProtocol::HandleGangConnect, 2, kPacketSize);
+  add(VendorCommandId::GANG_TransferBlock, &DapProtocol::HandleGangTransferBlock, 3,
+      kPacketSize);
+  add(VendorCommandId::SWD_SelectEngine, &DapProtocol::HandleSwdSelectEngine, 2, 2);
+  add(VendorCommandId::TRACE_Control, &DapProtocol::HandleTraceControl, 2, kPacketSize);
+  add(VendorCommandId::STATS_Read, &DapProtocol::HandleStatsRead, 3, kPacketSize);
+  add(VendorCommandId::EVENT_Read, &DapProtocol::HandleEventRead, 2, kPacketSize);
+  add(VendorCommandId::SYS_Stats, &DapProtocol::HandleSysStats, 3, kPacketSize);
+
+  return table;
+}
 
-  return result;
+constexpr std::array<DapProtocol::CommandEntry, 256> DapProtocol::kCommandTable =
+    BuildCommandTable();
+
+uint16_t DapProtocol::MaxResponseLength(uint8_t command)
+{
+  return kCommandTable[command].max_response;
+}
+
+uint32_t DapProtocol::ExecuteCommand(
+    const uint8_t* request, LibXR::Callback<const uint8_t*, size_t> response_callback,
+    size_t request_len)
+{
+  auto& events = EventTrace::Instance();
+  events.Record(EventType::CommandStart, request[0]);
+  const uint64_t start = ReadCycles();
+  if (request_len > kPacketSize)
+  {
+    request_len = kPacketSize;  // Handler scratch buffers are sized for one packet
+  }
+  DapProtocol::CommandResult r = ProcessCommand(request, request_len, response_callback);
+  events.Record(EventType::CommandEnd, request[0]);
+
+  // The stats command would otherwise show up in, or right after, its own reset
+  if (request[0] != static_cast<uint8_t>(VendorCommandId::STATS_Read))
+  {
+    stats_.Record(request[0], ReadCycles() - start);
+  }
+
+  // An abort only applies to the command that was running when it arrived
+  transfer_.ClearAbort();
+
+  return r.response_generated;
+}
+
+DapProtocol::CommandResult DapProtocol::ProcessCommand(
+    const uint8_t* request, size_t request_len, ResponseCallback& response_callback)
+{
+  static_assert(FitsPacket(kCommandTable), "Command lengths exceed the packet size");
+
+  const CommandEntry& entry = kCommandTable[request[0]];
+  if (entry.handler != nullptr && request_len >= entry.min_request)
+  {
+    return (this->*entry.handler)(request + 1, request_len - 1, response_callback);
+  }
+
+  // Send Invalid command response
+  auto& invalid_response = ResponseBuffer<1>();
+  invalid_response[0] = static_cast<uint8_t>(CommandId::Invalid);
+  response_callback.Run(true, invalid_response, sizeof(invalid_response));
+  return {1, 1};
 }
 
 static uint8_t HandleStringInfo(const char* str, uint8_t* data_ptr)
 {
   if (!str) return 0;
-  uint8_t len = strlen(str);
+  // Long strings (e.g. a serial set at runtime) are cut to the response
+  const size_t len = strnlen(str, kPacketSize - 2);
   std::memcpy(data_ptr, str, len);
-  return len;
+  return static_cast<uint8_t>(len);
 }
 
-DapProtocol::CommandResult DapProtocol::HandleInfo(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+DapProtocol::CommandResult DapProtocol::HandleInfo(const uint8_t* req, size_t req_len,
+                                                   ResponseCallback& response_callback)
 {
+  UNUSED(req_len);
   const auto info_id = static_cast<InfoId>(*req);
 
-  static uint8_t response[64];
+  auto& response = ResponseBuffer<kPacketSize>();
   response[0] = static_cast<uint8_t>(CommandId::Info);
 
   uint8_t* data_ptr = response + 2;
@@ -117,7 +215,7 @@ DapProtocol::CommandResult DapProtocol::HandleInfo(
       data_length = HandleStringInfo(DAP::PRODUCT_STRING, data_ptr);
       break;
     case InfoId::SerialNumber:
-      data_length = HandleStringInfo(DAP::SERIAL_NUMBER_STRING, data_ptr);
+      data_length = HandleStringInfo(serial_, data_ptr);
       break;
     case InfoId::FirmwareVersion:
       data_length = HandleStringInfo(DAP::FIRMWARE_VERSION_STRING, data_ptr);
@@ -143,23 +241,24 @@ DapProtocol::CommandResult DapProtocol::HandleInfo(
     {
       uint8_t capabilities = (1U << 4);
       capabilities |= (1U << 0);  // SWD support
-      capabilities |= (1U << 1);  // JTAG support
+      if (jtag_.Available())
+      {
+        capabilities |= (1U << 1);  // JTAG support
+      }
       data_ptr[0] = capabilities;
       data_length = 1;
       break;
     }
     case InfoId::PacketSize:
     {
-      constexpr uint16_t max_packet_size = 64;
-      data_ptr[0] = static_cast<uint8_t>(max_packet_size & 0xFF);
-      data_ptr[1] = static_cast<uint8_t>((max_packet_size >> 8) & 0xFF);
+      data_ptr[0] = static_cast<uint8_t>(kPacketSize & 0xFF);
+      data_ptr[1] = static_cast<uint8_t>((kPacketSize >> 8) & 0xFF);
       data_length = 2;
       break;
     }
     case InfoId::PacketCount:
     {
-      constexpr uint16_t packet_count = 1;
-      data_ptr[0] = static_cast<uint8_t>(packet_count & 0xFF);
+      data_ptr[0] = kPacketCount;
       data_length = 1;
       break;
     }
@@ -174,12 +273,14 @@ DapProtocol::CommandResult DapProtocol::HandleInfo(
   return {1, static_cast<uint16_t>(2 + data_length)};
 }
 
-DapProtocol::CommandResult DapProtocol::HandleConnect(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+DapProtocol::CommandResult DapProtocol::HandleConnect(const uint8_t* req, size_t req_len,
+                                                      ResponseCallback& response_callback)
 {
+  UNUSED(req_len);
   const auto port = static_cast<Port>(req[0]);
   LibXR::ErrorCode success = LibXR::ErrorCode::FAILED;
   Port selected_port = port;
+  dmi_port_ = nullptr;  // RV_Connect / WCH_Connect attach again after a reconnect
 
   if (port == Port::AutoDetect || port == Port::Disabled)
   {
@@ -195,7 +296,7 @@ DapProtocol::CommandResult DapProtocol::HandleConnect(
     success = SetupJtag();
   }
 
-  static uint8_t response[2];
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::Connect);
 
   if (success == LibXR::ErrorCode::OK)
@@ -216,12 +317,14 @@ DapProtocol::CommandResult DapProtocol::HandleConnect(
 }
 
 DapProtocol::CommandResult DapProtocol::HandleDisconnect(
-    LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
+  UNUSED(req);
+  UNUSED(req_len);
   state_.debug_port = DapPort::DISABLED;
   PortOff();
 
-  static uint8_t response[2];
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::Disconnect);
   response[1] = static_cast<uint8_t>(Status::OK);
 
@@ -232,88 +335,40 @@ DapProtocol::CommandResult DapProtocol::HandleDisconnect(
 
 LibXR::ErrorCode DapProtocol::SetupSwd()
 {
-  LibXR::ErrorCode err;
-
-  // Configure SPI to generate SWCLK (SPI Mode 0 is typical for SWD)
-  // NOTE - The actual clock frequency should be set via HandleSwjClock.
-  err =
-      io_.spi.SetConfig({LibXR::SPI::ClockPolarity::LOW, LibXR::SPI::ClockPhase::EDGE_1});
-  if (err != LibXR::ErrorCode::OK)
-  {
-    return err;
-  }
+  // Bit-banged pins must not fight the SPI on shared lines
+  jtag_.Release();
 
-  // Configure GPIOs for SWDIO and nRESET as needed
-  // nRESET is open-drain, kept high (de-asserted)
-  err = io_.gpio_nreset.SetConfig({
-      LibXR::GPIO::Direction::OUTPUT_OPEN_DRAIN,
-      LibXR::GPIO::Pull::NONE  // NOTE - Assuming external pull-up
-  });
-  if (err != LibXR::ErrorCode::OK)
+  // The engine chosen by SWD_SelectEngine takes over at connect
+  SwdWire* wire = (use_swd_bitbang_ && swd_bitbang_ != nullptr) ? swd_bitbang_ : &swd_;
+  if (wire != wire_)
   {
-    return err;
+    wire_->Release();
+    wire_ = wire;
+    transfer_.SetWire(*wire_);
   }
-  io_.gpio_nreset.Write(true);  // Deassert nRESET
+  wire_->Configure(state_.swd_config.turnaround, state_.swd_config.data_phase);
 
-  // SWDIO is used for both input and output. We'll manage its direction.
-  // Start with it as an output for the switching sequence.
-  err = io_.gpio_swdio.SetConfig({
-      LibXR::GPIO::Direction::OUTPUT_PUSH_PULL,
-      LibXR::GPIO::Pull::NONE  // NOTE - Assuming external pull-up
-  });
+  LibXR::ErrorCode err = wire_->Setup();
   if (err != LibXR::ErrorCode::OK)
   {
     return err;
   }
 
-  // Execute the JTAG-to-SWD Switching Sequence as single pack
-
-  // Send > 50 SWCLK cycles with SWDIO (TMS) high to reset JTAG state machine.
-  io_.gpio_swdio.Write(true);  // SWDIO high
-
-  // Create single pack: [64 high bits] + [JTAG-to-SWD sequence 0xE79E] + [64 high bits]
-  static const uint8_t swd_sequence_pack[] = {
-      // 64 high bits to reset JTAG state machine (8 bytes * 8 = 64 bits)
-      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-      // 16-bit JTAG-to-SWD sequence (0xE79E), MSB first
-      0xE7, 0x9E,
-      // 64 high bits to finalize SWD mode
-      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-
-  auto spi_callback = LibXR::Callback<LibXR::ErrorCode>::Create(
-      [](bool in_isr, int context, LibXR::ErrorCode ec)
-      {
-        // SPI write completion callback - no action needed for now
-        UNUSED(in_isr);
-        UNUSED(context);
-        UNUSED(ec);
-      },
-      0);  // context value not used
-
-  LibXR::WriteOperation spi_op(spi_callback);
-  err = io_.spi.Write({swd_sequence_pack, sizeof(swd_sequence_pack)}, spi_op);
-  if (err != LibXR::ErrorCode::OK)
-  {
-    return err;
-  }
+  transfer_.InvalidateSelect();
+  transfer_.InvalidateTarget();
 
   return LibXR::ErrorCode::OK;
 }
 
 LibXR::ErrorCode DapProtocol::SetupJtag()
 {
-  LibXR::ErrorCode err;
-
-  // Configure SPI for JTAG clocking (Mode 0 is common)
-  err =
-      io_.spi.SetConfig({LibXR::SPI::ClockPolarity::LOW, LibXR::SPI::ClockPhase::EDGE_1});
-  if (err != LibXR::ErrorCode::OK)
+  if (!jtag_.Available())
   {
-    return err;
+    return LibXR::ErrorCode::NOT_SUPPORT;
   }
 
   // Configure GPIOs for JTAG
-  err = io_.gpio_nreset.SetConfig({
+  LibXR::ErrorCode err = io_.gpio_nreset.SetConfig({
       LibXR::GPIO::Direction::OUTPUT_OPEN_DRAIN,
       LibXR::GPIO::Pull::NONE  // NOTE - Assuming external pull-up
   });
@@ -323,47 +378,8 @@ LibXR::ErrorCode DapProtocol::SetupJtag()
   }
   io_.gpio_nreset.Write(true);  // Deassert nRESET
 
-  // TDO is a dedicated input
-  err = io_.gpio_tdo.SetConfig({
-      LibXR::GPIO::Direction::INPUT,
-      LibXR::GPIO::Pull::UP  // NOTE - often pulled up
-  });
-  if (err != LibXR::ErrorCode::OK)
-  {
-    return err;
-  }
-
-  // TODO - TMS is now shared with SWDIO, make it configurable in future
-  err = io_.gpio_swdio.SetConfig(
-      {LibXR::GPIO::Direction::OUTPUT_PUSH_PULL, LibXR::GPIO::Pull::NONE});
-  if (err != LibXR::ErrorCode::OK)
-  {
-    return err;
-  }
-
-  // Reset the JTAG TAP controller to Test-Logic-Reset state
-  io_.gpio_swdio.Write(true);  // TMS high
-
-  static const uint8_t jtag_reset_pack[] = {0xFF};
-
-  auto spi_callback = LibXR::Callback<LibXR::ErrorCode>::Create(
-      [](bool in_isr, int context, LibXR::ErrorCode ec)
-      {
-        // SPI write completion callback - no action needed for now
-        UNUSED(in_isr);
-        UNUSED(context);
-        UNUSED(ec);
-      },
-      0);  // context value not used
-
-  LibXR::WriteOperation spi_op(spi_callback);
-  err = io_.spi.Write({jtag_reset_pack, sizeof(jtag_reset_pack)}, spi_op);
-  if (err != LibXR::ErrorCode::OK)
-  {
-    return err;
-  }
-
-  return LibXR::ErrorCode::OK;
+  // TCK, TDI and TMS are bit-banged; fails on boards without TCK/TDI GPIOs
+  return jtag_.Setup();
 }
 
 void DapProtocol::PortOff()
@@ -371,13 +387,18 @@ void DapProtocol::PortOff()
   io_.gpio_swdio.SetConfig({LibXR::GPIO::Direction::INPUT, LibXR::GPIO::Pull::NONE});
   io_.gpio_tdo.SetConfig({LibXR::GPIO::Direction::INPUT, LibXR::GPIO::Pull::NONE});
   io_.gpio_nreset.SetConfig({LibXR::GPIO::Direction::INPUT, LibXR::GPIO::Pull::UP});
+  jtag_.Release();
+  wire_->Release();
+  dmi_port_ = nullptr;
 }
 
-DapProtocol::CommandResult DapProtocol::HandleSwjPins(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+DapProtocol::CommandResult DapProtocol::HandleSwjPins(const uint8_t* req, size_t req_len,
+                                                      ResponseCallback& response_callback)
 {
   // TODO: Implement actual pin control if needed
-  static uint8_t response[2];
+  UNUSED(req);
+  UNUSED(req_len);
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::SWJ_Pins);
   response[1] = 0x00;  // Status: OK
 
@@ -386,96 +407,504 @@ DapProtocol::CommandResult DapProtocol::HandleSwjPins(
 }
 
 DapProtocol::CommandResult DapProtocol::HandleSwjClock(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
-  // TODO: Implement actual clock frequency control if needed
-  static uint8_t response[2];
+  UNUSED(req_len);
+  // Both engines follow the request: SPI by prescaler, bit-bang by delay loop
+  const uint32_t hz = GetU32(req);
+  swd_.SetClock(hz);
+  if (swd_bitbang_ != nullptr)
+  {
+    swd_bitbang_->SetClock(hz);
+  }
+
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::SWJ_Clock);
   response[1] = 0x00;  // Status: OK
 
   response_callback.Run(true, response, 2);
-  return {1, 2};
+  return {5, 2};
 }
 
 DapProtocol::CommandResult DapProtocol::HandleSwjSequence(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
-  // TODO: Implement actual SWJ sequence if needed
-  static uint8_t response[2];
+  const uint32_t bit_count = (req[0] == 0) ? 256U : req[0];
+  const auto bytes = static_cast<uint16_t>((bit_count + 7) >> 3);
+
+  LibXR::ErrorCode err = LibXR::ErrorCode::ARG_ERR;
+  if (1U + bytes <= req_len)
+  {
+    err = wire_->SequenceOut(req + 1, bit_count);
+
+    // A line reset or JTAG-to-SWD switch discards the DP SELECT state
+    transfer_.InvalidateSelect();
+  }
+
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::SWJ_Sequence);
-  response[1] = 0x00;  // Status: OK
+  response[1] = static_cast<uint8_t>(
+      (err == LibXR::ErrorCode::OK) ? Status::OK : Status::Error);
 
   response_callback.Run(true, response, 2);
-  return {1, 2};
+  return {static_cast<uint16_t>(2 + bytes), 2};
 }
 
 DapProtocol::CommandResult DapProtocol::HandleSwdConfigure(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
-  // TODO: Implement actual SWD configuration if needed
-  static uint8_t response[2];
+  UNUSED(req_len);
+  // bit 1:0 turnaround period - 1, bit 2 always generate data phase
+  state_.swd_config.turnaround = static_cast<uint8_t>((req[0] & 0x03) + 1);
+  state_.swd_config.data_phase = (req[0] & 0x04) != 0;
+  wire_->Configure(state_.swd_config.turnaround, state_.swd_config.data_phase);
+
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::SWD_Configure);
-  response[1] = 0x00;  // Status: OK
+  response[1] = static_cast<uint8_t>(Status::OK);
 
   response_callback.Run(true, response, 2);
-  return {1, 2};
+  return {2, 2};
 }
 
 DapProtocol::CommandResult DapProtocol::HandleSwdSequence(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
-  // TODO: Implement actual SWD sequence if needed
-  static uint8_t response[2];
+  auto& response = ResponseBuffer<kPacketSize>();
   response[0] = static_cast<uint8_t>(CommandId::SWD_Sequence);
-  response[1] = 0x00;  // Status: OK
+  response[1] = static_cast<uint8_t>(Status::OK);
+
+  const uint8_t* p = req + 1;
+  const uint8_t* const p_end = req + req_len;
+  uint8_t* out = response + 2;
+  const uint8_t* out_end = response + sizeof(response);
+  uint8_t count = req[0];
+
+  while (count--)
+  {
+    if (p >= p_end)
+    {
+      response[1] = static_cast<uint8_t>(Status::Error);
+      break;
+    }
+
+    const uint8_t info = *p++;
+    const uint32_t clocks = info & SWD_SEQUENCE_CLK;
+    const uint32_t bit_count = (clocks != 0) ? clocks : 64U;
+    const auto bytes = static_cast<uint16_t>((bit_count + 7) >> 3);
+    LibXR::ErrorCode err = LibXR::ErrorCode::OK;
+
+    if (!(info & SWD_SEQUENCE_DIN) && p + bytes > p_end)
+    {
+      response[1] = static_cast<uint8_t>(Status::Error);
+      break;
+    }
+
+    if (info & SWD_SEQUENCE_DIN)
+    {
+      if (out + bytes > out_end)
+      {
+        response[1] = static_cast<uint8_t>(Status::Error);
+        break;
+      }
+      err = wire_->SequenceIn(out, bit_count);
+      out += bytes;
+    }
+    else
+    {
+      err = wire_->SequenceOut(p, bit_count);
+      p += bytes;
+    }
+
+    if (err != LibXR::ErrorCode::OK)
+    {
+      response[1] = static_cast<uint8_t>(Status::Error);
+      break;
+    }
+  }
+
+  const auto response_len = static_cast<uint16_t>(out - response);
+  response_callback.Run(true, response, response_len);
+  return {static_cast<uint16_t>(1 + (p - req)), response_len};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleJtagSequence(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  auto& response = ResponseBuffer<kPacketSize>();
+  response[0] = static_cast<uint8_t>(CommandId::JTAG_Sequence);
+  response[1] = static_cast<uint8_t>(
+      (state_.debug_port == DapPort::JTAG) ? Status::OK : Status::Error);
+
+  const uint8_t* p = req + 1;
+  const uint8_t* const p_end = req + req_len;
+  uint8_t* out = response + 2;
+  const uint8_t* out_end = response + sizeof(response);
+  uint8_t count = req[0];
+
+  while (count--)
+  {
+    if (p >= p_end)
+    {
+      response[1] = static_cast<uint8_t>(Status::Error);
+      break;
+    }
+
+    const uint8_t info = *p++;
+    const uint32_t clocks = info & JTAG_SEQUENCE_TCK;
+    const uint32_t bit_count = (clocks != 0) ? clocks : 64U;
+    const auto bytes = static_cast<uint16_t>((bit_count + 7) >> 3);
+    const bool capture = (info & JTAG_SEQUENCE_TDO) != 0;
+
+    if (p + bytes > p_end)
+    {
+      response[1] = static_cast<uint8_t>(Status::Error);
+      break;
+    }
+    if (capture && out + bytes > out_end)
+    {
+      response[1] = static_cast<uint8_t>(Status::Error);
+    }
+    if (response[1] == static_cast<uint8_t>(Status::OK))
+    {
+      jtag_.Sequence(bit_count, (info & JTAG_SEQUENCE_TMS) != 0, p,
+                     capture ? out : nullptr);
+      out += capture ? bytes : 0;
+    }
+    p += bytes;  // Keep consuming so the next command stays aligned
+  }
+
+  const auto response_len = static_cast<uint16_t>(out - response);
+  response_callback.Run(true, response, response_len);
+  return {static_cast<uint16_t>(1 + (p - req)), response_len};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleJtagConfigure(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  const uint8_t count = req[0];
+  const bool ok = 1U + count <= req_len && jtag_.Configure(count, req + 1);
+
+  auto& response = ResponseBuffer<2>();
+  response[0] = static_cast<uint8_t>(CommandId::JTAG_Configure);
+  response[1] = static_cast<uint8_t>(ok ? Status::OK : Status::Error);
 
   response_callback.Run(true, response, 2);
-  return {1, 2};
+  return {static_cast<uint16_t>(2 + count), 2};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleJtagIdcode(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t idcode = 0;
+  bool ok = state_.debug_port == DapPort::JTAG && jtag_.Select(req[0]);
+  if (ok)
+  {
+    // The host has loaded IDCODE (or reset the TAP) beforehand
+    idcode = static_cast<uint32_t>(jtag_.ShiftDr(0, 32));
+  }
+
+  auto& response = ResponseBuffer<6>();
+  response[0] = static_cast<uint8_t>(CommandId::JTAG_IDCODE);
+  response[1] = static_cast<uint8_t>(ok ? Status::OK : Status::Error);
+  PutU32(response + 2, idcode);
+
+  response_callback.Run(true, response, sizeof(response));
+  return {2, sizeof(response)};
 }
 
 DapProtocol::CommandResult DapProtocol::HandleTransferConfigure(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
-  // TODO: Implement actual transfer configuration if needed
-  static uint8_t response[2];
+  UNUSED(req_len);
+  TransferConfig config = transfer_.GetConfig();
+  config.idle_cycles = req[0];
+  config.retry_count = GetU16(req + 1);
+  config.match_retry = GetU16(req + 3);
+  transfer_.SetConfig(config);
+
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::TransferConfigure);
-  response[1] = 0x00;  // Status: OK
+  response[1] = static_cast<uint8_t>(Status::OK);
 
   response_callback.Run(true, response, 2);
-  return {1, 2};
+  return {6, 2};
 }
 
 DapProtocol::CommandResult DapProtocol::HandleTransfer(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
-  // TODO: This is a critical command that needs full implementation for actual debugging
-  static uint8_t response[3];
+  auto& response = ResponseBuffer<kPacketSize>();
   response[0] = static_cast<uint8_t>(CommandId::Transfer);
-  response[1] = 0xFF;  // Status: Error
-  response[2] = 0x00;  // No data transferred
 
-  response_callback.Run(true, response, 3);
-  return {5, 3};
+  uint8_t request_count = req[1];
+  const uint8_t* p = req + 2;
+  const uint8_t* const p_end = req + req_len;
+  uint8_t* out = response + 3;
+  const uint8_t* out_end = response + sizeof(response);
+
+  uint8_t response_count = 0;
+  uint8_t ack = 0;
+  bool post_read = false;
+  bool check_write = false;
+  uint32_t data = 0;
+
+  auto store = [&](uint32_t value)
+  {
+    PutU32(out, value);
+    out += 4;
+  };
+
+  if (state_.debug_port != DapPort::SWD)
+  {
+    request_count = 0;
+  }
+
+  for (; request_count != 0; request_count--)
+  {
+    // A count the packet cannot hold ends the transfer where the data runs out
+    if (p >= p_end)
+    {
+      ack = DAP_TRANSFER_ERROR;
+      break;
+    }
+
+    const uint8_t request = *p++;
+    uint32_t value = 0;  // Write data or match value
+    if (!(request & DAP_TRANSFER_RnW) || (request & DAP_TRANSFER_MATCH_VALUE))
+    {
+      if (p + 4 > p_end)
+      {
+        ack = DAP_TRANSFER_ERROR;
+        break;
+      }
+      value = GetU32(p);
+      p += 4;
+    }
+
+    if (request & DAP_TRANSFER_RnW)
+    {
+      // Reserve room for a posted value plus this read
+      if (out + 8 > out_end)
+      {
+        ack = DAP_TRANSFER_ERROR;
+        break;
+      }
+
+      if (post_read)
+      {
+        // Pipelined AP read returns the previous value, otherwise drain RDBUFF
+        if ((request & (DAP_TRANSFER_APnDP | DAP_TRANSFER_MATCH_VALUE)) ==
+            DAP_TRANSFER_APnDP)
+        {
+          ack = transfer_.Transfer(request, data);
+        }
+        else
+        {
+          ack = transfer_.Transfer(DAP_TRANSFER_RnW | DP_RDBUFF, data);
+          post_read = false;
+        }
+        if (ack != DAP_TRANSFER_OK)
+        {
+          break;
+        }
+        store(data);
+      }
+
+      if (request & DAP_TRANSFER_MATCH_VALUE)
+      {
+        const uint32_t match_value = value;
+        uint16_t match_retry = transfer_.GetConfig().match_retry;
+
+        if (request & DAP_TRANSFER_APnDP)
+        {
+          ack = transfer_.Transfer(request, data);  // Post the first AP read
+          if (ack != DAP_TRANSFER_OK)
+          {
+            break;
+          }
+        }
+
+        do
+        {
+          ack = transfer_.Transfer(request, data);
+          if (ack != DAP_TRANSFER_OK)
+          {
+            break;
+          }
+        } while ((data & transfer_.GetConfig().match_mask) != match_value &&
+                 match_retry-- != 0 && !transfer_.Aborted());
+
+        if (ack == DAP_TRANSFER_OK &&
+            (data & transfer_.GetConfig().match_mask) != match_value)
+        {
+          ack |= DAP_TRANSFER_MISMATCH;
+        }
+        if (ack != DAP_TRANSFER_OK)
+        {
+          break;
+        }
+      }
+      else if (!post_read)
+      {
+        ack = transfer_.Transfer(request, data);
+        if (ack != DAP_TRANSFER_OK)
+        {
+          break;
+        }
+        if (request & DAP_TRANSFER_APnDP)
+        {
+          post_read = true;
+        }
+        else
+        {
+          store(data);
+        }
+      }
+      check_write = false;
+    }
+    else
+    {
+      if (post_read)
+      {
+        if (out + 4 > out_end)
+        {
+          ack = DAP_TRANSFER_ERROR;
+          break;
+        }
+        ack = transfer_.Transfer(DAP_TRANSFER_RnW | DP_RDBUFF, data);
+        if (ack != DAP_TRANSFER_OK)
+        {
+          break;
+        }
+        store(data);
+        post_read = false;
+      }
+
+      data = value;
+
+      if (request & DAP_TRANSFER_MATCH_MASK)
+      {
+        transfer_.MutableConfig().match_mask = data;
+        ack = DAP_TRANSFER_OK;
+      }
+      else
+      {
+        ack = transfer_.Transfer(request, data);
+        if (ack != DAP_TRANSFER_OK)
+        {
+          break;
+        }
+        // A multi-drop target answers nothing but DPIDR right after TARGETSEL
+        check_write = (request & 0x0F) != DP_TARGETSEL;
+      }
+    }
+
+    response_count++;
+    if (transfer_.Aborted())
+    {
+      break;
+    }
+  }
+
+  // Skip requests after the failing one to report the consumed length
+  if (request_count != 0)
+  {
+    for (request_count--; request_count != 0 && p < p_end; request_count--)
+    {
+      const uint8_t skipped = *p++;
+      if (!(skipped & DAP_TRANSFER_RnW) || (skipped & DAP_TRANSFER_MATCH_VALUE))
+      {
+        p += 4;
+      }
+    }
+    p = (p > p_end) ? p_end : p;
+  }
+
+  if (ack == DAP_TRANSFER_OK)
+  {
+    if (post_read)
+    {
+      ack = transfer_.Transfer(DAP_TRANSFER_RnW | DP_RDBUFF, data);
+      if (ack == DAP_TRANSFER_OK)
+      {
+        store(data);
+      }
+    }
+    else if (check_write)
+    {
+      ack = transfer_.Transfer(DAP_TRANSFER_RnW | DP_RDBUFF, data);
+    }
+  }
+
+  response[1] = response_count;
+  response[2] = ack;
+
+  const auto response_len = static_cast<uint16_t>(out - response);
+  response_callback.Run(true, response, response_len);
+  return {static_cast<uint16_t>(1 + (p - req)), response_len};
 }
 
 DapProtocol::CommandResult DapProtocol::HandleTransferBlock(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
-  // TODO: This is a critical command that needs full implementation for actual debugging
-  static uint8_t response[3];
+  auto& response = ResponseBuffer<kPacketSize>();
+  uint32_t words[(kPacketSize - 4) / 4];
   response[0] = static_cast<uint8_t>(CommandId::TransferBlock);
-  response[1] = 0xFF;  // Status: Error
-  response[2] = 0x00;  // No data transferred
 
-  response_callback.Run(true, response, 3);
-  return {5, 3};
+  uint32_t count = GetU16(req + 1);
+  const uint8_t request = req[3];
+  const uint8_t* payload = req + 4;
+  uint32_t done = 0;
+  uint8_t ack = 0;
+  uint16_t consumed = 5;
+  uint16_t response_len = 4;
+
+  // Reads are bounded by the response, writes by the request data
+  const uint32_t max_count = (request & DAP_TRANSFER_RnW) ? (kPacketSize - 4) / 4
+                                                          : (req_len - 4) / 4;
+  if (count > max_count)
+  {
+    count = max_count;
+  }
+
+  if (state_.debug_port == DapPort::SWD && count != 0)
+  {
+    if (request & DAP_TRANSFER_RnW)
+    {
+      ack = transfer_.ReadBlock(request, words, count, done);
+      for (uint32_t i = 0; i < done; i++)
+      {
+        PutU32(response + 4 + i * 4, words[i]);
+      }
+      response_len = static_cast<uint16_t>(4 + done * 4);
+    }
+    else
+    {
+      for (uint32_t i = 0; i < count; i++)
+      {
+        words[i] = GetU32(payload + i * 4);
+      }
+      ack = transfer_.WriteBlock(request, words, count, done);
+      consumed = static_cast<uint16_t>(5 + count * 4);
+    }
+  }
+
+  PutU16(response + 1, static_cast<uint16_t>(done));
+  response[3] = ack;
+
+  response_callback.Run(true, response, response_len);
+  return {consumed, response_len};
 }
 
 DapProtocol::CommandResult DapProtocol::HandleResetTarget(
-    LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
+  UNUSED(req);
+  UNUSED(req_len);
   // TODO: Implement actual target reset if needed
-  static uint8_t response[2];
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::ResetTarget);
   response[1] = 0x00;  // Status: OK
 
@@ -484,8 +913,9 @@ DapProtocol::CommandResult DapProtocol::HandleResetTarget(
 }
 
 DapProtocol::CommandResult DapProtocol::HandleHostStatus(
-    const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback)
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
 {
+  UNUSED(req_len);
   uint8_t status = req[0];  // Status bitmask
   (void)req[1];             // Reserved for future use (was target_state)
 
@@ -510,7 +940,7 @@ DapProtocol::CommandResult DapProtocol::HandleHostStatus(
     io_.gpio_led.Write(true);
   }
 
-  static uint8_t response[2];
+  auto& response = ResponseBuffer<2>();
   response[0] = static_cast<uint8_t>(CommandId::HostStatus);  // Echo command ID
   response[1] = 0x00;                                         // Status: OK (DAP_OK)
 
@@ -1,10 +1,27 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 
+#include "command_stats.hpp"
+#include "crc_unit.hpp"
 #include "dap_constants.hpp"
 #include "dap_io.hpp"
+#include "event_trace.hpp"
+#include "flash_loader.hpp"
+#include "jtag_engine.hpp"
 #include "libxr.hpp"
+#include "mem_ap.hpp"
+#include "mem_ops.hpp"
+#include "packet_trace.hpp"
+#include "riscv_dmi.hpp"
+#include "riscv_sba.hpp"
+#include "rtt_engine.hpp"
+#include "swd_engine.hpp"
+#include "swd_gang.hpp"
+#include "system_stats.hpp"
+#include "transfer_engine.hpp"
+#include "wch_rvswd.hpp"
 
 namespace DAP
 {
@@ -12,44 +29,100 @@ namespace DAP
 // DAP Protocol Constants
 constexpr uint16_t kMaxRequestSize = 512;
 constexpr uint16_t kMaxResponseSize = 512;
-constexpr uint16_t kDefaultRetryCount = 100;
-constexpr uint8_t kDefaultIdleCycles = 0;
 
 enum class DapPort : uint8_t
 {
   DISABLED = 0,
   SWD = 1,
-  JTAG = 2
+  JTAG = 2,
+  RVSWD = 3  // WCH single-wire debug, entered by WCH_Connect
 };
 
 // DAP (Debug Access Port) Protocol Handler
 class DapProtocol
 {
  public:
-  explicit DapProtocol(DapIo& io);
+  /**
+   * @param io Primary debug port
+   * @param gang Extra SWD ports for gang programming, null if the board has none
+   */
+  explicit DapProtocol(DapIo& io, const DapGangIo* gang = nullptr);
 
   /**
    * @brief Execute DAP command
    * @param request Pointer to request buffer (contains command ID and parameters)
    * @param response_callback Callback to send response data
+   * @param request_len Bytes received, including the command ID. Handlers never
+   *        parse past them, at most kPacketSize are used.
    * @return Total response length in bytes
    */
   uint32_t ExecuteCommand(const uint8_t* request,
-                          LibXR::Callback<const uint8_t*, size_t> response_callback);
+                          LibXR::Callback<const uint8_t*, size_t> response_callback,
+                          size_t request_len = kPacketSize);
+
+  /**
+   * @brief Longest response a command generates
+   * @param command Command ID
+   * @return 0 if the command is not supported
+   */
+  static uint16_t MaxResponseLength(uint8_t command);
 
   void Reset();
 
+  /**
+   * @brief Request abort of the running Transfer/TransferBlock
+   *
+   * Safe to call from the USB interrupt while the worker executes a command.
+   */
+  void AbortTransfer() { transfer_.Abort(); }
+
+  /**
+   * @brief Run background work (RTT polling) between host commands
+   *
+   * Called by the owning worker after each command and on queue timeout.
+   */
+  void Poll();
+
+  /**
+   * @brief Longest time the worker may block before calling Poll()
+   * @return Timeout in milliseconds
+   */
+  uint32_t GetPollInterval() const;
+
+  /**
+   * @brief Stream RTT up-buffer data goes to when RTT_Start asks for streaming
+   * @param sink Stream of the board (e.g. a CDC port), null to remove
+   */
+  void SetRttSink(RttSink* sink) { rtt_.SetSink(sink); }
+
   DapPort GetDebugPort() const { return state_.debug_port; }
 
- private:
+  /**
+   * @brief Serial number reported by DAP_Info, identifies the port on probes
+   *        exposing several DAP interfaces
+   * @param serial Null-terminated string with static lifetime
+   */
+  void SetSerialNumber(const char* serial) { serial_ = serial; }
 
-  struct TransferConfig
-  {
-    uint8_t idle_cycles = kDefaultIdleCycles;
-    uint16_t retry_count = kDefaultRetryCount;
-    uint16_t match_retry = 0;
-    uint32_t match_mask = 0;
-  };
+  /**
+   * @brief Install the GPIO bit-bang SWD engine, selectable by SWD_SelectEngine
+   * @param engine Engine bound to this interface's pins, null to remove
+   */
+  void SetSwdBitbang(SwdWire* engine) { swd_bitbang_ = engine; }
+
+  /**
+   * @brief Packet capture buffer, filled by the owning interface and drained
+   *        with TRACE_Control
+   */
+  PacketTrace& Trace() { return trace_; }
+
+  /**
+   * @brief Install the task and heap statistics reported by SYS_Stats
+   * @param stats Provider of the RTOS port, null to remove
+   */
+  void SetSystemStats(SystemStats* stats) { system_stats_ = stats; }
+
+ private:
 
   struct SwdConfig
   {
@@ -60,8 +133,6 @@ class DapProtocol
   struct State
   {
     DapPort debug_port = DapPort::DISABLED;
-    volatile bool transfer_abort = false;
-    TransferConfig transfer_config;
     SwdConfig swd_config;
   };
 
@@ -71,6 +142,26 @@ class DapProtocol
     uint16_t response_generated = 0;
   };
 
+  using ResponseCallback = LibXR::Callback<const uint8_t*, size_t>;
+  using Handler = CommandResult (DapProtocol::*)(const uint8_t* req, size_t req_len,
+                                                 ResponseCallback& response_callback);
+
+  /**
+   * @brief Dispatch table entry, lengths include the command ID
+   */
+  struct CommandEntry
+  {
+    Handler handler = nullptr;  // Null if the command is not supported
+    uint16_t min_request = 0;   // Shorter requests are rejected before dispatch
+    uint16_t max_response = 0;
+  };
+
+  /**
+   * @brief Handlers indexed by command ID, built at compile time
+   */
+  static const std::array<CommandEntry, 256> kCommandTable;
+  static constexpr std::array<CommandEntry, 256> BuildCommandTable();
+
   // Core Processing
 
   void Setup();
@@ -78,29 +169,36 @@ class DapProtocol
   /**
    * @brief Processes a DAP command and generates response.
    * @param request Pointer to request buffer containing command and parameters.
+   * @param request_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
+   *
+   * Unsupported commands and requests shorter than the command's fixed
+   * parameters get an Invalid response without reaching a handler. Handlers
+   * get the payload length and bound variable-length parsing by it.
    */
-  CommandResult ProcessCommand(const uint8_t* request,
-                               LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult ProcessCommand(const uint8_t* request, size_t request_len,
+                               ResponseCallback& response_callback);
 
   // Command Handlers
 
   /**
    * @brief Handles DAP_Info command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x00] [Info_ID]
    * Response format: [Status] [Info_data...]
    */
-  CommandResult HandleInfo(const uint8_t* req,
-                           LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleInfo(const uint8_t* req, size_t req_len,
+                           ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_HostStatus command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
@@ -111,146 +209,611 @@ class DapProtocol
    * bit 0: Connected (0=Not connected, 1=Connected) - controls LED_CONNECTED
    * bit 1: Running (0=Not running, 1=Running) - controls LED_RUNNING
    */
-  CommandResult HandleHostStatus(
-      const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleHostStatus(const uint8_t* req, size_t req_len,
+                                 ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_Connect command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x02] [Port=0=Default/1=SWD/2=JTAG]
    * Response format: [Port_status=0=Failed/1=SWD/2=JTAG]
    */
-  CommandResult HandleConnect(const uint8_t* req,
-                              LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleConnect(const uint8_t* req, size_t req_len,
+                              ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_Disconnect command requests.
+   * @param req Unused, the command has no parameters.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x03]
    * Response format: [Status=0x00=DAP_OK]
    */
-  CommandResult HandleDisconnect(
-      LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleDisconnect(const uint8_t* req, size_t req_len,
+                                 ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_TransferConfigure command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x04] [Idle_cycles] [Retry_count(L)] [Retry_count(H)] [Match_retry(L)] [Match_retry(H)]
    * Response format: [0x00=DAP_OK]
    */
-  CommandResult HandleTransferConfigure(
-      const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleTransferConfigure(const uint8_t* req, size_t req_len,
+                                        ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_Transfer command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x05] [DAP_index] [Transfer_count] [Transfer_requests...]
    * Response format: [Transfer_count] [Response_data...] [Status]
    */
-  CommandResult HandleTransfer(const uint8_t* req,
-                               LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleTransfer(const uint8_t* req, size_t req_len,
+                               ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_TransferBlock command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x06] [DAP_index] [Transfer_count(L)] [Transfer_count(H)] [Transfer_request] [Data...]
    * Response format: [Transfer_count(L)] [Transfer_count(H)] [Response_data...] [Status]
    */
-  CommandResult HandleTransferBlock(
-      const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleTransferBlock(const uint8_t* req, size_t req_len,
+                                    ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_ResetTarget command requests.
+   * @param req Unused, the command has no parameters.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x0A]
    * Response format: [Status=0x00=DAP_OK]
    */
-  CommandResult HandleResetTarget(
-      LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleResetTarget(const uint8_t* req, size_t req_len,
+                                  ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_SWJ_Pins command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x10] [Pin_select] [Pin_values] [Wait_time(L)] [Wait_time(H)]
    * Response format: [Pin_values]
    */
-  CommandResult HandleSwjPins(const uint8_t* req,
-                              LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleSwjPins(const uint8_t* req, size_t req_len,
+                              ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_SWJ_Clock command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
-   * Command format: [0x11] [Clock(L)] [Clock(H)]
-   * Response format: [0x00=DAP_OK]
+   * Command format: [0x11] [Clock(4)]
+   * Response format: [0x11] [Status]
+   *
+   * The SPI engine runs at the fastest bus clock / 2^n not above Clock; the
+   * bit-bang engine rounds to whole delay-loop iterations.
    */
-  CommandResult HandleSwjClock(const uint8_t* req,
-                               LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleSwjClock(const uint8_t* req, size_t req_len,
+                               ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_SWJ_Sequence command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x12] [Bit_count] [Sequence_data...]
    * Response format: [0x00=DAP_OK]
    */
-  CommandResult HandleSwjSequence(
-      const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleSwjSequence(const uint8_t* req, size_t req_len,
+                                  ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_SWD_Configure command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x13] [Turnaround] [Data_phase]
    * Response format: [0x00=DAP_OK]
    */
-  CommandResult HandleSwdConfigure(
-      const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleSwdConfigure(const uint8_t* req, size_t req_len,
+                                   ResponseCallback& response_callback);
 
   /**
    * @brief Handles DAP_SWD_Sequence command requests.
    * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
    * @param response_callback Callback to send response data.
    * @return CommandResult with request consumed and response generated bytes.
    *
    * Command format: [0x1D] [Sequence_count] [Sequence_info...] [Sequence_data...]
    * Response format: [Sequence_count] [Sequence_info...] [Response_data...]
    */
-  CommandResult HandleSwdSequence(
-      const uint8_t* req, LibXR::Callback<const uint8_t*, size_t> response_callback);
+  CommandResult HandleSwdSequence(const uint8_t* req, size_t req_len,
+                                  ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles DAP_JTAG_Sequence command requests.
+   * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
+   * @param response_callback Callback to send response data.
+   * @return CommandResult with request consumed and response generated bytes.
+   *
+   * Command format: [0x14] [Sequence_count] [Sequence_info] [TDI_data...] ...
+   * Response format: [0x14] [Status] [TDO_data...]
+   */
+  CommandResult HandleJtagSequence(const uint8_t* req, size_t req_len,
+                                   ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles DAP_JTAG_Configure command requests.
+   * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
+   * @param response_callback Callback to send response data.
+   * @return CommandResult with request consumed and response generated bytes.
+   *
+   * Command format: [0x15] [Count] [IR_length...]
+   * Response format: [0x15] [Status]
+   */
+  CommandResult HandleJtagConfigure(const uint8_t* req, size_t req_len,
+                                    ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles DAP_JTAG_IDCODE command requests.
+   * @param req Pointer to request buffer.
+   * @param req_len Bytes in the request buffer.
+   * @param response_callback Callback to send response data.
+   * @return CommandResult with request consumed and response generated bytes.
+   *
+   * Command format: [0x16] [JTAG_index]
+   * Response format: [0x16] [Status] [IDCODE(4)]
+   */
+  CommandResult HandleJtagIdcode(const uint8_t* req, size_t req_len,
+                                 ResponseCallback& response_callback);
+
+  // Vendor Command Handlers (dap_vendor.cpp)
+
+  /**
+   * @brief Handles RTT_Start vendor command.
+   *
+   * Command format: [0x80] [Address(4)] [Search_size(4)] [Up_channel] [Down_channel]
+   *                 [Poll_interval_ms(2)] ([Flags])
+   * Response format: [0x80] [Status] [Control_block_address(4)]
+   *
+   * Search_size 0 means Address is the control block itself. Nothing past
+   * Address + Search_size is read. Flags bit 0 streams the up-buffer to the
+   * board's RTT port (see SetRttSink()) instead of buffering it for RTT_Read;
+   * Status is Error if there is none. Flags defaults to 0 when omitted.
+   */
+  CommandResult HandleRttStart(const uint8_t* req, size_t req_len,
+                               ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles RTT_Stop vendor command.
+   *
+   * Command format: [0x81]
+   * Response format: [0x81] [Status]
+   */
+  CommandResult HandleRttStop(const uint8_t* req, size_t req_len,
+                              ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles RTT_Read vendor command, drains buffered up-buffer bytes.
+   *
+   * Command format: [0x82]
+   * Response format: [0x82] [Status] [Length] [Data...]
+   */
+  CommandResult HandleRttRead(const uint8_t* req, size_t req_len,
+                              ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles RTT_Write vendor command, writes to the down-buffer.
+   *
+   * Command format: [0x83] [Length] [Data...]
+   * Response format: [0x83] [Status] [Written]
+   */
+  CommandResult HandleRttWrite(const uint8_t* req, size_t req_len,
+                               ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles FLASH_Configure vendor command, sets the algorithm layout.
+   *
+   * Command format: [0x84] [Load_addr] [PC_Init] [PC_UnInit] [PC_EraseSector]
+   *                 [PC_ProgramPage] [Static_base] [Stack_top] [Buffer0] [Buffer1]
+   *                 [Page_size] (all 4 bytes)
+   * Response format: [0x84] [Status]
+   */
+  CommandResult HandleFlashConfigure(const uint8_t* req, size_t req_len,
+                                     ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles FLASH_LoadAlgo vendor command, writes algorithm image bytes.
+   *
+   * Command format: [0x85] [Offset(4)] [Length] [Data...]
+   * Response format: [0x85] [Status]
+   */
+  CommandResult HandleFlashLoadAlgo(const uint8_t* req, size_t req_len,
+                                    ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles FLASH_Init vendor command, halts the core and calls Init.
+   *
+   * Command format: [0x86] [Address(4)] [Clock(4)] [Function]
+   * Response format: [0x86] [Status] [Result(4)]
+   */
+  CommandResult HandleFlashInit(const uint8_t* req, size_t req_len,
+                                ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles FLASH_EraseSector vendor command.
+   *
+   * Command format: [0x87] [Address(4)]
+   * Response format: [0x87] [Status] [Result(4)]
+   */
+  CommandResult HandleFlashEraseSector(const uint8_t* req, size_t req_len,
+                                       ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles FLASH_PageData vendor command, fills the idle page buffer.
+   *
+   * Command format: [0x88] [Offset(2)] [Length] [Data...]
+   * Response format: [0x88] [Status]
+   */
+  CommandResult HandleFlashPageData(const uint8_t* req, size_t req_len,
+                                    ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles FLASH_ProgramPage vendor command, starts programming the
+   *        filled buffer and returns the result of the previous page.
+   *
+   * Command format: [0x89] [Address(4)] [Size(2)]
+   * Response format: [0x89] [Status] [Previous_result(4)]
+   */
+  CommandResult HandleFlashProgramPage(const uint8_t* req, size_t req_len,
+                                       ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles FLASH_Finish vendor command, waits for the last page and
+   *        calls UnInit.
+   *
+   * Command format: [0x8A] [Function]
+   * Response format: [0x8A] [Status] [Result(4)]
+   */
+  CommandResult HandleFlashFinish(const uint8_t* req, size_t req_len,
+                                  ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles MEM_Crc32 vendor command, CRCs a target range on the probe.
+   *
+   * Command format: [0x8B] [Address(4)] [Size(4)]
+   * Response format: [0x8B] [Status] [CRC(4)]
+   *
+   * Address and Size must be word aligned. The CRC is CRC-32/MPEG-2 over the
+   * little-endian words as stored in target memory.
+   */
+  CommandResult HandleMemCrc32(const uint8_t* req, size_t req_len,
+                               ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles MEM_SectorDiff vendor command, compares sector CRCs on the probe.
+   *
+   * Command format: [0x8C] [Count] Count * ([Address(4)] [Size(4)] [CRC(4)])
+   * Response format: [0x8C] [Status] [Checked] [Bitmap...]
+   *
+   * Bit n of the bitmap (LSB first) is set when sector n differs from its
+   * expected MEM_Crc32 value. Checking stops at the first access error.
+   */
+  CommandResult HandleMemSectorDiff(const uint8_t* req, size_t req_len,
+                                    ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles MEM_Read vendor command, reads bytes at any address.
+   *
+   * Command format: [0x8D] [Address(4)] [Length]
+   * Response format: [0x8D] [Status] [Length] [Data...]
+   *
+   * Length is at most packet size - 3. CSW size, narrow lanes for unaligned
+   * ends and TAR re-seeding at 1 KB boundaries are handled on the probe;
+   * CSW and TAR are left modified.
+   */
+  CommandResult HandleMemRead(const uint8_t* req, size_t req_len,
+                              ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles MEM_Write vendor command, writes bytes at any address.
+   *
+   * Command format: [0x8E] [Address(4)] [Length] [Data...]
+   * Response format: [0x8E] [Status]
+   *
+   * Length is at most packet size - 6. Handled like MEM_Read.
+   */
+  CommandResult HandleMemWrite(const uint8_t* req, size_t req_len,
+                               ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles MEM_Fill vendor command, fills a range on the probe.
+   *
+   * Command format: [0x8F] [Address(4)] [Size(4)] [Pattern(4)] [Step(4)]
+   * Response format: [0x8F] [Status]
+   *
+   * Word i is written as Pattern + i * Step; Step 0 gives a constant fill.
+   */
+  CommandResult HandleMemFill(const uint8_t* req, size_t req_len,
+                              ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles MEM_BlankCheck vendor command.
+   *
+   * Command format: [0x90] [Address(4)] [Size(4)]
+   * Response format: [0x90] [Status] [First_mismatch(4)]
+   *
+   * First_mismatch is 0xFFFFFFFF when the whole range reads as 0xFF.
+   */
+  CommandResult HandleMemBlankCheck(const uint8_t* req, size_t req_len,
+                                    ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles MEM_RamTest vendor command, destructive walking-ones and
+   *        address test.
+   *
+   * Command format: [0x91] [Address(4)] [Size(4)]
+   * Response format: [0x91] [Status] [First_failure(4)]
+   *
+   * First_failure is 0xFFFFFFFF when the test passed.
+   */
+  CommandResult HandleMemRamTest(const uint8_t* req, size_t req_len,
+                                 ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles MEM_Search vendor command, finds a masked pattern in a range.
+   *
+   * Command format: [0x92] [Address(4)] [Size(4)] [Max_matches] [Length]
+   *                 [Pattern(Length)] [Mask(Length)]
+   * Response format: [0x92] [Status] [Count] [Match_address(4) * Count]
+   *
+   * Length is 1 to 16. At most (packet size - 3) / 4 matches are returned.
+   */
+  CommandResult HandleMemSearch(const uint8_t* req, size_t req_len,
+                                ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles RV_Connect vendor command, attaches to a RISC-V JTAG DTM.
+   *
+   * Command format: [0x93] [JTAG_index]
+   * Response format: [0x93] [Status] [IDCODE(4)] [DTMCS(4)]
+   *
+   * Requires a JTAG connection. Status is Error unless the DTM implements
+   * debug spec 0.13. On success the RV_DmiBatch and RV_Sba commands use this DTM.
+   */
+  CommandResult HandleRvConnect(const uint8_t* req, size_t req_len,
+                                ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles RV_DmiBatch vendor command, runs DMI operations back to back.
+   *
+   * Command format: [0x94] [Count] Count * ([Op] [Address] [Data(4)])
+   * Response format: [0x94] [Status] [Done] [Read_data(4) per completed read]
+   *
+   * Op 1 reads, op 2 writes, op 3 writes Data to command and waits for the
+   * abstract command to finish (Status Error if cmderr was set). Busy
+   * responses are retried on the probe.
+   */
+  CommandResult HandleRvDmiBatch(const uint8_t* req, size_t req_len,
+                                 ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles RV_SbaRead vendor command, reads words by System Bus Access.
+   *
+   * Command format: [0x95] [Address(4)] [Count]
+   * Response format: [0x95] [Status] [Count] [Data(4) * Count]
+   *
+   * Count is at most (packet size - 3) / 4.
+   */
+  CommandResult HandleRvSbaRead(const uint8_t* req, size_t req_len,
+                                ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles RV_SbaWrite vendor command, writes words by System Bus Access.
+   *
+   * Command format: [0x96] [Address(4)] [Count] [Data(4) * Count]
+   * Response format: [0x96] [Status]
+   *
+   * Count is at most (packet size - 6) / 4.
+   */
+  CommandResult HandleRvSbaWrite(const uint8_t* req, size_t req_len,
+                                 ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles WCH_Connect vendor command, attaches over WCH RVSWD.
+   *
+   * Command format: [0x97]
+   * Response format: [0x97] [Status] [DMSTATUS(4)]
+   *
+   * Switches the SWD pins to RVSWD and activates the debug module. The
+   * RV_DmiBatch and RV_Sba commands then run over RVSWD until the next
+   * DAP_Connect or DAP_Disconnect. Only dispatched when kRvswdEnabled is set.
+   */
+  CommandResult HandleWchConnect(const uint8_t* req, size_t req_len,
+                                 ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles SWD_SwitchTarget vendor command, selects a multi-drop target.
+   *
+   * Command format: [0x98] [TARGETSEL(4)]
+   * Response format: [0x98] [Status] [DPIDR(4)]
+   *
+   * Issues a line reset, a TARGETSEL write and a DPIDR read, the minimum for
+   * an SWD multi-drop (DPv2) target switch. Requires an SWD connection; the
+   * debug power-up state of each target is left untouched.
+   */
+  CommandResult HandleSwdSwitchTarget(const uint8_t* req, size_t req_len,
+                                      ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles GANG_Connect vendor command, sets up the gang SWD ports.
+   *
+   * Command format: [0x99] [Port_mask]
+   * Response format: [0x99] [Status] [Ports] Ports * ([Ack] [Done] [DPIDR(4)])
+   *
+   * Ports in Port_mask that return their DPIDR take part in GANG_TransferBlock;
+   * a mask of 0 releases all ports. Status is Error unless all selected ports
+   * answered. Ack is 0 for ports outside the mask.
+   */
+  CommandResult HandleGangConnect(const uint8_t* req, size_t req_len,
+                                  ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles GANG_TransferBlock vendor command, broadcasts a transfer block.
+   *
+   * Command format: [0x9A] [Count] [Request] [Data(4) * Count, writes only]
+   * Response format: [0x9A] [Status] [Ports] Ports * ([Ack] [Done] [Data(4)])
+   *
+   * Request is a DAP_TransferBlock request byte. The block runs on all
+   * connected gang ports at the same time; Data is the last value read by a
+   * read block. Count is at most (packet size - 5) / 4.
+   */
+  CommandResult HandleGangTransferBlock(const uint8_t* req, size_t req_len,
+                                        ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles SWD_SelectEngine vendor command, picks the SWD wire engine.
+   *
+   * Command format: [0x9B] [Engine]
+   * Response format: [0x9B] [Status]
+   *
+   * Engine 0 is the SPI engine, 1 the GPIO bit-bang engine (Status Error if
+   * the board has none). The choice applies from the next DAP_Connect.
+   */
+  CommandResult HandleSwdSelectEngine(const uint8_t* req, size_t req_len,
+                                      ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles TRACE_Control vendor command, runs and drains packet capture.
+   *
+   * Command format: [0x9C] [Mode]
+   * Response format: [0x9C] [Status] [Count] [Data(Count)]
+   *
+   * Mode 0 reads up to (packet size - 3) bytes of the trace stream, 1 clears
+   * the buffer and starts recording, 2 stops recording. Count is 0 for start
+   * and stop. A read returns Status Error once records were dropped since the
+   * start; the stream stays parseable but is incomplete. TRACE_Control packets
+   * are not recorded themselves.
+   */
+  CommandResult HandleTraceControl(const uint8_t* req, size_t req_len,
+                                   ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles STATS_Read vendor command, reads or resets probe statistics.
+   *
+   * Command format: [0x9D] [Mode] [Arg]
+   *
+   * Mode 0, counters of executed commands from slot Arg on:
+   *   [0x9D] [Status] [Next] [N] N * ([Command] [Count(4)] [Cycles(8)])
+   *   Next is the slot to pass in the following read, 0xFF when done.
+   * Mode 1, latency histogram of command Arg:
+   *   [0x9D] [Status] [Command] [Bins] Bins * [Count(2)]
+   * Mode 2, SWD packet outcomes:
+   *   [0x9D] [Status] [Packets(4)] [Waits(4)] [Faults(4)] [ParityErrors(4)]
+   *   [ProtocolErrors(4)]
+   * Mode 3, reset everything: [0x9D] [Status]
+   *
+   * Cycles are CPU cycles (mcycle) from command dispatch to the return of the
+   * handler, which includes handing the response to the IN endpoint. Bin n of
+   * a histogram counts executions below 2^(10+n) cycles not counted in bin
+   * n-1; the last bin is open-ended.
+   */
+  CommandResult HandleStatsRead(const uint8_t* req, size_t req_len,
+                                ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles EVENT_Read vendor command, runs and dumps the event trace.
+   *
+   * Command format: [0x9E] [Mode]
+   * Response format, mode 0 (read): [0x9E] [Status] [Count] Count * [Event(7)]
+   * Response format, mode 1 (start): [0x9E] [Status] [CyclesPerSecond(4)]
+   * Response format, mode 2 (stop): [0x9E] [Status]
+   *
+   * A read returns the oldest unread events, up to (packet size - 3) / 7, and
+   * Status Error if events were overwritten before they were read. Stop the
+   * trace before dumping it, the dump itself records events otherwise. The
+   * trace is shared by all DAP interfaces.
+   */
+  CommandResult HandleEventRead(const uint8_t* req, size_t req_len,
+                                ResponseCallback& response_callback);
+
+  /**
+   * @brief Handles SYS_Stats vendor command, reports probe task and heap usage.
+   *
+   * Command format: [0x9F] [Mode] [Arg]
+   *
+   * Mode 0, heap and run-time totals:
+   *   [0x9F] [Status] [HeapSize(4)] [HeapFree(4)] [HeapMinFree(4)]
+   *   [TotalRunTime(4)] [RunTimeHz(4)]
+   * Mode 1, tasks from task number Arg on:
+   *   [0x9F] [Status] [Next] [N] N * ([Number] [State] [Priority]
+   *   [StackFree(2)] [RunTime(4)] [Share(2)] [Name(16)])
+   *   Next is the task number to pass in the following read, 0xFF when done.
+   *
+   * StackFree is the stack high-water mark in words, Share the task's run time
+   * in 1/100 % of the total. Status is Error if the firmware does not provide
+   * statistics (see SetSystemStats()).
+   */
+  CommandResult HandleSysStats(const uint8_t* req, size_t req_len,
+                               ResponseCallback& response_callback);
 
-  
-  
   // Prevent copying
   DapProtocol(const DapProtocol&) = delete;
   DapProtocol& operator=(const DapProtocol&) = delete;
 
  private:
+  /**
+   * @brief The response buffer of this instance viewed as an N byte array
+   *
+   * Instances on separate USB interfaces run on their own workers, so
+   * responses are not built in function statics.
+   */
+  template <size_t N>
+  uint8_t (&ResponseBuffer())[N]
+  {
+    static_assert(N <= kPacketSize, "Response exceeds the packet size");
+    return *reinterpret_cast<uint8_t(*)[N]>(response_buf_);
+  }
+
+  // Common vendor responses: [Command] [Status] ([Value(4)])
+  uint16_t RespondValue(VendorCommandId command, uint8_t ack, uint32_t value,
+                        ResponseCallback& response_callback);
+  uint16_t RespondStatus(VendorCommandId command, uint8_t ack,
+                         ResponseCallback& response_callback);
+  uint16_t RespondGang(VendorCommandId command, uint8_t ack,
+                       const SwdGang::PortResult* results, uint8_t ports,
+                       ResponseCallback& response_callback);
+
   LibXR::ErrorCode SetupSwd();
   LibXR::ErrorCode SetupJtag();
   void PortOff();
@@ -258,12 +821,28 @@ class DapProtocol
   DapIo& io_;
   State state_;
 
-  using InfoHandler = std::function<uint8_t(uint8_t* response_data_buffer)>;
-  struct InfoEntry
-  {
-    InfoId id;
-    InfoHandler handler;
-  };
+  SwdEngine swd_;
+  SwdWire* swd_bitbang_ = nullptr;  // Optional GPIO engine, see SetSwdBitbang()
+  bool use_swd_bitbang_ = false;    // Engine for the next SWD connect
+  SwdWire* wire_ = &swd_;           // Engine of the current SWD connection
+  TransferEngine transfer_;
+  MemAp mem_ap_;
+  RttEngine rtt_;
+  FlashLoader flash_;
+  SoftwareCrc32 soft_crc_;
+  CrcUnit& crc_;  // io_.crc if provided, otherwise soft_crc_
+  MemOps mem_ops_;
+  JtagEngine jtag_;
+  RiscvDmi dmi_;
+  WchRvswd rvswd_;
+  DmiPort* dmi_port_ = nullptr;  // Attached DM transport, null until connected
+  SwdGang gang_;
+  PacketTrace trace_;
+  CommandStats stats_;
+  SystemStats* system_stats_ = nullptr;  // Optional, see SetSystemStats()
+
+  const char* serial_ = SERIAL_NUMBER_STRING;
+  uint8_t response_buf_[kPacketSize] = {};
 };
 
 }  // namespace DAP
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+namespace DAP
+{
+
+// Little-endian field access for DAP packets (no alignment assumptions)
+
+inline uint16_t GetU16(const uint8_t* p)
+{
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t GetU32(const uint8_t* p)
+{
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void PutU16(uint8_t* p, uint16_t v)
+{
+  p[0] = static_cast<uint8_t>(v & 0xFF);
+  p[1] = static_cast<uint8_t>((v >> 8) & 0xFF);
+}
+
+inline void PutU32(uint8_t* p, uint32_t v)
+{
+  p[0] = static_cast<uint8_t>(v & 0xFF);
+  p[1] = static_cast<uint8_t>((v >> 8) & 0xFF);
+  p[2] = static_cast<uint8_t>((v >> 16) & 0xFF);
+  p[3] = static_cast<uint8_t>((v >> 24) & 0xFF);
+}
+
+}  // namespace DAP
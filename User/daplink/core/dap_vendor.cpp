@@ -0,0 +1,894 @@
+#include <cstring>
+
+#include "dap_config.hpp"
+#include "dap_protocol.hpp"
+#include "dap_utils.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+constexpr size_t kSectorEntrySize = 12;  // Address, Size, CRC
+constexpr size_t kMaxSectorEntries = (kPacketSize - 2) / kSectorEntrySize;
+constexpr size_t kMaxSearchMatches = (kPacketSize - 3) / 4;
+constexpr size_t kDmiOpSize = 6;  // Op, Address, Data
+constexpr size_t kMaxDmiOps = (kPacketSize - 2) / kDmiOpSize;
+constexpr size_t kMaxSbaReadWords = (kPacketSize - 3) / 4;
+constexpr size_t kMaxSbaWriteWords = (kPacketSize - 6) / 4;
+constexpr size_t kGangResultSize = 6;  // Ack, Done, Data
+constexpr size_t kStatsEntrySize = 13;  // Command, Count, Cycles
+constexpr size_t kMaxStatsEntries = (kPacketSize - 4) / kStatsEntrySize;
+constexpr size_t kTaskEntrySize = 11 + SystemStats::kNameSize;
+constexpr size_t kMaxTaskEntries = (kPacketSize - 4) / kTaskEntrySize;
+constexpr uint8_t kNoTask = 0xFF;
+
+// RTT_Read, TRACE_Control and MEM_Read put their data length in one byte after a
+// 3-byte header
+static_assert(kPacketSize <= 255 + 3, "Response data length must fit one byte");
+
+// [Command] [Status] header shared by every vendor response
+void PutHeader(uint8_t* response, VendorCommandId command, uint8_t ack)
+{
+  response[0] = static_cast<uint8_t>(command);
+  response[1] =
+      static_cast<uint8_t>((ack == DAP_TRANSFER_OK) ? Status::OK : Status::Error);
+}
+
+}  // namespace
+
+// Common vendor response: [Command] [Status] [Value(4)]
+uint16_t DapProtocol::RespondValue(VendorCommandId command, uint8_t ack, uint32_t value,
+                                   ResponseCallback& response_callback)
+{
+  auto& response = ResponseBuffer<6>();
+  PutHeader(response, command, ack);
+  PutU32(response + 2, value);
+
+  response_callback.Run(true, response, sizeof(response));
+  return sizeof(response);
+}
+
+// Gang response: [Command] [Status] [Ports] Ports * ([Ack] [Done] [Data(4)])
+uint16_t DapProtocol::RespondGang(VendorCommandId command, uint8_t ack,
+                                  const SwdGang::PortResult* results, uint8_t ports,
+                                  ResponseCallback& response_callback)
+{
+  auto& response = ResponseBuffer<3 + kGangMaxPorts * kGangResultSize>();
+  PutHeader(response, command, ack);
+  response[2] = ports;
+  for (uint8_t i = 0; i < ports; i++)
+  {
+    uint8_t* entry = response + 3 + i * kGangResultSize;
+    entry[0] = results[i].ack;
+    entry[1] = results[i].done;
+    PutU32(entry + 2, results[i].data);
+  }
+
+  const auto response_len = static_cast<uint16_t>(3 + ports * kGangResultSize);
+  response_callback.Run(true, response, response_len);
+  return response_len;
+}
+
+// Common vendor response: [Command] [Status]
+uint16_t DapProtocol::RespondStatus(VendorCommandId command, uint8_t ack,
+                                    ResponseCallback& response_callback)
+{
+  auto& response = ResponseBuffer<2>();
+  PutHeader(response, command, ack);
+
+  response_callback.Run(true, response, sizeof(response));
+  return sizeof(response);
+}
+
+DapProtocol::CommandResult DapProtocol::HandleRttStart(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  const uint32_t address = GetU32(req);
+  const uint32_t search_size = GetU32(req + 4);
+  const uint8_t up_channel = req[8];
+  const uint8_t down_channel = req[9];
+  const uint16_t interval_ms = GetU16(req + 10);
+  const uint8_t flags = (req_len > 12) ? req[12] : 0;  // Optional trailing byte
+
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    rtt_.SetPollInterval(interval_ms ? interval_ms : kRttDefaultPollMs);
+    ack = rtt_.Start(address, search_size, up_channel, down_channel, (flags & 0x01) != 0);
+  }
+
+  return {static_cast<uint16_t>((req_len > 12) ? 14 : 13),
+          RespondValue(VendorCommandId::RTT_Start, ack,
+                       rtt_.Active() ? rtt_.GetControlBlock() : 0, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleRttStop(const uint8_t* req, size_t req_len,
+                                                      ResponseCallback& response_callback)
+{
+  UNUSED(req);
+  UNUSED(req_len);
+  rtt_.Stop();
+
+  return {1,
+          RespondStatus(VendorCommandId::RTT_Stop, DAP_TRANSFER_OK, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleRttRead(const uint8_t* req, size_t req_len,
+                                                      ResponseCallback& response_callback)
+{
+  UNUSED(req);
+  UNUSED(req_len);
+  // Flush whatever the target produced since the last poll first
+  if (state_.debug_port == DapPort::SWD)
+  {
+    rtt_.Poll();
+  }
+
+  auto& response = ResponseBuffer<kPacketSize>();
+  PutHeader(response, VendorCommandId::RTT_Read,
+            rtt_.Active() ? DAP_TRANSFER_OK : DAP_TRANSFER_ERROR);
+
+  const size_t len = rtt_.ReadUp(response + 3, sizeof(response) - 3);
+  response[2] = static_cast<uint8_t>(len);
+
+  response_callback.Run(true, response, 3 + len);
+  return {1, static_cast<uint16_t>(3 + len)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleRttWrite(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  size_t len = req[0];
+  if (len > req_len - 1)
+  {
+    len = req_len - 1;
+  }
+
+  size_t written = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = rtt_.WriteDown(req + 1, len, written);
+  }
+
+  auto& response = ResponseBuffer<3>();
+  PutHeader(response, VendorCommandId::RTT_Write, ack);
+  response[2] = static_cast<uint8_t>(written);
+
+  response_callback.Run(true, response, sizeof(response));
+  return {static_cast<uint16_t>(2 + len), sizeof(response)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleFlashConfigure(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  FlashLoader::Layout layout;
+  layout.load_addr = GetU32(req);
+  layout.pc_init = GetU32(req + 4);
+  layout.pc_uninit = GetU32(req + 8);
+  layout.pc_erase_sector = GetU32(req + 12);
+  layout.pc_program_page = GetU32(req + 16);
+  layout.static_base = GetU32(req + 20);
+  layout.stack_top = GetU32(req + 24);
+  layout.buffer[0] = GetU32(req + 28);
+  layout.buffer[1] = GetU32(req + 32);
+  layout.page_size = GetU32(req + 36);
+  flash_.Configure(layout);
+
+  const uint8_t ack = flash_.Configured() ? DAP_TRANSFER_OK : DAP_TRANSFER_ERROR;
+  return {41, RespondStatus(VendorCommandId::FLASH_Configure, ack, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleFlashLoadAlgo(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  const uint32_t offset = GetU32(req);
+  const uint8_t len = req[4];
+
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD && 5U + len <= req_len)
+  {
+    ack = flash_.LoadAlgo(offset, req + 5, len);
+  }
+
+  return {static_cast<uint16_t>(6 + len),
+          RespondStatus(VendorCommandId::FLASH_LoadAlgo, ack, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleFlashInit(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t result = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = flash_.Init(GetU32(req), GetU32(req + 4), req[8], result);
+  }
+
+  return {10, RespondValue(VendorCommandId::FLASH_Init, ack, result, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleFlashEraseSector(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t result = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = flash_.EraseSector(GetU32(req), result);
+  }
+
+  return {5, RespondValue(VendorCommandId::FLASH_EraseSector, ack, result,
+                          response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleFlashPageData(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  const uint16_t offset = GetU16(req);
+  const uint8_t len = req[2];
+
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD && 3U + len <= req_len)
+  {
+    ack = flash_.PageData(offset, req + 3, len);
+  }
+
+  return {static_cast<uint16_t>(4 + len),
+          RespondStatus(VendorCommandId::FLASH_PageData, ack, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleFlashProgramPage(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t prev_result = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = flash_.ProgramPage(GetU32(req), GetU16(req + 4), prev_result);
+  }
+
+  return {7, RespondValue(VendorCommandId::FLASH_ProgramPage, ack, prev_result,
+                          response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleFlashFinish(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t result = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = flash_.Finish(req[0], result);
+  }
+
+  return {2, RespondValue(VendorCommandId::FLASH_Finish, ack, result, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleMemCrc32(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t crc = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = mem_ops_.Crc32(GetU32(req), GetU32(req + 4), crc);
+  }
+
+  return {9, RespondValue(VendorCommandId::MEM_Crc32, ack, crc, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleMemSectorDiff(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  size_t count = req[0];
+  if (count > (req_len - 1) / kSectorEntrySize)
+  {
+    count = (req_len - 1) / kSectorEntrySize;
+  }
+
+  auto& response = ResponseBuffer<3 + (kMaxSectorEntries + 7) / 8>();
+  uint8_t* bitmap = response + 3;
+  const size_t bitmap_len = (count + 7) / 8;
+  std::memset(bitmap, 0, bitmap_len);
+
+  uint8_t ack =
+      (state_.debug_port == DapPort::SWD) ? DAP_TRANSFER_OK : DAP_TRANSFER_ERROR;
+  size_t checked = 0;
+
+  for (const uint8_t* entry = req + 1; ack == DAP_TRANSFER_OK && checked < count;
+       entry += kSectorEntrySize)
+  {
+    uint32_t crc = 0;
+    ack = mem_ops_.Crc32(GetU32(entry), GetU32(entry + 4), crc);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      if (crc != GetU32(entry + 8))
+      {
+        bitmap[checked / 8] |= static_cast<uint8_t>(1U << (checked % 8));
+      }
+      checked++;
+    }
+  }
+
+  PutHeader(response, VendorCommandId::MEM_SectorDiff, ack);
+  response[2] = static_cast<uint8_t>(checked);
+
+  response_callback.Run(true, response, 3 + bitmap_len);
+  return {static_cast<uint16_t>(2 + count * kSectorEntrySize),
+          static_cast<uint16_t>(3 + bitmap_len)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleMemRead(const uint8_t* req, size_t req_len,
+                                                      ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  auto& response = ResponseBuffer<kPacketSize>();
+  const uint32_t address = GetU32(req);
+  uint8_t len = req[4];
+
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD && len <= sizeof(response) - 3)
+  {
+    ack = mem_ap_.Read(address, response + 3, len);
+  }
+  if (ack != DAP_TRANSFER_OK)
+  {
+    len = 0;
+  }
+
+  PutHeader(response, VendorCommandId::MEM_Read, ack);
+  response[2] = len;
+
+  response_callback.Run(true, response, 3 + len);
+  return {6, static_cast<uint16_t>(3 + len)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleMemWrite(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  const uint32_t address = GetU32(req);
+  const uint8_t len = req[4];
+
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD && 5U + len <= req_len)
+  {
+    ack = mem_ap_.Write(address, req + 5, len);
+  }
+
+  return {static_cast<uint16_t>(6 + len),
+          RespondStatus(VendorCommandId::MEM_Write, ack, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleMemFill(const uint8_t* req, size_t req_len,
+                                                      ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = mem_ops_.Fill(GetU32(req), GetU32(req + 4), GetU32(req + 8), GetU32(req + 12));
+  }
+
+  return {17, RespondStatus(VendorCommandId::MEM_Fill, ack, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleMemBlankCheck(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t fail_addr = MemOps::kNoFailure;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = mem_ops_.BlankCheck(GetU32(req), GetU32(req + 4), fail_addr);
+  }
+
+  return {9, RespondValue(VendorCommandId::MEM_BlankCheck, ack, fail_addr,
+                          response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleMemRamTest(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t fail_addr = MemOps::kNoFailure;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    ack = mem_ops_.RamTest(GetU32(req), GetU32(req + 4), fail_addr);
+  }
+
+  return {9, RespondValue(VendorCommandId::MEM_RamTest, ack, fail_addr,
+                          response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleMemSearch(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  const uint32_t address = GetU32(req);
+  const uint32_t size = GetU32(req + 4);
+  uint32_t max_matches = req[8];
+  const uint8_t len = req[9];
+  const uint8_t* pattern = req + 10;
+
+  if (max_matches == 0 || max_matches > kMaxSearchMatches)
+  {
+    max_matches = kMaxSearchMatches;
+  }
+
+  uint32_t matches[kMaxSearchMatches];
+  uint32_t count = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD && 10U + 2U * len <= req_len)
+  {
+    ack = mem_ops_.Search(address, size, pattern, pattern + len, len, matches,
+                          max_matches, count);
+  }
+
+  auto& response = ResponseBuffer<3 + kMaxSearchMatches * 4>();
+  PutHeader(response, VendorCommandId::MEM_Search, ack);
+  response[2] = static_cast<uint8_t>(count);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    PutU32(response + 3 + i * 4, matches[i]);
+  }
+
+  response_callback.Run(true, response, 3 + count * 4);
+  return {static_cast<uint16_t>(11 + 2 * len), static_cast<uint16_t>(3 + count * 4)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleRvConnect(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t idcode = 0;
+  uint32_t dtmcs = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::JTAG)
+  {
+    ack = dmi_.Connect(req[0], idcode, dtmcs);
+  }
+  dmi_port_ = (ack == DAP_TRANSFER_OK) ? &dmi_ : nullptr;
+
+  auto& response = ResponseBuffer<10>();
+  PutHeader(response, VendorCommandId::RV_Connect, ack);
+  PutU32(response + 2, idcode);
+  PutU32(response + 6, dtmcs);
+
+  response_callback.Run(true, response, sizeof(response));
+  return {2, sizeof(response)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleRvDmiBatch(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  size_t count = req[0];
+  if (count > (req_len - 1) / kDmiOpSize)
+  {
+    count = (req_len - 1) / kDmiOpSize;
+  }
+
+  DmiPort::Op ops[kMaxDmiOps];
+  uint8_t ack = (dmi_port_ != nullptr) ? DAP_TRANSFER_OK : DAP_TRANSFER_ERROR;
+  for (size_t i = 0; i < count; i++)
+  {
+    const uint8_t* entry = req + 1 + i * kDmiOpSize;
+    const uint8_t type = entry[0];
+    if (type < static_cast<uint8_t>(DmiPort::OpType::READ) ||
+        type > static_cast<uint8_t>(DmiPort::OpType::COMMAND))
+    {
+      ack = DAP_TRANSFER_ERROR;
+    }
+    ops[i] = {static_cast<DmiPort::OpType>(type), entry[1], GetU32(entry + 2)};
+  }
+
+  auto& response = ResponseBuffer<3 + kMaxDmiOps * 4>();
+  uint32_t read_data[kMaxDmiOps];
+  uint32_t done = 0;
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = dmi_port_->Batch(ops, count, read_data, done);
+  }
+
+  size_t reads = 0;
+  for (uint32_t i = 0; i < done; i++)
+  {
+    if (ops[i].type == DmiPort::OpType::READ)
+    {
+      PutU32(response + 3 + reads * 4, read_data[reads]);
+      reads++;
+    }
+  }
+
+  PutHeader(response, VendorCommandId::RV_DmiBatch, ack);
+  response[2] = static_cast<uint8_t>(done);
+
+  const auto response_len = static_cast<uint16_t>(3 + reads * 4);
+  response_callback.Run(true, response, response_len);
+  return {static_cast<uint16_t>(2 + count * kDmiOpSize), response_len};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleRvSbaRead(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  const uint32_t address = GetU32(req);
+  uint8_t count = req[4];
+
+  uint32_t words[kMaxSbaReadWords];
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (dmi_port_ != nullptr && count <= kMaxSbaReadWords)
+  {
+    ack = RiscvSba(*dmi_port_).ReadBlock(address, words, count);
+  }
+  if (ack != DAP_TRANSFER_OK)
+  {
+    count = 0;
+  }
+
+  auto& response = ResponseBuffer<3 + kMaxSbaReadWords * 4>();
+  PutHeader(response, VendorCommandId::RV_SbaRead, ack);
+  response[2] = count;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    PutU32(response + 3 + i * 4, words[i]);
+  }
+
+  const auto response_len = static_cast<uint16_t>(3 + count * 4);
+  response_callback.Run(true, response, response_len);
+  return {6, response_len};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleRvSbaWrite(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  const uint32_t address = GetU32(req);
+  const uint8_t count = req[4];
+
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (dmi_port_ != nullptr && 5U + count * 4U <= req_len)
+  {
+    uint32_t words[kMaxSbaWriteWords];
+    for (uint8_t i = 0; i < count; i++)
+    {
+      words[i] = GetU32(req + 5 + i * 4);
+    }
+    ack = RiscvSba(*dmi_port_).WriteBlock(address, words, count);
+  }
+
+  return {static_cast<uint16_t>(6 + count * 4),
+          RespondStatus(VendorCommandId::RV_SbaWrite, ack, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleWchConnect(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req);
+  UNUSED(req_len);
+  // RVSWD shares SWDIO/SWCLK with SWD, so it replaces any active connection
+  rtt_.Stop();
+  jtag_.Release();
+  wire_->Release();
+  state_.debug_port = DapPort::DISABLED;
+
+  uint32_t dmstatus = 0;
+  const uint8_t ack = rvswd_.Connect(dmstatus);
+  if (ack == DAP_TRANSFER_OK)
+  {
+    state_.debug_port = DapPort::RVSWD;
+    dmi_port_ = &rvswd_;
+  }
+  else
+  {
+    PortOff();
+  }
+
+  return {1,
+          RespondValue(VendorCommandId::WCH_Connect, ack, dmstatus, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleSwdSwitchTarget(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint32_t dpidr = 0;
+  uint8_t ack = DAP_TRANSFER_ERROR;
+  if (state_.debug_port == DapPort::SWD)
+  {
+    rtt_.Stop();  // The RTT control block belongs to the previous target
+    ack = transfer_.SwitchTarget(GetU32(req), dpidr);
+  }
+
+  return {5, RespondValue(VendorCommandId::SWD_SwitchTarget, ack, dpidr,
+                         response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleGangConnect(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  SwdGang::PortResult results[kGangMaxPorts];
+  const uint8_t ack = gang_.Connect(req[0], results);
+
+  return {2, RespondGang(VendorCommandId::GANG_Connect, ack, results, gang_.PortCount(),
+                         response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleGangTransferBlock(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  uint8_t count = req[0];
+  const uint8_t request = req[1];
+  const bool write = (request & DAP_TRANSFER_RnW) == 0;
+
+  // Write data is capped at the words the request carries
+  if (write && count > (req_len - 2) / 4)
+  {
+    count = static_cast<uint8_t>((req_len - 2) / 4);
+  }
+
+  uint32_t words[SwdGang::kMaxBlockWords] = {};
+  if (write && count <= SwdGang::kMaxBlockWords)
+  {
+    for (uint8_t i = 0; i < count; i++)
+    {
+      words[i] = GetU32(req + 2 + i * 4);
+    }
+  }
+
+  SwdGang::PortResult results[kGangMaxPorts];
+  const uint8_t ack = gang_.TransferBlock(request, words, count, results);
+
+  return {static_cast<uint16_t>(3 + (write ? count * 4 : 0)),
+          RespondGang(VendorCommandId::GANG_TransferBlock, ack, results,
+                      gang_.PortCount(), response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleSwdSelectEngine(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  uint8_t ack = DAP_TRANSFER_OK;
+  if (req[0] == 0)
+  {
+    use_swd_bitbang_ = false;
+  }
+  else if (req[0] == 1 && swd_bitbang_ != nullptr)
+  {
+    use_swd_bitbang_ = true;
+  }
+  else
+  {
+    ack = DAP_TRANSFER_ERROR;
+  }
+
+  return {2, RespondStatus(VendorCommandId::SWD_SelectEngine, ack, response_callback)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleTraceControl(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  auto& response = ResponseBuffer<kPacketSize>();
+  uint8_t ack = DAP_TRANSFER_OK;
+  response[2] = 0;
+
+  switch (req[0])
+  {
+    case 0:
+      response[2] = static_cast<uint8_t>(trace_.Read(response + 3, sizeof(response) - 3));
+      if (trace_.Overflowed())
+      {
+        ack = DAP_TRANSFER_ERROR;
+      }
+      break;
+    case 1:
+      trace_.Start();
+      break;
+    case 2:
+      trace_.Stop();
+      break;
+    default:
+      ack = DAP_TRANSFER_ERROR;
+      break;
+  }
+
+  PutHeader(response, VendorCommandId::TRACE_Control, ack);
+  response_callback.Run(true, response, 3 + response[2]);
+  return {2, static_cast<uint16_t>(3 + response[2])};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleStatsRead(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  auto& response = ResponseBuffer<kPacketSize>();
+  uint8_t ack = DAP_TRANSFER_OK;
+  size_t len = 2;
+
+  switch (req[0])
+  {
+    case 0:
+    {
+      uint8_t slot = req[1];
+      uint8_t entries = 0;
+      uint8_t* out = response + 4;
+      for (; slot < CommandStats::kSlots && entries < kMaxStatsEntries; slot++)
+      {
+        const auto& entry = stats_.At(slot);
+        if (entry.count == 0)
+        {
+          continue;
+        }
+        out[0] = CommandStats::Command(slot);
+        PutU32(out + 1, entry.count);
+        PutU32(out + 5, static_cast<uint32_t>(entry.cycles));
+        PutU32(out + 9, static_cast<uint32_t>(entry.cycles >> 32));
+        out += kStatsEntrySize;
+        entries++;
+      }
+      response[2] = (slot < CommandStats::kSlots) ? slot : CommandStats::kNoSlot;
+      response[3] = entries;
+      len = static_cast<size_t>(out - response);
+      break;
+    }
+    case 1:
+    {
+      const auto* entry = stats_.Find(req[1]);
+      if (entry == nullptr)
+      {
+        ack = DAP_TRANSFER_ERROR;
+        break;
+      }
+      response[2] = req[1];
+      response[3] = CommandStats::kBins;
+      for (uint8_t i = 0; i < CommandStats::kBins; i++)
+      {
+        PutU16(response + 4 + i * 2, entry->histogram[i]);
+      }
+      len = 4 + CommandStats::kBins * 2;
+      break;
+    }
+    case 2:
+    {
+      const auto& swd = transfer_.GetStats();
+      PutU32(response + 2, swd.packets);
+      PutU32(response + 6, swd.waits);
+      PutU32(response + 10, swd.faults);
+      PutU32(response + 14, swd.parity_errors);
+      PutU32(response + 18, swd.protocol_errors);
+      len = 22;
+      break;
+    }
+    case 3:
+      stats_.Reset();
+      transfer_.ResetStats();
+      break;
+    default:
+      ack = DAP_TRANSFER_ERROR;
+      break;
+  }
+
+  PutHeader(response, VendorCommandId::STATS_Read, ack);
+  response_callback.Run(true, response, len);
+  return {3, static_cast<uint16_t>(len)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleEventRead(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  auto& events = EventTrace::Instance();
+  auto& response = ResponseBuffer<kPacketSize>();
+  uint8_t ack = DAP_TRANSFER_OK;
+  size_t len = 2;
+
+  switch (req[0])
+  {
+    case 0:
+    {
+      constexpr size_t kMaxEvents = (kPacketSize - 3) / EventTrace::kEventSize;
+      bool lost = false;
+      const size_t count = events.Read(response + 3, kMaxEvents, lost);
+      ack = lost ? DAP_TRANSFER_ERROR : DAP_TRANSFER_OK;
+      response[2] = static_cast<uint8_t>(count);
+      len = 3 + count * EventTrace::kEventSize;
+      break;
+    }
+    case 1:
+      events.Start();
+      PutU32(response + 2, CyclesPerSecond());
+      len = 6;
+      break;
+    case 2:
+      events.Stop();
+      break;
+    default:
+      ack = DAP_TRANSFER_ERROR;
+      break;
+  }
+
+  PutHeader(response, VendorCommandId::EVENT_Read, ack);
+  response_callback.Run(true, response, len);
+  return {2, static_cast<uint16_t>(len)};
+}
+
+DapProtocol::CommandResult DapProtocol::HandleSysStats(
+    const uint8_t* req, size_t req_len, ResponseCallback& response_callback)
+{
+  UNUSED(req_len);
+  if (system_stats_ == nullptr)
+  {
+    return {3, RespondStatus(VendorCommandId::SYS_Stats, DAP_TRANSFER_ERROR,
+                             response_callback)};
+  }
+
+  auto& response = ResponseBuffer<kPacketSize>();
+  uint8_t ack = DAP_TRANSFER_OK;
+  size_t len = 2;
+
+  switch (req[0])
+  {
+    case 0:
+    {
+      const auto heap = system_stats_->ReadHeap();
+      uint32_t total = 0;
+      system_stats_->ReadTasks(0, nullptr, 0, total);
+      PutU32(response + 2, heap.size);
+      PutU32(response + 6, heap.free);
+      PutU32(response + 10, heap.min_free);
+      PutU32(response + 14, total);
+      PutU32(response + 18, system_stats_->RunTimeHz());
+      len = 22;
+      break;
+    }
+    case 1:
+    {
+      // One task more than fits tells whether another page follows
+      SystemStats::Task tasks[kMaxTaskEntries + 1];
+      uint32_t total = 0;
+      const size_t count =
+          system_stats_->ReadTasks(req[1], tasks, kMaxTaskEntries + 1, total);
+      const size_t entries = (count > kMaxTaskEntries) ? kMaxTaskEntries : count;
+
+      uint8_t* out = response + 4;
+      for (size_t i = 0; i < entries; i++)
+      {
+        const auto& task = tasks[i];
+        const uint64_t share =
+            total ? static_cast<uint64_t>(task.run_time) * 10000U / total : 0;
+        out[0] = task.number;
+        out[1] = task.state;
+        out[2] = task.priority;
+        PutU16(out + 3, static_cast<uint16_t>(
+                            task.stack_free > 0xFFFF ? 0xFFFF : task.stack_free));
+        PutU32(out + 5, task.run_time);
+        PutU16(out + 9, static_cast<uint16_t>(share));
+        std::memcpy(out + 11, task.name, SystemStats::kNameSize);
+        out += kTaskEntrySize;
+      }
+      response[2] = (count > kMaxTaskEntries) ? tasks[kMaxTaskEntries].number : kNoTask;
+      response[3] = static_cast<uint8_t>(entries);
+      len = static_cast<size_t>(out - response);
+      break;
+    }
+    default:
+      ack = DAP_TRANSFER_ERROR;
+      break;
+  }
+
+  PutHeader(response, VendorCommandId::SYS_Stats, ack);
+  response_callback.Run(true, response, len);
+  return {3, static_cast<uint16_t>(len)};
+}
+
+}  // namespace DAP
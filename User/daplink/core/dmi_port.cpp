@@ -0,0 +1,73 @@
+#include "dmi_port.hpp"
+
+#include "dap_config.hpp"
+#include "dap_constants.hpp"
+#include "libxr.hpp"
+
+namespace DAP
+{
+
+uint8_t DmiPort::Execute(uint32_t command)
+{
+  uint8_t ack = Write(DM_COMMAND, command);
+
+  const auto start = static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds());
+  uint32_t abstractcs = ABSTRACTCS_BUSY;
+  while (ack == DAP_TRANSFER_OK)
+  {
+    ack = Read(DM_ABSTRACTCS, abstractcs);
+    if ((abstractcs & ABSTRACTCS_BUSY) == 0)
+    {
+      break;
+    }
+    if (static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds()) - start >
+        kDmiCommandTimeoutMs)
+    {
+      ack = DAP_TRANSFER_WAIT;
+    }
+  }
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+
+  if ((abstractcs & ABSTRACTCS_CMDERR) != 0)
+  {
+    Write(DM_ABSTRACTCS, ABSTRACTCS_CMDERR);  // W1C
+    return DAP_TRANSFER_ERROR;
+  }
+  return DAP_TRANSFER_OK;
+}
+
+uint8_t DmiPort::Batch(const Op* ops, uint32_t count, uint32_t* read_data,
+                       uint32_t& done)
+{
+  uint8_t ack = DAP_TRANSFER_OK;
+  uint32_t reads = 0;
+
+  for (done = 0; done < count; done++)
+  {
+    const Op& op = ops[done];
+    switch (op.type)
+    {
+      case OpType::READ:
+        ack = Read(op.addr, read_data[reads]);
+        reads += (ack == DAP_TRANSFER_OK) ? 1 : 0;
+        break;
+      case OpType::WRITE:
+        ack = Write(op.addr, op.data);
+        break;
+      case OpType::COMMAND:
+        ack = Execute(op.data);
+        break;
+    }
+    if (ack != DAP_TRANSFER_OK)
+    {
+      break;
+    }
+  }
+
+  return ack;
+}
+
+}  // namespace DAP
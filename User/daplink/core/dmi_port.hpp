@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+namespace DAP
+{
+
+// RISC-V Debug Module registers (Debug Spec 0.13, 3.12)
+constexpr uint8_t DM_DATA0 = 0x04;
+constexpr uint8_t DM_DMCONTROL = 0x10;
+constexpr uint8_t DM_DMSTATUS = 0x11;
+constexpr uint8_t DM_ABSTRACTCS = 0x16;
+constexpr uint8_t DM_COMMAND = 0x17;
+constexpr uint8_t DM_SBCS = 0x38;
+constexpr uint8_t DM_SBADDRESS0 = 0x39;
+constexpr uint8_t DM_SBDATA0 = 0x3C;
+
+/**
+ * @class DmiPort
+ * @brief Transport-independent access to a RISC-V Debug Module.
+ *
+ * Transports implement single register reads and writes; Execute and Batch
+ * have sequential defaults that a transport may replace with pipelined
+ * versions. Results use the DAP transfer response bits.
+ */
+class DmiPort
+{
+ public:
+  enum class OpType : uint8_t
+  {
+    READ = 1,
+    WRITE = 2,
+    COMMAND = 3,  // Write command, wait for abstractcs.busy to clear
+  };
+
+  struct Op
+  {
+    OpType type;
+    uint8_t addr;
+    uint32_t data;
+  };
+
+  virtual ~DmiPort() = default;
+
+  virtual uint8_t Read(uint8_t addr, uint32_t& value) = 0;
+  virtual uint8_t Write(uint8_t addr, uint32_t value) = 0;
+
+  /**
+   * @brief Run an abstract command and wait for it to finish
+   * @param command Value written to the command register
+   * @return DAP transfer response bits, ERROR if cmderr was set (and cleared)
+   */
+  virtual uint8_t Execute(uint32_t command);
+
+  /**
+   * @brief Run a batch of DM operations back to back
+   * @param ops Operations
+   * @param count Number of operations
+   * @param read_data Results of READ operations, in order
+   * @param done Number of operations completed
+   * @return DAP transfer response bits of the first failing operation
+   */
+  virtual uint8_t Batch(const Op* ops, uint32_t count, uint32_t* read_data,
+                        uint32_t& done);
+
+ protected:
+  static constexpr uint32_t ABSTRACTCS_BUSY = (1UL << 12);
+  static constexpr uint32_t ABSTRACTCS_CMDERR = (7UL << 8);
+};
+
+}  // namespace DAP
@@ -0,0 +1,78 @@
+#include "event_trace.hpp"
+
+#include "dap_utils.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+EventTrace event_trace;  // Constant-initialized, usable before any constructor runs
+
+}  // namespace
+
+EventTrace& EventTrace::Instance() { return event_trace; }
+
+void EventTrace::Start()
+{
+  enabled_.store(false, std::memory_order_relaxed);
+  for (auto& slot : slots_)
+  {
+    slot.seq.store(0, std::memory_order_relaxed);
+  }
+  head_.store(0, std::memory_order_relaxed);
+  read_ = 0;
+  enabled_.store(true, std::memory_order_release);
+}
+
+size_t EventTrace::Read(uint8_t* data, size_t max_events, bool& lost)
+{
+  lost = false;
+
+  const uint32_t head = head_.load(std::memory_order_acquire);
+  if (head - read_ > kEventTraceSize)
+  {
+    read_ = head - kEventTraceSize;
+    lost = true;
+  }
+
+  size_t n = 0;
+  while (n < max_events && read_ != head)
+  {
+    const Slot& slot = slots_[read_ % kEventTraceSize];
+    const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    const uint32_t cycles = slot.cycles;
+    const uint16_t arg = slot.arg;
+    const uint8_t type = slot.type;
+    std::atomic_signal_fence(std::memory_order_acquire);
+
+    if (seq == 0)
+    {
+      break;  // Still being written, pick it up on the next read
+    }
+    if (seq != read_ + 1 || slot.seq.load(std::memory_order_relaxed) != seq)
+    {
+      lost = true;  // Overwritten by a newer event while we were behind
+      read_++;
+      continue;
+    }
+
+    uint8_t* out = data + n * kEventSize;
+    PutU32(out, cycles);
+    out[4] = type;
+    PutU16(out + 5, arg);
+    n++;
+    read_++;
+  }
+
+  return n;
+}
+
+}  // namespace DAP
+
+extern "C" void dap_trace_task_switched_in(unsigned long task_number)
+{
+  DAP::EventTrace::Instance().Record(DAP::EventType::TaskSwitch,
+                                     static_cast<uint16_t>(task_number));
+}
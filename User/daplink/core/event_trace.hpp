@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "command_stats.hpp"
+#include "dap_config.hpp"
+
+namespace DAP
+{
+
+enum class EventType : uint8_t
+{
+  UsbOut = 1,        // Request report received, Arg = command ID
+  UsbIn = 2,         // Response report queued, Arg = command ID
+  CommandStart = 3,  // Arg = command ID
+  CommandEnd = 4,    // Arg = command ID
+  SpiStart = 5,      // Arg = bytes
+  SpiDone = 6,       // Arg = bytes, 0 on error
+  TaskSwitch = 7     // Arg = FreeRTOS task number switched in
+};
+
+/**
+ * @class EventTrace
+ * @brief Fixed-size ring of timestamped probe events, shared by all contexts.
+ *
+ * Recording is lock-free and may happen from interrupts, the scheduler and
+ * any task: a writer claims a slot with one atomic increment and publishes it
+ * through the slot's sequence number, so a reader can tell finished slots
+ * from slots being overwritten. The oldest events are overwritten when the
+ * reader falls behind. Timestamps are the low 32 bits of ReadCycles().
+ *
+ * Dumped with EVENT_Read, 7 bytes per event: [Cycles(4)] [Type] [Arg(2)].
+ */
+class EventTrace
+{
+ public:
+  static constexpr size_t kEventSize = 7;
+
+  constexpr EventTrace() = default;
+
+  /**
+   * @brief The probe-wide trace
+   */
+  static EventTrace& Instance();
+
+  /**
+   * @brief Record one event if tracing is enabled
+   * @param type Event type
+   * @param arg Type-specific argument
+   */
+  void Record(EventType type, uint16_t arg)
+  {
+    if (!enabled_.load(std::memory_order_relaxed))
+    {
+      return;
+    }
+
+    const uint32_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[index % kEventTraceSize];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_signal_fence(std::memory_order_release);
+    slot.cycles = static_cast<uint32_t>(ReadCycles());
+    slot.type = static_cast<uint8_t>(type);
+    slot.arg = arg;
+    slot.seq.store(index + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Discard recorded events and start recording
+   */
+  void Start();
+
+  void Stop() { enabled_.store(false, std::memory_order_relaxed); }
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Copy out events not read yet, oldest first
+   * @param data Destination, kEventSize bytes per event
+   * @param max_events Maximum events to copy
+   * @param lost Set when events were overwritten before they were read
+   * @return Events copied
+   */
+  size_t Read(uint8_t* data, size_t max_events, bool& lost);
+
+ private:
+  struct Slot
+  {
+    std::atomic<uint32_t> seq{0};  // Event index + 1 once written, 0 while writing
+    uint32_t cycles = 0;
+    uint16_t arg = 0;
+    uint8_t type = 0;
+  };
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<uint32_t> head_{0};
+  uint32_t read_ = 0;  // Next event index to hand out, reader only
+  Slot slots_[kEventTraceSize];
+};
+
+}  // namespace DAP
@@ -0,0 +1,273 @@
+#include "flash_loader.hpp"
+
+#include "dap_config.hpp"
+#include "libxr.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+// Cortex-M debug registers (ARMv7-M, C1.6)
+constexpr uint32_t DHCSR = 0xE000EDF0;
+constexpr uint32_t DCRSR = 0xE000EDF4;
+constexpr uint32_t DCRDR = 0xE000EDF8;
+
+constexpr uint32_t DBGKEY = 0xA05F0000;
+constexpr uint32_t C_DEBUGEN = (1UL << 0);
+constexpr uint32_t C_HALT = (1UL << 1);
+constexpr uint32_t C_MASKINTS = (1UL << 3);
+constexpr uint32_t S_REGRDY = (1UL << 16);
+constexpr uint32_t S_HALT = (1UL << 17);
+constexpr uint32_t DCRSR_REGWnR = (1UL << 16);
+
+constexpr uint8_t REG_R0 = 0;
+constexpr uint8_t REG_R9 = 9;
+constexpr uint8_t REG_SP = 13;
+constexpr uint8_t REG_LR = 14;
+constexpr uint8_t REG_PC = 15;
+constexpr uint8_t REG_XPSR = 16;
+
+constexpr uint32_t XPSR_T = (1UL << 24);
+constexpr uint32_t kRegReadyPolls = 100;
+
+}  // namespace
+
+FlashLoader::FlashLoader(MemAp& mem) : mem_(mem) {}
+
+void FlashLoader::Configure(const Layout& layout)
+{
+  layout_ = layout;
+  fill_ = 0;
+  running_ = false;
+}
+
+uint8_t FlashLoader::LoadAlgo(uint32_t offset, const uint8_t* data, uint32_t len)
+{
+  if (!Configured())
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+  return mem_.Write(layout_.load_addr + offset, data, len);
+}
+
+uint8_t FlashLoader::Halt()
+{
+  uint32_t value = DBGKEY | C_DEBUGEN | C_HALT;
+  uint8_t ack = mem_.WriteWords(DHCSR, &value, 1);
+
+  for (uint32_t i = 0; ack == DAP_TRANSFER_OK && i < kRegReadyPolls; i++)
+  {
+    ack = mem_.ReadWords(DHCSR, &value, 1);
+    if (ack == DAP_TRANSFER_OK && (value & S_HALT))
+    {
+      return DAP_TRANSFER_OK;
+    }
+  }
+
+  return (ack == DAP_TRANSFER_OK) ? DAP_TRANSFER_ERROR : ack;
+}
+
+uint8_t FlashLoader::WriteCoreReg(uint8_t reg, uint32_t value)
+{
+  uint8_t ack = mem_.WriteWords(DCRDR, &value, 1);
+  uint32_t select = DCRSR_REGWnR | reg;
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = mem_.WriteWords(DCRSR, &select, 1);
+  }
+
+  uint32_t status = 0;
+  for (uint32_t i = 0; ack == DAP_TRANSFER_OK && i < kRegReadyPolls; i++)
+  {
+    ack = mem_.ReadWords(DHCSR, &status, 1);
+    if (ack == DAP_TRANSFER_OK && (status & S_REGRDY))
+    {
+      return DAP_TRANSFER_OK;
+    }
+  }
+
+  return (ack == DAP_TRANSFER_OK) ? DAP_TRANSFER_ERROR : ack;
+}
+
+uint8_t FlashLoader::ReadCoreReg(uint8_t reg, uint32_t& value)
+{
+  uint32_t select = reg;
+  uint8_t ack = mem_.WriteWords(DCRSR, &select, 1);
+
+  uint32_t status = 0;
+  for (uint32_t i = 0; ack == DAP_TRANSFER_OK && i < kRegReadyPolls; i++)
+  {
+    ack = mem_.ReadWords(DHCSR, &status, 1);
+    if (ack == DAP_TRANSFER_OK && (status & S_REGRDY))
+    {
+      return mem_.ReadWords(DCRDR, &value, 1);
+    }
+  }
+
+  return (ack == DAP_TRANSFER_OK) ? DAP_TRANSFER_ERROR : ack;
+}
+
+uint8_t FlashLoader::Start(uint32_t pc, uint32_t r0, uint32_t r1, uint32_t r2)
+{
+  // Return lands on the BKPT at the algorithm base, halting the core again
+  const uint32_t regs[][2] = {
+      {REG_R0, r0},
+      {REG_R0 + 1, r1},
+      {REG_R0 + 2, r2},
+      {REG_R9, layout_.static_base},
+      {REG_SP, layout_.stack_top},
+      {REG_LR, layout_.load_addr | 1U},
+      {REG_PC, pc & ~1U},
+      {REG_XPSR, XPSR_T},
+  };
+
+  uint8_t ack = Halt();
+  for (const auto& reg : regs)
+  {
+    if (ack != DAP_TRANSFER_OK)
+    {
+      return ack;
+    }
+    ack = WriteCoreReg(static_cast<uint8_t>(reg[0]), reg[1]);
+  }
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+
+  uint32_t value = DBGKEY | C_DEBUGEN | C_MASKINTS;
+  return mem_.WriteWords(DHCSR, &value, 1);
+}
+
+uint8_t FlashLoader::Wait(uint32_t& result)
+{
+  const auto start = static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds());
+  uint32_t status = 0;
+
+  while (true)
+  {
+    uint8_t ack = mem_.ReadWords(DHCSR, &status, 1);
+    if (ack != DAP_TRANSFER_OK)
+    {
+      return ack;
+    }
+    if (status & S_HALT)
+    {
+      return ReadCoreReg(REG_R0, result);
+    }
+    if (static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds()) - start >
+        kFlashTimeoutMs)
+    {
+      Halt();
+      return DAP_TRANSFER_ERROR;
+    }
+  }
+}
+
+uint8_t FlashLoader::Call(uint32_t pc, uint32_t r0, uint32_t r1, uint32_t r2,
+                          uint32_t& result)
+{
+  uint8_t ack = Start(pc, r0, r1, r2);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+  return Wait(result);
+}
+
+uint8_t FlashLoader::WaitPending(uint32_t& result)
+{
+  result = 0;
+  if (!running_)
+  {
+    return DAP_TRANSFER_OK;
+  }
+  running_ = false;
+  return Wait(result);
+}
+
+uint8_t FlashLoader::Init(uint32_t addr, uint32_t clk, uint32_t fnc, uint32_t& result)
+{
+  if (!Configured())
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  uint8_t ack = WaitPending(result);
+  fill_ = 0;
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+  return Call(layout_.pc_init, addr, clk, fnc, result);
+}
+
+uint8_t FlashLoader::EraseSector(uint32_t addr, uint32_t& result)
+{
+  uint8_t ack = WaitPending(result);
+  if (ack != DAP_TRANSFER_OK || result != 0)
+  {
+    return ack;
+  }
+  return Call(layout_.pc_erase_sector, addr, 0, 0, result);
+}
+
+uint8_t FlashLoader::PageData(uint32_t offset, const uint8_t* data, uint32_t len)
+{
+  if (!Configured() || offset + len > layout_.page_size)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+  return mem_.Write(layout_.buffer[fill_] + offset, data, len);
+}
+
+uint8_t FlashLoader::ProgramPage(uint32_t addr, uint32_t size, uint32_t& prev_result)
+{
+  if (!Configured() || size > layout_.page_size)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  uint8_t ack = WaitPending(prev_result);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+
+  ack = Start(layout_.pc_program_page, addr, size, layout_.buffer[fill_]);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+  running_ = true;
+
+  if (layout_.buffer[1] != 0)
+  {
+    fill_ ^= 1U;
+    return DAP_TRANSFER_OK;
+  }
+
+  // Single buffer: the page must finish before the host may refill it
+  uint32_t result = 0;
+  ack = WaitPending(result);
+  if (prev_result == 0)
+  {
+    prev_result = result;
+  }
+  return ack;
+}
+
+uint8_t FlashLoader::Finish(uint32_t fnc, uint32_t& result)
+{
+  uint8_t ack = WaitPending(result);
+  fill_ = 0;
+  if (ack != DAP_TRANSFER_OK || result != 0)
+  {
+    return ack;
+  }
+  return Call(layout_.pc_uninit, fnc, 0, 0, result);
+}
+
+}  // namespace DAP
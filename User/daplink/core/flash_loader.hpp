@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mem_ap.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class FlashLoader
+ * @brief Runs a CMSIS-Pack (FLM) style flash algorithm on a Cortex-M target.
+ *
+ * The host downloads the position-independent algorithm into target RAM once,
+ * then streams page data. Each ProgramPage call is started on one RAM buffer
+ * while the host fills the other, and completion is polled on the probe through
+ * DHCSR. The result of a page is therefore reported with the next page (or
+ * Finish). Results use the DAP transfer response bits.
+ */
+class FlashLoader
+{
+ public:
+  struct Layout
+  {
+    uint32_t load_addr = 0;  // Algorithm base, first halfword is a BKPT
+    uint32_t pc_init = 0;
+    uint32_t pc_uninit = 0;
+    uint32_t pc_erase_sector = 0;
+    uint32_t pc_program_page = 0;
+    uint32_t static_base = 0;
+    uint32_t stack_top = 0;
+    uint32_t buffer[2] = {};  // buffer[1] == 0 disables double buffering
+    uint32_t page_size = 0;
+  };
+
+  explicit FlashLoader(MemAp& mem);
+
+  void Configure(const Layout& layout);
+  bool Configured() const { return layout_.load_addr != 0 && layout_.page_size != 0; }
+
+  /**
+   * @brief Write part of the algorithm image
+   * @param offset Offset from the load address
+   * @param data Image bytes
+   * @param len Number of bytes
+   * @return DAP transfer response bits
+   */
+  uint8_t LoadAlgo(uint32_t offset, const uint8_t* data, uint32_t len);
+
+  /**
+   * @brief Halt the core and call Init(addr, clk, fnc)
+   * @param result Function return value
+   * @return DAP transfer response bits
+   */
+  uint8_t Init(uint32_t addr, uint32_t clk, uint32_t fnc, uint32_t& result);
+
+  /**
+   * @brief Call EraseSector(addr) and wait for it
+   * @param result Function return value
+   * @return DAP transfer response bits
+   */
+  uint8_t EraseSector(uint32_t addr, uint32_t& result);
+
+  /**
+   * @brief Write page data into the buffer currently being filled
+   * @param offset Offset within the page
+   * @param data Page bytes
+   * @param len Number of bytes
+   * @return DAP transfer response bits
+   */
+  uint8_t PageData(uint32_t offset, const uint8_t* data, uint32_t len);
+
+  /**
+   * @brief Start ProgramPage(addr, size, fill buffer) and swap buffers
+   * @param prev_result Return value of the previously started page (0 if none)
+   * @return DAP transfer response bits
+   */
+  uint8_t ProgramPage(uint32_t addr, uint32_t size, uint32_t& prev_result);
+
+  /**
+   * @brief Wait for the last page and call UnInit(fnc)
+   * @param result Last page result if it failed, otherwise UnInit return value
+   * @return DAP transfer response bits
+   */
+  uint8_t Finish(uint32_t fnc, uint32_t& result);
+
+ private:
+  uint8_t Halt();
+  uint8_t WriteCoreReg(uint8_t reg, uint32_t value);
+  uint8_t ReadCoreReg(uint8_t reg, uint32_t& value);
+  uint8_t Start(uint32_t pc, uint32_t r0, uint32_t r1, uint32_t r2);
+  uint8_t Wait(uint32_t& result);
+  uint8_t Call(uint32_t pc, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t& result);
+  uint8_t WaitPending(uint32_t& result);
+
+  MemAp& mem_;
+  Layout layout_;
+
+  uint8_t fill_ = 0;     // Buffer receiving PageData
+  bool running_ = false; // ProgramPage in flight
+};
+
+}  // namespace DAP
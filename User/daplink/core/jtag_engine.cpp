@@ -0,0 +1,200 @@
+#include "jtag_engine.hpp"
+
+namespace DAP
+{
+
+JtagEngine::JtagEngine(DapIo& io) : io_(io) {}
+
+LibXR::ErrorCode JtagEngine::Setup()
+{
+  if (!Available())
+  {
+    return LibXR::ErrorCode::NOT_SUPPORT;
+  }
+
+  const LibXR::GPIO::Configuration output = {LibXR::GPIO::Direction::OUTPUT_PUSH_PULL,
+                                             LibXR::GPIO::Pull::NONE};
+  LibXR::ErrorCode err = io_.gpio_swclk->SetConfig(output);
+  if (err == LibXR::ErrorCode::OK)
+  {
+    err = io_.gpio_tdi->SetConfig(output);
+  }
+  if (err == LibXR::ErrorCode::OK)
+  {
+    err = io_.gpio_swdio.SetConfig(output);  // TMS
+  }
+  if (err == LibXR::ErrorCode::OK)
+  {
+    err = io_.gpio_tdo.SetConfig({LibXR::GPIO::Direction::INPUT, LibXR::GPIO::Pull::UP});
+  }
+  if (err != LibXR::ErrorCode::OK)
+  {
+    return err;
+  }
+
+  io_.gpio_swclk->Write(false);
+  io_.gpio_tdi->Write(true);
+  ResetTap();
+  return LibXR::ErrorCode::OK;
+}
+
+void JtagEngine::Release()
+{
+  const LibXR::GPIO::Configuration input = {LibXR::GPIO::Direction::INPUT,
+                                            LibXR::GPIO::Pull::NONE};
+  if (io_.gpio_swclk != nullptr)
+  {
+    io_.gpio_swclk->SetConfig(input);
+  }
+  if (io_.gpio_tdi != nullptr)
+  {
+    io_.gpio_tdi->SetConfig(input);
+  }
+}
+
+bool JtagEngine::Configure(uint8_t count, const uint8_t* ir_lengths)
+{
+  if (count == 0 || count > kJtagMaxDevices)
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (ir_lengths[i] == 0 || ir_lengths[i] > 32)
+    {
+      return false;
+    }
+    ir_length_[i] = ir_lengths[i];
+  }
+  count_ = count;
+  return Select(0);
+}
+
+bool JtagEngine::Select(uint8_t index)
+{
+  if (index >= count_)
+  {
+    return false;
+  }
+
+  index_ = index;
+  ir_before_ = ir_after_ = 0;
+  for (uint8_t i = 0; i < count_; i++)
+  {
+    if (i < index)
+    {
+      ir_before_ += ir_length_[i];
+    }
+    else if (i > index)
+    {
+      ir_after_ += ir_length_[i];
+    }
+  }
+  return true;
+}
+
+bool JtagEngine::Clock(bool tms, bool tdi)
+{
+  // Target samples TMS/TDI on the rising edge and updates TDO on the falling edge
+  io_.gpio_swdio.Write(tms);
+  io_.gpio_tdi->Write(tdi);
+  const bool tdo = io_.gpio_tdo.Read();
+  io_.gpio_swclk->Write(true);
+  io_.gpio_swclk->Write(false);
+  return tdo;
+}
+
+void JtagEngine::Tms(uint32_t bits, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    Clock((bits >> i) & 1U, true);
+  }
+}
+
+void JtagEngine::Sequence(uint32_t count, bool tms, const uint8_t* tdi, uint8_t* tdo)
+{
+  for (uint32_t i = 0; i < count; i++)
+  {
+    const uint8_t mask = static_cast<uint8_t>(1U << (i & 7U));
+    const bool bit = Clock(tms, (tdi[i >> 3] & mask) != 0);
+    if (tdo != nullptr)
+    {
+      if ((i & 7U) == 0)
+      {
+        tdo[i >> 3] = 0;
+      }
+      if (bit)
+      {
+        tdo[i >> 3] |= mask;
+      }
+    }
+  }
+}
+
+void JtagEngine::ResetTap()
+{
+  Tms(0x1F, 6);  // Five TMS high reach Test-Logic-Reset, then Run-Test/Idle
+}
+
+void JtagEngine::Idle(uint32_t cycles)
+{
+  for (uint32_t i = 0; i < cycles; i++)
+  {
+    Clock(false, true);
+  }
+}
+
+void JtagEngine::ShiftIr(uint32_t ir)
+{
+  Tms(0x3, 4);  // Select-DR, Select-IR, Capture-IR, Shift-IR
+
+  const uint8_t len = ir_length_[index_];
+  for (uint16_t i = 0; i < ir_before_; i++)
+  {
+    Clock(false, true);
+  }
+  for (uint8_t i = 0; i < len; i++)
+  {
+    const bool last = (i + 1 == len) && ir_after_ == 0;
+    Clock(last, (ir >> i) & 1U);
+  }
+  for (uint16_t i = 0; i < ir_after_; i++)
+  {
+    Clock(i + 1 == ir_after_, true);
+  }
+
+  Tms(0x1, 2);  // Update-IR, Run-Test/Idle
+}
+
+uint64_t JtagEngine::ShiftDr(uint64_t out, uint8_t len)
+{
+  Tms(0x1, 3);  // Select-DR, Capture-DR, Shift-DR
+
+  // Devices in BYPASS contribute one bit each
+  const uint8_t after = static_cast<uint8_t>(count_ - index_ - 1);
+  for (uint8_t i = 0; i < index_; i++)
+  {
+    Clock(false, true);
+  }
+
+  uint64_t in = 0;
+  for (uint8_t i = 0; i < len; i++)
+  {
+    const bool last = (i + 1 == len) && after == 0;
+    if (Clock(last, (out >> i) & 1U))
+    {
+      in |= (1ULL << i);
+    }
+  }
+  for (uint8_t i = 0; i < after; i++)
+  {
+    Clock(i + 1 == after, true);
+  }
+
+  Tms(0x1, 2);  // Update-DR, Run-Test/Idle
+  return in;
+}
+
+}  // namespace DAP
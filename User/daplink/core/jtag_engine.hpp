@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dap_config.hpp"
+#include "dap_io.hpp"
+#include "libxr.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class JtagEngine
+ * @brief Bit-banged JTAG wire layer with scan chain bookkeeping.
+ *
+ * IR and DR scans start and end in Run-Test/Idle. Devices other than the
+ * selected one are kept in BYPASS, following the CMSIS-DAP chain model:
+ * device 0 is the one closest to TDO. Until DAP_JTAG_Configure describes the
+ * chain it is assumed to hold a single RISC-V DTM (IR length 5).
+ */
+class JtagEngine
+{
+ public:
+  explicit JtagEngine(DapIo& io);
+
+  /**
+   * @brief Whether TCK and TDI are routed to GPIOs on this board
+   */
+  bool Available() const { return io_.gpio_swclk != nullptr && io_.gpio_tdi != nullptr; }
+
+  /**
+   * @brief Drive the JTAG pins and move the TAP to Run-Test/Idle
+   * @return ErrorCode indicating operation status
+   */
+  LibXR::ErrorCode Setup();
+
+  /**
+   * @brief Release TCK and TDI
+   */
+  void Release();
+
+  /**
+   * @brief Describe the scan chain
+   * @param count Number of devices
+   * @param ir_lengths IR length of each device, device 0 first
+   * @return false if the chain does not fit
+   */
+  bool Configure(uint8_t count, const uint8_t* ir_lengths);
+
+  /**
+   * @brief Select the device addressed by ShiftIr/ShiftDr
+   * @return false if index is outside the chain
+   */
+  bool Select(uint8_t index);
+
+  uint8_t IrLength() const { return ir_length_[index_]; }
+
+  /**
+   * @brief Clock a sequence with constant TMS, LSB first
+   * @param count Number of TCK cycles
+   * @param tms TMS value
+   * @param tdi TDI bits
+   * @param tdo Captured TDO bits (may be nullptr)
+   */
+  void Sequence(uint32_t count, bool tms, const uint8_t* tdi, uint8_t* tdo);
+
+  /**
+   * @brief Force Test-Logic-Reset and move to Run-Test/Idle
+   */
+  void ResetTap();
+
+  /**
+   * @brief Stay in Run-Test/Idle for a number of cycles
+   */
+  void Idle(uint32_t cycles);
+
+  /**
+   * @brief Load an instruction into the selected device, others get BYPASS
+   * @param ir Instruction, LSB first
+   */
+  void ShiftIr(uint32_t ir);
+
+  /**
+   * @brief Exchange a data register of the selected device
+   * @param out Bits shifted in, LSB first
+   * @param len Register length (1..64)
+   * @return Captured register value
+   */
+  uint64_t ShiftDr(uint64_t out, uint8_t len);
+
+ private:
+  bool Clock(bool tms, bool tdi);
+  void Tms(uint32_t bits, uint8_t count);
+
+  DapIo& io_;
+
+  uint8_t count_ = 1;
+  uint8_t index_ = 0;
+  uint8_t ir_length_[kJtagMaxDevices] = {5};
+  uint16_t ir_before_ = 0;  // IR bits between the selected device and TDO
+  uint16_t ir_after_ = 0;   // IR bits between TDI and the selected device
+};
+
+}  // namespace DAP
@@ -0,0 +1,289 @@
+#include "mem_ap.hpp"
+
+#include <cstring>
+
+namespace DAP
+{
+
+namespace
+{
+
+constexpr uint8_t kDrwRead = DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_DRW;
+constexpr uint8_t kDrwWrite = DAP_TRANSFER_APnDP | AP_DRW;
+constexpr uint32_t kChunkWords = 16;
+
+inline uint32_t WordsToWrap(uint32_t addr)
+{
+  return (kTarWrapSize - (addr & (kTarWrapSize - 1))) >> 2;
+}
+
+}  // namespace
+
+MemAp::MemAp(TransferEngine& transfer) : transfer_(transfer) {}
+
+uint8_t MemAp::SetCsw(uint32_t size)
+{
+  uint8_t ack = transfer_.Select(static_cast<uint32_t>(apsel_) << 24);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+
+  const uint32_t csw = CSW_DEFAULT | size;
+  if (csw_valid_ && csw_ == csw)
+  {
+    return DAP_TRANSFER_OK;
+  }
+
+  ack = transfer_.WriteAp(AP_CSW, csw);
+  csw_ = csw;
+  csw_valid_ = (ack == DAP_TRANSFER_OK);
+  return ack;
+}
+
+uint8_t MemAp::SetTar(uint32_t addr) { return transfer_.WriteAp(AP_TAR, addr); }
+
+uint8_t MemAp::ReadWords(uint32_t addr, uint32_t* data, uint32_t count)
+{
+  ForgetCsw();
+  return ReadWordsImpl(addr, data, count);
+}
+
+uint8_t MemAp::WriteWords(uint32_t addr, const uint32_t* data, uint32_t count)
+{
+  ForgetCsw();
+  return WriteWordsImpl(addr, data, count);
+}
+
+uint8_t MemAp::ReadWordsImpl(uint32_t addr, uint32_t* data, uint32_t count)
+{
+  uint8_t ack = SetCsw(CSW_SIZE_32);
+
+  while (ack == DAP_TRANSFER_OK && count > 0)
+  {
+    const uint32_t wrap = WordsToWrap(addr);
+    const uint32_t n = (count < wrap) ? count : wrap;
+    uint32_t done = 0;
+
+    ack = SetTar(addr);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      ack = transfer_.ReadBlock(kDrwRead, data, n, done);
+    }
+    if (ack == DAP_TRANSFER_OK && done != n)
+    {
+      ack = DAP_TRANSFER_ERROR;  // Aborted
+    }
+
+    addr += n << 2;
+    data += n;
+    count -= n;
+  }
+
+  return ack;
+}
+
+uint8_t MemAp::WriteWordsImpl(uint32_t addr, const uint32_t* data, uint32_t count)
+{
+  uint8_t ack = SetCsw(CSW_SIZE_32);
+
+  while (ack == DAP_TRANSFER_OK && count > 0)
+  {
+    const uint32_t wrap = WordsToWrap(addr);
+    const uint32_t n = (count < wrap) ? count : wrap;
+    uint32_t done = 0;
+
+    ack = SetTar(addr);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      ack = transfer_.WriteBlock(kDrwWrite, data, n, done);
+    }
+    if (ack == DAP_TRANSFER_OK && done != n)
+    {
+      ack = DAP_TRANSFER_ERROR;  // Aborted
+    }
+
+    addr += n << 2;
+    data += n;
+    count -= n;
+  }
+
+  return ack;
+}
+
+uint8_t MemAp::ReadLane(uint32_t addr, uint32_t size, uint32_t& value)
+{
+  uint8_t ack = SetCsw(size);
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = SetTar(addr);
+  }
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = transfer_.ReadAp(AP_DRW, value);
+  }
+  value >>= (addr & 3U) * 8;  // Narrow data arrives on its address lane
+  return ack;
+}
+
+uint8_t MemAp::WriteLane(uint32_t addr, uint32_t size, uint32_t value)
+{
+  uint8_t ack = SetCsw(size);
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = SetTar(addr);
+  }
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = transfer_.WriteAp(AP_DRW, value << ((addr & 3U) * 8));
+  }
+  if (ack == DAP_TRANSFER_OK)
+  {
+    // Posted like a block write: a bus error only shows on the next access
+    uint32_t dummy = 0;
+    ack = transfer_.ReadDp(DP_RDBUFF, dummy);
+  }
+  return ack;
+}
+
+uint8_t MemAp::Read(uint32_t addr, uint8_t* data, uint32_t len)
+{
+  uint32_t words[kChunkWords];
+  ForgetCsw();
+
+  while (len > 0)
+  {
+    uint8_t ack = DAP_TRANSFER_OK;
+    uint32_t n = 0;
+
+    if ((addr & 3U) == 0 && len >= 4)
+    {
+      uint32_t n_words = len >> 2;
+      n_words = (n_words > kChunkWords) ? kChunkWords : n_words;
+      ack = ReadWordsImpl(addr, words, n_words);
+      n = n_words << 2;
+      std::memcpy(data, words, n);
+    }
+    else
+    {
+      // Unaligned head/tail: byte or halfword lane, never touching neighbours
+      const bool half = (addr & 1U) == 0 && len >= 2;
+      uint32_t value = 0;
+      ack = ReadLane(addr, half ? CSW_SIZE_16 : CSW_SIZE_8, value);
+      n = half ? 2 : 1;
+      data[0] = static_cast<uint8_t>(value);
+      if (half)
+      {
+        data[1] = static_cast<uint8_t>(value >> 8);
+      }
+    }
+
+    if (ack != DAP_TRANSFER_OK)
+    {
+      return ack;
+    }
+
+    addr += n;
+    data += n;
+    len -= n;
+  }
+
+  return DAP_TRANSFER_OK;
+}
+
+uint8_t MemAp::Write(uint32_t addr, const uint8_t* data, uint32_t len)
+{
+  uint32_t words[kChunkWords];
+  ForgetCsw();
+
+  while (len > 0)
+  {
+    uint8_t ack = DAP_TRANSFER_OK;
+    uint32_t n = 0;
+
+    if ((addr & 3U) == 0 && len >= 4)
+    {
+      uint32_t n_words = len >> 2;
+      n_words = (n_words > kChunkWords) ? kChunkWords : n_words;
+      n = n_words << 2;
+      std::memcpy(words, data, n);
+      ack = WriteWordsImpl(addr, words, n_words);
+    }
+    else
+    {
+      const bool half = (addr & 1U) == 0 && len >= 2;
+      uint32_t value = data[0];
+      if (half)
+      {
+        value |= static_cast<uint32_t>(data[1]) << 8;
+      }
+      ack = WriteLane(addr, half ? CSW_SIZE_16 : CSW_SIZE_8, value);
+      n = half ? 2 : 1;
+    }
+
+    if (ack != DAP_TRANSFER_OK)
+    {
+      return ack;
+    }
+
+    addr += n;
+    data += n;
+    len -= n;
+  }
+
+  return DAP_TRANSFER_OK;
+}
+
+uint8_t MemAp::SaveContext()
+{
+  // An unknown SELECT (e.g. after a line reset) has nothing worth restoring
+  select_saved_ = transfer_.SelectValid();
+  saved_select_ = transfer_.GetSelect();
+  context_saved_ = false;
+  csw_valid_ = false;
+
+  uint8_t ack = transfer_.Select(static_cast<uint32_t>(apsel_) << 24);
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = transfer_.ReadAp(AP_CSW, saved_csw_);
+  }
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = transfer_.ReadAp(AP_TAR, saved_tar_);
+  }
+
+  context_saved_ = (ack == DAP_TRANSFER_OK);
+  csw_ = saved_csw_;
+  csw_valid_ = context_saved_;
+  return ack;
+}
+
+uint8_t MemAp::RestoreContext()
+{
+  uint8_t ack = DAP_TRANSFER_OK;
+
+  if (context_saved_)
+  {
+    ack = transfer_.Select(static_cast<uint32_t>(apsel_) << 24);
+    if (ack == DAP_TRANSFER_OK && !(csw_valid_ && csw_ == saved_csw_))
+    {
+      ack = transfer_.WriteAp(AP_CSW, saved_csw_);
+    }
+    if (ack == DAP_TRANSFER_OK)
+    {
+      ack = transfer_.WriteAp(AP_TAR, saved_tar_);
+    }
+    context_saved_ = false;
+  }
+  csw_valid_ = false;
+
+  if (ack == DAP_TRANSFER_OK && select_saved_)
+  {
+    ack = transfer_.Select(saved_select_);
+  }
+  select_saved_ = false;
+
+  return ack;
+}
+
+}  // namespace DAP
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+
+#include "transfer_engine.hpp"
+
+namespace DAP
+{
+
+// MEM-AP CSW fields (ADIv5.2, C2.6.4)
+constexpr uint32_t CSW_SIZE_8 = 0x00000000;
+constexpr uint32_t CSW_SIZE_16 = 0x00000001;
+constexpr uint32_t CSW_SIZE_32 = 0x00000002;
+constexpr uint32_t CSW_SIZE_MASK = 0x00000007;
+constexpr uint32_t CSW_ADDRINC_SINGLE = 0x00000010;
+constexpr uint32_t CSW_DEVICE_EN = 0x00000040;
+constexpr uint32_t CSW_HPROT_PRIV = 0x02000000;
+constexpr uint32_t CSW_MSTRDBG = 0x20000000;
+constexpr uint32_t CSW_RESERVED = 0x01000000;
+constexpr uint32_t CSW_DEFAULT =
+    CSW_RESERVED | CSW_MSTRDBG | CSW_HPROT_PRIV | CSW_DEVICE_EN | CSW_ADDRINC_SINGLE;
+
+// TAR auto-increment is only guaranteed within a 1 KB block
+constexpr uint32_t kTarWrapSize = 1024;
+
+/**
+ * @class MemAp
+ * @brief Target memory access through a MEM-AP.
+ *
+ * Splits accesses at TAR auto-increment boundaries and streams them through the
+ * transfer engine block paths. Results use the DAP transfer response bits.
+ */
+class MemAp
+{
+ public:
+  explicit MemAp(TransferEngine& transfer);
+
+  void SetApSel(uint8_t apsel)
+  {
+    apsel_ = apsel;
+    csw_valid_ = false;
+  }
+  uint8_t GetApSel() const { return apsel_; }
+
+  /**
+   * @brief Read 32-bit words
+   * @param addr Word-aligned target address
+   * @param data Destination
+   * @param count Number of words
+   * @return DAP transfer response bits
+   */
+  uint8_t ReadWords(uint32_t addr, uint32_t* data, uint32_t count);
+
+  /**
+   * @brief Write 32-bit words
+   * @param addr Word-aligned target address
+   * @param data Source
+   * @param count Number of words
+   * @return DAP transfer response bits
+   */
+  uint8_t WriteWords(uint32_t addr, const uint32_t* data, uint32_t count);
+
+  /**
+   * @brief Read bytes at any alignment, unaligned ends through byte/halfword lanes
+   * @param addr Target address
+   * @param data Destination
+   * @param len Number of bytes
+   * @return DAP transfer response bits
+   */
+  uint8_t Read(uint32_t addr, uint8_t* data, uint32_t len);
+
+  /**
+   * @brief Write bytes at any alignment, unaligned ends through byte/halfword lanes
+   * @param addr Target address
+   * @param data Source
+   * @param len Number of bytes
+   * @return DAP transfer response bits
+   */
+  uint8_t Write(uint32_t addr, const uint8_t* data, uint32_t len);
+
+  /**
+   * @brief Save SELECT, CSW and TAR before a probe-initiated access
+   *
+   * Background users (e.g. RTT polling) run between host commands; the host
+   * caches these registers, so they are put back by RestoreContext(). SELECT is
+   * only put back when the transfer engine knew its value. Until then no host
+   * command can intervene, so the CSW shadow spans all accesses in between.
+   * @return DAP transfer response bits
+   */
+  uint8_t SaveContext();
+  uint8_t RestoreContext();
+
+ private:
+  /**
+   * @brief Select the AP and write CSW unless the shadow already holds it
+   * @param size CSW_SIZE_* access size
+   * @return DAP transfer response bits
+   */
+  uint8_t SetCsw(uint32_t size);
+
+  /**
+   * @brief Drop the CSW shadow at the start of a public access, unless a saved
+   *        context keeps the host away from the AP
+   */
+  void ForgetCsw()
+  {
+    if (!context_saved_)
+    {
+      csw_valid_ = false;
+    }
+  }
+
+  uint8_t ReadWordsImpl(uint32_t addr, uint32_t* data, uint32_t count);
+  uint8_t WriteWordsImpl(uint32_t addr, const uint32_t* data, uint32_t count);
+  uint8_t SetTar(uint32_t addr);
+  uint8_t ReadLane(uint32_t addr, uint32_t size, uint32_t& value);
+  uint8_t WriteLane(uint32_t addr, uint32_t size, uint32_t value);
+
+  TransferEngine& transfer_;
+  uint8_t apsel_ = 0;
+
+  uint32_t csw_ = 0;
+  bool csw_valid_ = false;
+  uint32_t saved_select_ = 0;
+  uint32_t saved_csw_ = 0;
+  uint32_t saved_tar_ = 0;
+  bool select_saved_ = false;
+  bool context_saved_ = false;
+};
+
+}  // namespace DAP
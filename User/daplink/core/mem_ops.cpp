@@ -0,0 +1,236 @@
+#include "mem_ops.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+constexpr uint32_t kChunkWords = 64;
+
+inline bool WordAligned(uint32_t addr, uint32_t size)
+{
+  return ((addr | size) & 3U) == 0;
+}
+
+}  // namespace
+
+MemOps::MemOps(MemAp& mem, CrcUnit& crc) : mem_(mem), crc_(crc) {}
+
+uint8_t MemOps::Crc32(uint32_t addr, uint32_t size, uint32_t& value)
+{
+  if (!WordAligned(addr, size))
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  uint32_t words[kChunkWords];
+  uint32_t count = size >> 2;
+
+  crc_.Reset();
+  uint8_t ack = mem_.SaveContext();
+
+  while (ack == DAP_TRANSFER_OK && count > 0)
+  {
+    const uint32_t n = (count < kChunkWords) ? count : kChunkWords;
+    ack = mem_.ReadWords(addr, words, n);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      crc_.Feed(words, n);
+    }
+
+    addr += n << 2;
+    count -= n;
+  }
+
+  value = crc_.Value();
+
+  const uint8_t restore = mem_.RestoreContext();
+  return (ack == DAP_TRANSFER_OK) ? restore : ack;
+}
+
+template <typename Pattern>
+uint8_t MemOps::WritePattern(uint32_t addr, uint32_t count, Pattern pattern)
+{
+  uint32_t words[kChunkWords];
+  uint8_t ack = DAP_TRANSFER_OK;
+
+  for (uint32_t index = 0; ack == DAP_TRANSFER_OK && index < count;)
+  {
+    const uint32_t left = count - index;
+    const uint32_t n = (left < kChunkWords) ? left : kChunkWords;
+    for (uint32_t i = 0; i < n; i++)
+    {
+      words[i] = pattern(index + i);
+    }
+
+    ack = mem_.WriteWords(addr + (index << 2), words, n);
+    index += n;
+  }
+
+  return ack;
+}
+
+template <typename Pattern>
+uint8_t MemOps::VerifyPattern(uint32_t addr, uint32_t count, Pattern pattern,
+                              uint32_t& fail_addr)
+{
+  uint32_t words[kChunkWords];
+  uint8_t ack = DAP_TRANSFER_OK;
+
+  for (uint32_t index = 0; ack == DAP_TRANSFER_OK && index < count;)
+  {
+    const uint32_t left = count - index;
+    const uint32_t n = (left < kChunkWords) ? left : kChunkWords;
+    ack = mem_.ReadWords(addr + (index << 2), words, n);
+
+    for (uint32_t i = 0; ack == DAP_TRANSFER_OK && i < n; i++)
+    {
+      if (words[i] != pattern(index + i))
+      {
+        fail_addr = addr + ((index + i) << 2);
+        return DAP_TRANSFER_OK;
+      }
+    }
+    index += n;
+  }
+
+  return ack;
+}
+
+uint8_t MemOps::Fill(uint32_t addr, uint32_t size, uint32_t pattern, uint32_t step)
+{
+  if (!WordAligned(addr, size))
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  uint8_t ack = mem_.SaveContext();
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = WritePattern(addr, size >> 2,
+                       [=](uint32_t i) { return pattern + i * step; });
+  }
+
+  const uint8_t restore = mem_.RestoreContext();
+  return (ack == DAP_TRANSFER_OK) ? restore : ack;
+}
+
+uint8_t MemOps::BlankCheck(uint32_t addr, uint32_t size, uint32_t& fail_addr)
+{
+  fail_addr = kNoFailure;
+  if (!WordAligned(addr, size))
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  uint8_t ack = mem_.SaveContext();
+  if (ack == DAP_TRANSFER_OK)
+  {
+    auto erased = [](uint32_t) -> uint32_t { return 0xFFFFFFFFUL; };
+    ack = VerifyPattern(addr, size >> 2, erased, fail_addr);
+  }
+
+  const uint8_t restore = mem_.RestoreContext();
+  return (ack == DAP_TRANSFER_OK) ? restore : ack;
+}
+
+uint8_t MemOps::RamTest(uint32_t addr, uint32_t size, uint32_t& fail_addr)
+{
+  fail_addr = kNoFailure;
+  if (!WordAligned(addr, size))
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  uint8_t ack = mem_.SaveContext();
+
+  for (uint32_t pass = 0; pass < 32; pass++)
+  {
+    if (ack != DAP_TRANSFER_OK || fail_addr != kNoFailure)
+    {
+      break;
+    }
+
+    auto walking_one = [pass](uint32_t i) -> uint32_t
+    {
+      return 1UL << ((i + pass) & 31U);
+    };
+    ack = WritePattern(addr, size >> 2, walking_one);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      ack = VerifyPattern(addr, size >> 2, walking_one, fail_addr);
+    }
+  }
+
+  // Walking ones repeat every 32 words, so an aliased address line above that
+  // goes unseen; a word holding its own address catches any of them
+  if (ack == DAP_TRANSFER_OK && fail_addr == kNoFailure)
+  {
+    auto own_address = [addr](uint32_t i) -> uint32_t { return addr + (i << 2); };
+    ack = WritePattern(addr, size >> 2, own_address);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      ack = VerifyPattern(addr, size >> 2, own_address, fail_addr);
+    }
+  }
+
+  const uint8_t restore = mem_.RestoreContext();
+  return (ack == DAP_TRANSFER_OK) ? restore : ack;
+}
+
+uint8_t MemOps::Search(uint32_t addr, uint32_t size, const uint8_t* pattern,
+                       const uint8_t* mask, uint32_t len, uint32_t* matches,
+                       uint32_t max_matches, uint32_t& count)
+{
+  count = 0;
+  if (len == 0 || len > kMaxPatternSize)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+  if (size < len)
+  {
+    return DAP_TRANSFER_OK;
+  }
+
+  uint32_t words[kChunkWords];
+  const auto* bytes = reinterpret_cast<const uint8_t*>(words);
+  uint32_t remaining = size - len + 1;  // Candidates left to examine
+  uint32_t next = addr;                 // First candidate not yet examined
+
+  uint8_t ack = mem_.SaveContext();
+
+  while (ack == DAP_TRANSFER_OK && remaining > 0 && count < max_matches)
+  {
+    // Windows overlap by the pattern tail; a window always holds a candidate
+    const uint32_t base = next & ~3U;
+    const uint64_t needed = static_cast<uint64_t>(next - base) + remaining - 1 + len;
+    const uint32_t n_words = (needed + 3 < kChunkWords * 4U)
+                                 ? static_cast<uint32_t>((needed + 3) >> 2)
+                                 : kChunkWords;
+
+    ack = mem_.ReadWords(base, words, n_words);
+
+    uint32_t offset = next - base;
+    for (; ack == DAP_TRANSFER_OK && offset + len <= (n_words << 2) && remaining > 0 &&
+           count < max_matches;
+         offset++, remaining--)
+    {
+      uint32_t i = 0;
+      while (i < len && ((bytes[offset + i] ^ pattern[i]) & mask[i]) == 0)
+      {
+        i++;
+      }
+      if (i == len)
+      {
+        matches[count++] = base + offset;
+      }
+    }
+    next = base + offset;
+  }
+
+  const uint8_t restore = mem_.RestoreContext();
+  return (ack == DAP_TRANSFER_OK) ? restore : ack;
+}
+
+}  // namespace DAP
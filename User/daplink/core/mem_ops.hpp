@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+#include "crc_unit.hpp"
+#include "mem_ap.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class MemOps
+ * @brief Bulk target memory operations evaluated on the probe.
+ *
+ * Each operation streams the target range through the MEM-AP block path and
+ * reduces it locally, so only the result crosses USB. The host-visible AP
+ * context is saved and restored around every operation. Results use the DAP
+ * transfer response bits.
+ */
+class MemOps
+{
+ public:
+  MemOps(MemAp& mem, CrcUnit& crc);
+
+  /**
+   * @brief CRC-32/MPEG-2 over a target range
+   * @param addr Word-aligned start address
+   * @param size Word-aligned length in bytes
+   * @param value Resulting CRC
+   * @return DAP transfer response bits
+   */
+  uint8_t Crc32(uint32_t addr, uint32_t size, uint32_t& value);
+
+  /**
+   * @brief Fill a target range with pattern + index * step
+   * @param addr Word-aligned start address
+   * @param size Word-aligned length in bytes
+   * @param pattern First word
+   * @param step Increment per word (0 for a constant fill)
+   * @return DAP transfer response bits
+   */
+  uint8_t Fill(uint32_t addr, uint32_t size, uint32_t pattern, uint32_t step);
+
+  /**
+   * @brief Check that a target range reads as all 0xFF
+   * @param addr Word-aligned start address
+   * @param size Word-aligned length in bytes
+   * @param fail_addr First non-blank word, kNoFailure if the range is blank
+   * @return DAP transfer response bits
+   */
+  uint8_t BlankCheck(uint32_t addr, uint32_t size, uint32_t& fail_addr);
+
+  /**
+   * @brief Destructive walking-ones test of a RAM range
+   *
+   * Runs 32 passes; in pass p word i holds 1 << ((i + p) % 32), so every bit
+   * of every word is set once while its neighbours differ. A final pass
+   * stores each word's own address, which exposes aliased address lines that
+   * the 32-word period of the walking ones would hide. Each pass writes the
+   * whole range before reading it back.
+   * @param addr Word-aligned start address
+   * @param size Word-aligned length in bytes
+   * @param fail_addr First failing word, kNoFailure if the test passed
+   * @return DAP transfer response bits
+   */
+  uint8_t RamTest(uint32_t addr, uint32_t size, uint32_t& fail_addr);
+
+  /**
+   * @brief Find a masked byte pattern in a target range
+   *
+   * A candidate at address a matches when
+   * (mem[a + i] ^ pattern[i]) & mask[i] == 0 for every i < len.
+   * @param addr Start address, any alignment
+   * @param size Length of the range in bytes, matches lie entirely inside it
+   * @param pattern Pattern bytes
+   * @param mask Mask bytes, same length as pattern
+   * @param len Pattern length, 1 to kMaxPatternSize
+   * @param matches Match addresses in ascending order
+   * @param max_matches Capacity of matches, the scan stops when it is full
+   * @param count Number of matches found
+   * @return DAP transfer response bits
+   */
+  uint8_t Search(uint32_t addr, uint32_t size, const uint8_t* pattern,
+                 const uint8_t* mask, uint32_t len, uint32_t* matches,
+                 uint32_t max_matches, uint32_t& count);
+
+  static constexpr uint32_t kNoFailure = 0xFFFFFFFFUL;
+  static constexpr uint32_t kMaxPatternSize = 16;
+
+ private:
+  template <typename Pattern>
+  uint8_t WritePattern(uint32_t addr, uint32_t count, Pattern pattern);
+  template <typename Pattern>
+  uint8_t VerifyPattern(uint32_t addr, uint32_t count, Pattern pattern,
+                        uint32_t& fail_addr);
+
+  MemAp& mem_;
+  CrcUnit& crc_;
+};
+
+}  // namespace DAP
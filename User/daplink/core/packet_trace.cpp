@@ -0,0 +1,84 @@
+#include "packet_trace.hpp"
+
+#include "dap_utils.hpp"
+
+namespace DAP
+{
+
+void PacketTrace::Start()
+{
+  ring_head_ = 0;
+  ring_tail_ = 0;
+  overflowed_ = false;
+
+  uint8_t header[kHeaderSize];
+  for (size_t i = 0; i < sizeof(kMagic); i++)
+  {
+    header[i] = kMagic[i];
+  }
+  PutU16(header + 4, kVersion);
+  PutU16(header + 6, kPacketSize);
+  Put(header, sizeof(header));
+
+  enabled_ = true;
+}
+
+void PacketTrace::Record(uint32_t request_us, const uint8_t* request, size_t request_len,
+                         uint32_t response_us, const uint8_t* response,
+                         size_t response_len)
+{
+  if (!enabled_)
+  {
+    return;
+  }
+
+  request_len = (request_len > kPacketSize) ? kPacketSize : request_len;
+  response_len = (response_len > kPacketSize) ? kPacketSize : response_len;
+  while (request_len > 1 && request[request_len - 1] == 0)
+  {
+    request_len--;
+  }
+
+  if (Free() < kRecordHeaderSize + request_len + response_len)
+  {
+    overflowed_ = true;
+    return;
+  }
+
+  uint8_t header[kRecordHeaderSize];
+  PutU32(header, request_us);
+  PutU32(header + 4, response_us);
+  header[8] = static_cast<uint8_t>(request_len);
+  header[9] = static_cast<uint8_t>(response_len);
+  Put(header, sizeof(header));
+  Put(request, request_len);
+  Put(response, response_len);
+}
+
+size_t PacketTrace::Read(uint8_t* data, size_t max_len)
+{
+  size_t n = 0;
+  while (n < max_len && ring_tail_ != ring_head_)
+  {
+    data[n++] = ring_[ring_tail_];
+    ring_tail_ = (ring_tail_ + 1) % kTraceRingSize;
+  }
+  return n;
+}
+
+size_t PacketTrace::Free() const
+{
+  // One slot stays empty to tell a full ring from an empty one
+  return (ring_tail_ + kTraceRingSize - ring_head_ - 1) % kTraceRingSize;
+}
+
+void PacketTrace::Put(const uint8_t* data, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    ring_[ring_head_] = data[i];
+    ring_head_ = (ring_head_ + 1) % kTraceRingSize;
+  }
+}
+
+}  // namespace DAP
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "dap_config.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class PacketTrace
+ * @brief Capture buffer for DAP request/response pairs.
+ *
+ * The USB class layer records every packet it executes while the trace is
+ * running; the host drains the encoded stream with TRACE_Control. Records that
+ * do not fit are dropped whole, so the stream always stays parseable.
+ *
+ * Stream format, little-endian:
+ *   Header: "PDTR" [Version(2)] [PacketSize(2)]
+ *   Record: [RequestUs(4)] [ResponseUs(4)] [RequestLen] [ResponseLen]
+ *           [Request(RequestLen)] [Response(ResponseLen)]
+ *
+ * RequestUs is the time the report arrived, ResponseUs the time the response
+ * was handed to the IN endpoint, both from the probe's microsecond timebase.
+ * Trailing zero bytes of the request are not stored; requests are replayed
+ * from a zeroed packet buffer.
+ */
+class PacketTrace
+{
+ public:
+  static constexpr uint8_t kMagic[4] = {'P', 'D', 'T', 'R'};
+  static constexpr uint16_t kVersion = 1;
+  static constexpr size_t kHeaderSize = 8;
+  static constexpr size_t kRecordHeaderSize = 10;
+  static_assert(kPacketSize <= 255, "RequestLen/ResponseLen are single bytes");
+
+  /**
+   * @brief Clear the buffer, queue the stream header and start recording
+   */
+  void Start();
+
+  void Stop() { enabled_ = false; }
+  bool Enabled() const { return enabled_; }
+
+  /**
+   * @brief Whether records were dropped since Start() for lack of space
+   */
+  bool Overflowed() const { return overflowed_; }
+
+  /**
+   * @brief Append one request/response pair if recording
+   * @param request_us Arrival time of the request
+   * @param request Request packet
+   * @param request_len Request length, trailing zeros are trimmed
+   * @param response_us Completion time of the response
+   * @param response Response packet
+   * @param response_len Response length
+   */
+  void Record(uint32_t request_us, const uint8_t* request, size_t request_len,
+              uint32_t response_us, const uint8_t* response, size_t response_len);
+
+  /**
+   * @brief Drain encoded stream bytes
+   * @param data Destination
+   * @param max_len Maximum bytes to copy
+   * @return Bytes copied
+   */
+  size_t Read(uint8_t* data, size_t max_len);
+
+ private:
+  static_assert(kTraceRingSize > kHeaderSize + kRecordHeaderSize + 2 * kPacketSize,
+                "Trace ring cannot hold a full record");
+
+  size_t Free() const;
+  void Put(const uint8_t* data, size_t len);
+
+  bool enabled_ = false;
+  bool overflowed_ = false;
+
+  uint8_t ring_[kTraceRingSize] = {};
+  size_t ring_head_ = 0;
+  size_t ring_tail_ = 0;
+};
+
+}  // namespace DAP
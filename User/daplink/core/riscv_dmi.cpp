@@ -0,0 +1,255 @@
+#include "riscv_dmi.hpp"
+
+#include "dap_constants.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+// JTAG DTM instructions and fields (Debug Spec 0.13, 6.1)
+constexpr uint32_t IR_IDCODE = 0x01;
+constexpr uint32_t IR_DTMCS = 0x10;
+constexpr uint32_t IR_DMI = 0x11;
+constexpr uint8_t kIrLength = 5;
+
+constexpr uint32_t DTMCS_VERSION_MASK = 0xF;
+constexpr uint32_t DTMCS_VERSION_013 = 1;
+constexpr uint32_t DTMCS_DMIRESET = (1UL << 16);
+
+constexpr uint8_t DMI_OP_NOP = 0;
+constexpr uint8_t DMI_OP_READ = 1;
+constexpr uint8_t DMI_OP_WRITE = 2;
+constexpr uint8_t DMI_STATUS_FAILED = 2;
+constexpr uint8_t DMI_STATUS_BUSY = 3;
+
+constexpr uint8_t kMaxIdle = 64;
+
+}  // namespace
+
+RiscvDmi::RiscvDmi(JtagEngine& jtag) : jtag_(jtag) {}
+
+uint8_t RiscvDmi::Connect(uint8_t index, uint32_t& idcode, uint32_t& dtmcs)
+{
+  abits_ = 0;
+  if (!jtag_.Select(index) || jtag_.IrLength() != kIrLength)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+  jtag_.ResetTap();
+
+  jtag_.ShiftIr(IR_IDCODE);
+  idcode = static_cast<uint32_t>(jtag_.ShiftDr(0, 32));
+  jtag_.ShiftIr(IR_DTMCS);
+  dtmcs = static_cast<uint32_t>(jtag_.ShiftDr(0, 32));
+
+  if ((dtmcs & DTMCS_VERSION_MASK) != DTMCS_VERSION_013)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  abits_ = static_cast<uint8_t>((dtmcs >> 4) & 0x3F);
+  idle_ = static_cast<uint8_t>((dtmcs >> 12) & 0x7);
+  jtag_.ShiftIr(IR_DMI);
+  return DAP_TRANSFER_OK;
+}
+
+RiscvDmi::Capture RiscvDmi::Scan(uint8_t op, uint8_t addr, uint32_t data)
+{
+  const uint64_t out =
+      (static_cast<uint64_t>(addr) << 34) | (static_cast<uint64_t>(data) << 2) | op;
+  const uint64_t in = jtag_.ShiftDr(out, static_cast<uint8_t>(abits_ + 34));
+  jtag_.Idle(idle_);
+
+  return {static_cast<uint8_t>(in & 3U), static_cast<uint32_t>(in >> 2)};
+}
+
+void RiscvDmi::DmiReset()
+{
+  jtag_.ShiftIr(IR_DTMCS);
+  jtag_.ShiftDr(DTMCS_DMIRESET, 32);
+  jtag_.ShiftIr(IR_DMI);
+
+  if (idle_ < kMaxIdle)
+  {
+    idle_++;
+  }
+}
+
+uint8_t RiscvDmi::Issue(uint8_t op, uint8_t addr, uint32_t data, Capture& prev)
+{
+  bool recovered = false;
+
+  for (uint32_t retry = 0; retry <= kDmiBusyRetries; retry++)
+  {
+    const Capture cap = Scan(op, addr, data);
+    if (cap.status != DMI_STATUS_BUSY)
+    {
+      if (!recovered)
+      {
+        prev = cap;
+      }
+      if (cap.status == DMI_STATUS_FAILED)
+      {
+        DmiReset();
+        return DAP_TRANSFER_ERROR;
+      }
+      return DAP_TRANSFER_OK;
+    }
+
+    // The previous operation was still running and this one was dropped.
+    // Clear the sticky busy, then collect that result with a NOP.
+    DmiReset();
+    if (!recovered)
+    {
+      const Capture nop = Scan(DMI_OP_NOP, 0, 0);
+      if (nop.status == DMI_STATUS_BUSY)
+      {
+        DmiReset();
+        continue;
+      }
+      prev = nop;
+      recovered = true;
+    }
+  }
+
+  return DAP_TRANSFER_WAIT;
+}
+
+uint8_t RiscvDmi::Batch(const Op* ops, uint32_t count, uint32_t* read_data,
+                        uint32_t& done)
+{
+  done = 0;
+  if (abits_ == 0)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  Capture prev = {};
+  bool pending = false;  // ops[done] was issued, its result is still in flight
+  uint32_t reads = 0;
+  uint8_t ack = DAP_TRANSFER_OK;
+
+  // The scan that issues the next operation returns the pending result
+  auto complete = [&]()
+  {
+    if (pending && ops[done].type == OpType::READ)
+    {
+      read_data[reads++] = prev.data;
+    }
+    done += pending ? 1 : 0;
+    pending = false;
+  };
+
+  for (uint32_t i = 0; i < count && ack == DAP_TRANSFER_OK; i++)
+  {
+    const Op& op = ops[i];
+    if (op.type == OpType::COMMAND)
+    {
+      // Drain the pipeline first so the command sees all earlier writes
+      if (pending)
+      {
+        ack = Issue(DMI_OP_NOP, 0, 0, prev);
+        if (ack == DAP_TRANSFER_OK)
+        {
+          complete();
+        }
+      }
+      if (ack == DAP_TRANSFER_OK)
+      {
+        ack = Execute(op.data);
+      }
+      if (ack == DAP_TRANSFER_OK)
+      {
+        done++;
+      }
+    }
+    else
+    {
+      const uint8_t dmi_op = (op.type == OpType::READ) ? DMI_OP_READ : DMI_OP_WRITE;
+      ack = Issue(dmi_op, op.addr, op.data, prev);
+      if (ack == DAP_TRANSFER_OK)
+      {
+        complete();
+        pending = true;
+      }
+    }
+  }
+
+  if (ack == DAP_TRANSFER_OK && pending)
+  {
+    ack = Issue(DMI_OP_NOP, 0, 0, prev);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      complete();
+    }
+  }
+
+  return ack;
+}
+
+uint8_t RiscvDmi::Read(uint8_t addr, uint32_t& value)
+{
+  const Op op = {OpType::READ, addr, 0};
+  uint32_t done = 0;
+  return Batch(&op, 1, &value, done);
+}
+
+uint8_t RiscvDmi::Write(uint8_t addr, uint32_t value)
+{
+  const Op op = {OpType::WRITE, addr, value};
+  uint32_t done = 0;
+  return Batch(&op, 1, nullptr, done);
+}
+
+uint8_t RiscvDmi::Execute(uint32_t command)
+{
+  Capture prev = {};
+  uint8_t ack = Issue(DMI_OP_WRITE, DM_COMMAND, command, prev);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+
+  const auto start = static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds());
+  uint32_t abstractcs = ABSTRACTCS_BUSY;
+
+  // Each read scan returns the previous read, the first one the command write
+  ack = Issue(DMI_OP_READ, DM_ABSTRACTCS, 0, prev);
+  while (ack == DAP_TRANSFER_OK)
+  {
+    ack = Issue(DMI_OP_READ, DM_ABSTRACTCS, 0, prev);
+    abstractcs = prev.data;
+    if ((abstractcs & ABSTRACTCS_BUSY) == 0)
+    {
+      break;
+    }
+    if (static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds()) - start >
+        kDmiCommandTimeoutMs)
+    {
+      ack = DAP_TRANSFER_WAIT;
+    }
+  }
+
+  // Leave the pipeline empty
+  const uint8_t drain = Issue(DMI_OP_NOP, 0, 0, prev);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+  if (drain != DAP_TRANSFER_OK)
+  {
+    return drain;
+  }
+
+  if ((abstractcs & ABSTRACTCS_CMDERR) != 0)
+  {
+    Issue(DMI_OP_WRITE, DM_ABSTRACTCS, ABSTRACTCS_CMDERR, prev);  // W1C
+    Issue(DMI_OP_NOP, 0, 0, prev);
+    return DAP_TRANSFER_ERROR;
+  }
+  return DAP_TRANSFER_OK;
+}
+
+}  // namespace DAP
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dmi_port.hpp"
+#include "jtag_engine.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class RiscvDmi
+ * @brief RISC-V Debug Module Interface access through a JTAG DTM.
+ *
+ * DMI scans are pipelined: the result of an operation is captured by the scan
+ * that issues the next one. Busy responses are recovered on the probe with
+ * dmireset and a longer Run-Test/Idle delay. Results use the DAP transfer
+ * response bits (WAIT when the DM stays busy).
+ */
+class RiscvDmi : public DmiPort
+{
+ public:
+  explicit RiscvDmi(JtagEngine& jtag);
+
+  /**
+   * @brief Reset the TAP and read the DTM identification
+   * @param index Chain position of the DTM
+   * @param idcode IDCODE of the selected device
+   * @param dtmcs DTM control and status
+   * @return DAP transfer response bits
+   */
+  uint8_t Connect(uint8_t index, uint32_t& idcode, uint32_t& dtmcs);
+
+  uint8_t Read(uint8_t addr, uint32_t& value) override;
+  uint8_t Write(uint8_t addr, uint32_t value) override;
+  uint8_t Execute(uint32_t command) override;
+  uint8_t Batch(const Op* ops, uint32_t count, uint32_t* read_data,
+                uint32_t& done) override;
+
+ private:
+  struct Capture
+  {
+    uint8_t status;
+    uint32_t data;
+  };
+
+  Capture Scan(uint8_t op, uint8_t addr, uint32_t data);
+  uint8_t Issue(uint8_t op, uint8_t addr, uint32_t data, Capture& prev);
+  void DmiReset();
+
+  JtagEngine& jtag_;
+  uint8_t abits_ = 0;
+  uint8_t idle_ = 0;  // Run-Test/Idle cycles after each DMI scan
+};
+
+}  // namespace DAP
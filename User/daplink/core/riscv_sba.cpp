@@ -0,0 +1,123 @@
+#include "riscv_sba.hpp"
+
+#include "dap_constants.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+// sbcs fields (Debug Spec 0.13, 3.12.18)
+constexpr uint32_t SBCS_BUSYERROR = (1UL << 22);
+constexpr uint32_t SBCS_READONADDR = (1UL << 20);
+constexpr uint32_t SBCS_ACCESS_32 = (2UL << 17);
+constexpr uint32_t SBCS_AUTOINCREMENT = (1UL << 16);
+constexpr uint32_t SBCS_READONDATA = (1UL << 15);
+constexpr uint32_t SBCS_ERROR = (7UL << 12);
+
+constexpr uint32_t kBatchOps = 16;
+
+using Op = DmiPort::Op;
+using OpType = DmiPort::OpType;
+
+}  // namespace
+
+RiscvSba::RiscvSba(DmiPort& dmi) : dmi_(dmi) {}
+
+uint8_t RiscvSba::CheckStatus()
+{
+  uint32_t sbcs = 0;
+  uint8_t ack = dmi_.Read(DM_SBCS, sbcs);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+  if ((sbcs & (SBCS_ERROR | SBCS_BUSYERROR)) == 0)
+  {
+    return DAP_TRANSFER_OK;
+  }
+
+  dmi_.Write(DM_SBCS, SBCS_ERROR | SBCS_BUSYERROR);  // W1C
+  return (sbcs & SBCS_ERROR) ? DAP_TRANSFER_ERROR : DAP_TRANSFER_WAIT;
+}
+
+uint8_t RiscvSba::ReadBlock(uint32_t addr, uint32_t* data, uint32_t count)
+{
+  if (count == 0)
+  {
+    return DAP_TRANSFER_OK;
+  }
+
+  // Writing sbaddress0 starts the first read; each sbdata0 read starts the next
+  const uint32_t sbcs = SBCS_ACCESS_32 | SBCS_AUTOINCREMENT | SBCS_READONADDR |
+                        SBCS_READONDATA | SBCS_ERROR | SBCS_BUSYERROR;
+  Op ops[kBatchOps + 1];
+  uint32_t n_ops = 0;
+  ops[n_ops++] = {OpType::WRITE, DM_SBCS, sbcs};
+  ops[n_ops++] = {OpType::WRITE, DM_SBADDRESS0, addr};
+
+  uint8_t ack = DAP_TRANSFER_OK;
+  uint32_t left = count;
+  while (ack == DAP_TRANSFER_OK && left > 0)
+  {
+    uint32_t n = 0;
+    while (n_ops < kBatchOps && n < left)
+    {
+      if (n + 1 == left)
+      {
+        // Stop before the final read so it does not run past the block; the
+        // W1C error bits stay 0 so earlier errors reach CheckStatus()
+        ops[n_ops++] = {OpType::WRITE, DM_SBCS,
+                        sbcs & ~(SBCS_READONDATA | SBCS_ERROR | SBCS_BUSYERROR)};
+      }
+      ops[n_ops++] = {OpType::READ, DM_SBDATA0, 0};
+      n++;
+    }
+
+    uint32_t done = 0;
+    ack = dmi_.Batch(ops, n_ops, data, done);
+    data += n;
+    left -= n;
+    n_ops = 0;
+  }
+
+  const uint8_t status = CheckStatus();
+  return (ack == DAP_TRANSFER_OK) ? status : ack;
+}
+
+uint8_t RiscvSba::WriteBlock(uint32_t addr, const uint32_t* data, uint32_t count)
+{
+  if (count == 0)
+  {
+    return DAP_TRANSFER_OK;
+  }
+
+  // Each sbdata0 write starts a bus write and advances sbaddress
+  const uint32_t sbcs =
+      SBCS_ACCESS_32 | SBCS_AUTOINCREMENT | SBCS_ERROR | SBCS_BUSYERROR;
+  Op ops[kBatchOps];
+  uint32_t n_ops = 0;
+  ops[n_ops++] = {OpType::WRITE, DM_SBCS, sbcs};
+  ops[n_ops++] = {OpType::WRITE, DM_SBADDRESS0, addr};
+
+  uint8_t ack = DAP_TRANSFER_OK;
+  uint32_t left = count;
+  while (ack == DAP_TRANSFER_OK && left > 0)
+  {
+    while (n_ops < kBatchOps && left > 0)
+    {
+      ops[n_ops++] = {OpType::WRITE, DM_SBDATA0, *data++};
+      left--;
+    }
+
+    uint32_t done = 0;
+    ack = dmi_.Batch(ops, n_ops, nullptr, done);
+    n_ops = 0;
+  }
+
+  const uint8_t status = CheckStatus();
+  return (ack == DAP_TRANSFER_OK) ? status : ack;
+}
+
+}  // namespace DAP
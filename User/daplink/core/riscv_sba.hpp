@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dmi_port.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class RiscvSba
+ * @brief 32-bit memory access through RISC-V System Bus Access.
+ *
+ * Blocks use sbautoincrement (and sbreadondata for reads) so each word costs
+ * one DMI scan. sberror and sbbusyerror are checked once per block. Results
+ * use the DAP transfer response bits: ERROR for a bus error, WAIT when the
+ * system bus could not keep up with the DMI.
+ */
+class RiscvSba
+{
+ public:
+  explicit RiscvSba(DmiPort& dmi);
+
+  /**
+   * @brief Read 32-bit words
+   * @param addr Word-aligned target address
+   * @param data Destination
+   * @param count Number of words
+   * @return DAP transfer response bits
+   */
+  uint8_t ReadBlock(uint32_t addr, uint32_t* data, uint32_t count);
+
+  /**
+   * @brief Write 32-bit words
+   * @param addr Word-aligned target address
+   * @param data Source
+   * @param count Number of words
+   * @return DAP transfer response bits
+   */
+  uint8_t WriteBlock(uint32_t addr, const uint32_t* data, uint32_t count);
+
+ private:
+  uint8_t CheckStatus();
+
+  DmiPort& dmi_;
+};
+
+}  // namespace DAP
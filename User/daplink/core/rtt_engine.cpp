@@ -0,0 +1,286 @@
+#include "rtt_engine.hpp"
+
+#include <cstring>
+
+namespace DAP
+{
+
+namespace
+{
+
+constexpr char kRttId[] = "SEGGER RTT";  // Compared including the terminator
+constexpr uint32_t kIdWords = (sizeof(kRttId) + 3) / 4;
+constexpr uint32_t kScanChunkWords = 16;
+constexpr uint32_t kScanStep = (kScanChunkWords - kIdWords + 1) * 4;
+constexpr size_t kCopyChunk = 64;
+
+}  // namespace
+
+RttEngine::RttEngine(MemAp& mem) : mem_(mem) {}
+
+uint8_t RttEngine::Find(uint32_t address, uint32_t search_size)
+{
+  uint32_t words[kScanChunkWords];
+  const auto* bytes = reinterpret_cast<const uint8_t*>(words);
+
+  address &= ~3U;
+  if (search_size == 0)
+  {
+    search_size = kIdWords * 4;  // Exact address, single candidate
+  }
+
+  // Never read past the range, the target may have nothing mapped behind it
+  for (uint32_t offset = 0; offset + kIdWords * 4 <= search_size; offset += kScanStep)
+  {
+    uint32_t chunk = (search_size - offset) / 4;
+    if (chunk > kScanChunkWords)
+    {
+      chunk = kScanChunkWords;
+    }
+
+    uint8_t ack = mem_.ReadWords(address + offset, words, chunk);
+    if (ack != DAP_TRANSFER_OK)
+    {
+      return ack;
+    }
+
+    // Control block is word aligned; consecutive chunks overlap by the ID tail
+    for (uint32_t i = 0; i + kIdWords * 4 <= chunk * 4; i += 4)
+    {
+      if (std::memcmp(bytes + i, kRttId, sizeof(kRttId)) == 0)
+      {
+        control_block_ = address + offset + i;
+        return DAP_TRANSFER_OK;
+      }
+    }
+  }
+
+  return DAP_TRANSFER_MISMATCH;
+}
+
+uint8_t RttEngine::LoadDesc(uint32_t desc_addr, BufferDesc& desc)
+{
+  uint32_t fields[3];  // sName, pBuffer, SizeOfBuffer
+  uint8_t ack = mem_.ReadWords(desc_addr, fields, 3);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+
+  desc.desc_addr = desc_addr;
+  desc.buffer = fields[1];
+  desc.size = fields[2];
+  return DAP_TRANSFER_OK;
+}
+
+uint8_t RttEngine::Start(uint32_t address, uint32_t search_size, uint8_t up_channel,
+                         uint8_t down_channel, bool stream)
+{
+  active_ = false;
+  ring_head_ = ring_tail_ = 0;
+  if (stream && sink_ == nullptr)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+  streaming_ = stream;
+
+  uint8_t ack = mem_.SaveContext();
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = Find(address, search_size);
+  }
+
+  uint32_t counts[2] = {};  // MaxNumUpBuffers, MaxNumDownBuffers
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = mem_.ReadWords(control_block_ + 16, counts, 2);
+  }
+  if (ack == DAP_TRANSFER_OK && (up_channel >= counts[0] || down_channel >= counts[1]))
+  {
+    ack = DAP_TRANSFER_MISMATCH;
+  }
+
+  const uint32_t up_base = control_block_ + kControlBlockHeader;
+  const uint32_t down_base = up_base + counts[0] * kBufferDescSize;
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = LoadDesc(up_base + up_channel * kBufferDescSize, up_);
+  }
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = LoadDesc(down_base + down_channel * kBufferDescSize, down_);
+  }
+
+  const uint8_t restore = mem_.RestoreContext();
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = restore;
+  }
+
+  active_ = (ack == DAP_TRANSFER_OK) && up_.size != 0;
+  last_poll_ms_ = static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds());
+  return ack;
+}
+
+uint8_t RttEngine::Poll()
+{
+  if (!active_)
+  {
+    return DAP_TRANSFER_OK;
+  }
+
+  const auto now = static_cast<uint32_t>(LibXR::Timebase::GetMilliseconds());
+  if (now - last_poll_ms_ < poll_interval_ms_)
+  {
+    return DAP_TRANSFER_OK;
+  }
+  last_poll_ms_ = now;
+
+  uint8_t ack = mem_.SaveContext();
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = PollOnce();
+  }
+
+  const uint8_t restore = mem_.RestoreContext();
+  return (ack == DAP_TRANSFER_OK) ? restore : ack;
+}
+
+uint8_t RttEngine::PollOnce()
+{
+  uint32_t offsets[2];  // WrOff, RdOff
+  uint8_t ack = mem_.ReadWords(up_.desc_addr + kWrOffOffset, offsets, 2);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+
+  const uint32_t wr = offsets[0];
+  uint32_t rd = offsets[1];
+  if (wr >= up_.size || rd >= up_.size)
+  {
+    return DAP_TRANSFER_OK;  // Buffer not initialised yet
+  }
+
+  uint8_t chunk[kCopyChunk];
+  uint32_t budget = kRttPollBudget;
+  const uint32_t rd_start = rd;
+
+  while (rd != wr && budget > 0)
+  {
+    size_t n = ((wr > rd) ? wr : up_.size) - rd;
+    n = (n > budget) ? budget : n;
+    n = (n > sizeof(chunk)) ? sizeof(chunk) : n;
+
+    // Whatever does not fit stays in the target buffer
+    const size_t space =
+        streaming_ ? sink_->Space()
+                   : (ring_tail_ + kRttRingSize - ring_head_ - 1) % kRttRingSize;
+    n = (n > space) ? space : n;
+    if (n == 0)
+    {
+      break;
+    }
+
+    ack = mem_.Read(up_.buffer + rd, chunk, n);
+    if (ack != DAP_TRANSFER_OK)
+    {
+      break;
+    }
+
+    Emit(chunk, n);
+    rd = (rd + n == up_.size) ? 0 : rd + n;
+    budget -= n;
+  }
+
+  if (rd != rd_start)
+  {
+    const uint8_t wr_ack = mem_.WriteWords(up_.desc_addr + kWrOffOffset + 4, &rd, 1);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      ack = wr_ack;
+    }
+  }
+
+  return ack;
+}
+
+void RttEngine::Emit(const uint8_t* data, size_t len)
+{
+  if (streaming_)
+  {
+    sink_->Write(data, len);
+    return;
+  }
+
+  for (size_t i = 0; i < len; i++)
+  {
+    ring_[ring_head_] = data[i];
+    ring_head_ = (ring_head_ + 1) % kRttRingSize;
+  }
+}
+
+size_t RttEngine::ReadUp(uint8_t* data, size_t max_len)
+{
+  size_t n = 0;
+  while (n < max_len && ring_tail_ != ring_head_)
+  {
+    data[n++] = ring_[ring_tail_];
+    ring_tail_ = (ring_tail_ + 1) % kRttRingSize;
+  }
+  return n;
+}
+
+uint8_t RttEngine::WriteDown(const uint8_t* data, size_t len, size_t& written)
+{
+  written = 0;
+  if (!active_ || down_.size == 0)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  uint8_t ack = mem_.SaveContext();
+
+  uint32_t offsets[2];  // WrOff, RdOff
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = mem_.ReadWords(down_.desc_addr + kWrOffOffset, offsets, 2);
+  }
+
+  if (ack == DAP_TRANSFER_OK && offsets[0] < down_.size && offsets[1] < down_.size)
+  {
+    uint32_t wr = offsets[0];
+    const uint32_t rd = offsets[1];
+    uint32_t free_bytes = (rd > wr) ? (rd - wr - 1) : (down_.size - wr + rd - 1);
+
+    while (ack == DAP_TRANSFER_OK && written < len && free_bytes > 0)
+    {
+      size_t n = len - written;
+      n = (n > free_bytes) ? free_bytes : n;
+      n = (n > down_.size - wr) ? (down_.size - wr) : n;
+
+      ack = mem_.Write(down_.buffer + wr, data + written, n);
+      if (ack == DAP_TRANSFER_OK)
+      {
+        wr = (wr + n == down_.size) ? 0 : wr + n;
+        free_bytes -= n;
+        written += n;
+      }
+    }
+
+    // Publish the new write offset only after the data is in place
+    if (written > 0)
+    {
+      const uint8_t wr_ack = mem_.WriteWords(down_.desc_addr + kWrOffOffset, &wr, 1);
+      if (ack == DAP_TRANSFER_OK)
+      {
+        ack = wr_ack;
+      }
+    }
+  }
+
+  const uint8_t restore = mem_.RestoreContext();
+  return (ack == DAP_TRANSFER_OK) ? restore : ack;
+}
+
+}  // namespace DAP
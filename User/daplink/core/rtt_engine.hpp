@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "dap_config.hpp"
+#include "libxr.hpp"
+#include "mem_ap.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class RttSink
+ * @brief Stream receiving RTT up-buffer data for the host, e.g. a CDC port.
+ *
+ * Only what fits is taken; the rest stays in the target's up-buffer.
+ */
+class RttSink
+{
+ public:
+  virtual ~RttSink() = default;
+
+  /**
+   * @brief Bytes Write() accepts right now
+   */
+  virtual size_t Space() const = 0;
+
+  /**
+   * @brief Queue bytes for the host
+   * @param data Source
+   * @param len Number of bytes, at most Space()
+   */
+  virtual void Write(const uint8_t* data, size_t len) = 0;
+};
+
+/**
+ * @class RttEngine
+ * @brief Probe-side SEGGER RTT client.
+ *
+ * Locates the _SEGGER_RTT control block once, then polls one up-buffer from the
+ * DAP worker between host commands. New bytes go to the sink when the host
+ * asked for streaming, otherwise to a local ring for the RTT_Read vendor command.
+ * Down-buffer writes from the host are applied directly in target memory.
+ */
+class RttEngine
+{
+ public:
+  explicit RttEngine(MemAp& mem);
+
+  /**
+   * @brief Locate the control block and start polling
+   * @param address Control block address, or start of the search range
+   * @param search_size Search range in bytes, 0 if address is exact. Nothing past
+   *        the range is read, so the ID must lie inside it.
+   * @param up_channel Up-buffer index to poll
+   * @param down_channel Down-buffer index for host writes
+   * @param stream Send up-buffer data to the sink instead of the RTT_Read ring
+   * @return DAP transfer response bits, DAP_TRANSFER_MISMATCH if not found,
+   *         DAP_TRANSFER_ERROR if streaming is requested without a sink
+   */
+  uint8_t Start(uint32_t address, uint32_t search_size, uint8_t up_channel,
+                uint8_t down_channel, bool stream = false);
+
+  void Stop() { active_ = false; }
+  bool Active() const { return active_; }
+  uint32_t GetControlBlock() const { return control_block_; }
+
+  void SetPollInterval(uint32_t interval_ms) { poll_interval_ms_ = interval_ms; }
+  uint32_t GetPollInterval() const { return poll_interval_ms_; }
+
+  /**
+   * @brief Install the stream used when RTT_Start asks for streaming
+   * @param sink Stream of the board, null to remove
+   */
+  void SetSink(RttSink* sink)
+  {
+    sink_ = sink;
+    if (sink_ == nullptr && streaming_)
+    {
+      active_ = false;  // Nowhere left to stream to
+    }
+  }
+
+  /**
+   * @brief Poll the up-buffer if the poll interval elapsed
+   * @return DAP transfer response bits of the last access
+   */
+  uint8_t Poll();
+
+  /**
+   * @brief Drain bytes buffered from the up-buffer
+   * @param data Destination
+   * @param max_len Maximum bytes to copy
+   * @return Bytes copied
+   */
+  size_t ReadUp(uint8_t* data, size_t max_len);
+
+  /**
+   * @brief Write bytes into the down-buffer
+   * @param data Source
+   * @param len Number of bytes
+   * @param written Bytes accepted by the target buffer
+   * @return DAP transfer response bits
+   */
+  uint8_t WriteDown(const uint8_t* data, size_t len, size_t& written);
+
+ private:
+  // SEGGER_RTT_BUFFER_UP / _DOWN layout
+  struct BufferDesc
+  {
+    uint32_t desc_addr = 0;
+    uint32_t buffer = 0;
+    uint32_t size = 0;
+  };
+
+  static constexpr uint32_t kControlBlockHeader = 24;  // acID[16] + 2 counts
+  static constexpr uint32_t kBufferDescSize = 24;
+  static constexpr uint32_t kWrOffOffset = 12;
+
+  uint8_t Find(uint32_t address, uint32_t search_size);
+  uint8_t LoadDesc(uint32_t desc_addr, BufferDesc& desc);
+  uint8_t PollOnce();
+  void Emit(const uint8_t* data, size_t len);
+
+  MemAp& mem_;
+  RttSink* sink_ = nullptr;
+  bool streaming_ = false;  // Up-buffer data goes to sink_ instead of ring_
+
+  bool active_ = false;
+  uint32_t control_block_ = 0;
+  BufferDesc up_;
+  BufferDesc down_;
+
+  uint32_t poll_interval_ms_ = kRttDefaultPollMs;
+  uint32_t last_poll_ms_ = 0;
+
+  uint8_t ring_[kRttRingSize] = {};
+  size_t ring_head_ = 0;
+  size_t ring_tail_ = 0;
+};
+
+}  // namespace DAP
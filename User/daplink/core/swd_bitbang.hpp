@@ -0,0 +1,325 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "dap_constants.hpp"
+#include "dap_io.hpp"
+#include "libxr.hpp"
+#include "swd_wire.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class SwdBitbang
+ * @brief SWD wire layer bit-banged on GPIO registers, for wiring or targets
+ *        where the SPI engine cannot meet the turnaround timing.
+ *
+ * Pins is a register-level policy with inline members:
+ *   void Setup(), void Release()         claim / hand back SWCLK and SWDIO
+ *   void ClockLow(), void ClockHigh()
+ *   void Out(bool), bool In()            SWDIO level
+ *   void OutputEnable(), OutputDisable() SWDIO direction
+ *   uint32_t CoreClock()                 CPU clock in Hz
+ *   uint32_t CycleCount()                free-running CPU cycle counter
+ *   kCycleCounter                        CycleCount() is available
+ *   kDelayLoopCycles                     nominal cycles per Delay() iteration
+ *   kBitOverheadCycles                   nominal cycles per SWCLK period outside Delay()
+ *
+ * Bits follow the CMSIS-DAP reference timing: the host changes SWDIO while
+ * SWCLK is low and samples it just before the rising edge. Fixed-width fields
+ * are unrolled at compile time, and with no delay the clock runs as fast as
+ * the GPIO writes allow.
+ */
+template <typename Pins>
+class SwdBitbang : public SwdWire
+{
+ public:
+  explicit SwdBitbang(DapIo& io) : SwdWire(io)
+  {
+    Calibrate();
+    SetClock(kDefaultClockHz);
+  }
+
+  void Release() override { pins_.Release(); }
+
+  void SetClock(uint32_t hz) override
+  {
+    const uint32_t period = (hz == 0) ? 0 : pins_.CoreClock() / hz;
+    delay_ = (period > overhead_cycles_)
+                 ? (period - overhead_cycles_) / (2 * loop_cycles_)
+                 : 0;
+  }
+
+  uint8_t Transfer(uint8_t request, uint32_t& data) override
+  {
+    return (delay_ == 0) ? TransferImpl<false>(request, data)
+                         : TransferImpl<true>(request, data);
+  }
+
+  LibXR::ErrorCode TargetSel(uint32_t value) override
+  {
+    // Header 0x99 (DP write, A = 0xC, parity 0); nobody drives the ACK
+    WriteBits<true, 8>(0x99);
+    pins_.OutputDisable();
+    Cycles<true>(2 * turnaround_ + 3);
+    pins_.OutputEnable();
+    WriteBits<true, 32>(value);
+    WriteBits<true, 1>(Parity(value));
+    Idle<true>();
+    return LibXR::ErrorCode::OK;
+  }
+
+  LibXR::ErrorCode SequenceOut(const uint8_t* data, uint32_t bit_count) override
+  {
+    for (uint32_t i = 0; i < bit_count; i++)
+    {
+      WriteBit<true>((data[i >> 3] >> (i & 7)) & 1U);
+    }
+    return LibXR::ErrorCode::OK;
+  }
+
+  LibXR::ErrorCode SequenceIn(uint8_t* data, uint32_t bit_count) override
+  {
+    pins_.OutputDisable();
+    for (uint32_t i = 0; i < bit_count; i++)
+    {
+      if ((i & 7) == 0)
+      {
+        data[i >> 3] = 0;
+      }
+      data[i >> 3] |= static_cast<uint8_t>(ReadBit<true>() << (i & 7));
+    }
+    pins_.OutputEnable();
+    return LibXR::ErrorCode::OK;
+  }
+
+  LibXR::ErrorCode LineReset() override
+  {
+    pins_.Out(true);
+    Cycles<true>(56);
+    pins_.Out(false);
+    Cycles<true>(8);
+    return LibXR::ErrorCode::OK;
+  }
+
+ protected:
+  LibXR::ErrorCode SetupPins() override
+  {
+    pins_.Setup();
+    pins_.OutputEnable();
+    pins_.Out(true);
+    return LibXR::ErrorCode::OK;
+  }
+
+ private:
+  static constexpr uint32_t kDefaultClockHz = 1000000;
+
+  static uint32_t Parity(uint32_t v)
+  {
+    v ^= v >> 16;
+    v ^= v >> 8;
+    v ^= v >> 4;
+    v ^= v >> 2;
+    v ^= v >> 1;
+    return v & 1U;
+  }
+
+  template <bool kDelay>
+  inline void Delay() const
+  {
+    if constexpr (kDelay)
+    {
+      for (volatile uint32_t n = delay_; n != 0; n--)
+      {
+      }
+    }
+  }
+
+  template <bool kDelay>
+  inline void WriteBit(uint32_t bit)
+  {
+    pins_.Out(bit != 0);
+    pins_.ClockLow();
+    Delay<kDelay>();
+    pins_.ClockHigh();
+    Delay<kDelay>();
+  }
+
+  template <bool kDelay>
+  inline uint32_t ReadBit()
+  {
+    pins_.ClockLow();
+    Delay<kDelay>();
+    const uint32_t bit = pins_.In() ? 1U : 0U;
+    pins_.ClockHigh();
+    Delay<kDelay>();
+    return bit;
+  }
+
+  template <bool kDelay, size_t... I>
+  inline void WriteUnrolled(uint32_t value, std::index_sequence<I...>)
+  {
+    (WriteBit<kDelay>((value >> I) & 1U), ...);
+  }
+
+  template <bool kDelay, size_t... I>
+  inline uint32_t ReadUnrolled(std::index_sequence<I...>)
+  {
+    return ((ReadBit<kDelay>() << I) | ...);
+  }
+
+  template <bool kDelay, size_t N>
+  inline void WriteBits(uint32_t value)
+  {
+    WriteUnrolled<kDelay>(value, std::make_index_sequence<N>{});
+  }
+
+  template <bool kDelay, size_t N>
+  inline uint32_t ReadBits()
+  {
+    return ReadUnrolled<kDelay>(std::make_index_sequence<N>{});
+  }
+
+  template <bool kDelay>
+  inline void Cycles(uint32_t count)
+  {
+    for (; count != 0; count--)
+    {
+      pins_.ClockLow();
+      Delay<kDelay>();
+      pins_.ClockHigh();
+      Delay<kDelay>();
+    }
+  }
+
+  template <bool kDelay>
+  inline void Idle()
+  {
+    pins_.Out(false);
+    Cycles<kDelay>(idle_cycles_);
+    pins_.Out(true);
+  }
+
+  template <bool kDelay>
+  uint8_t TransferImpl(uint8_t request, uint32_t& data)
+  {
+    const uint32_t req4 = request & 0x0F;
+    const bool read = (request & DAP_TRANSFER_RnW) != 0;
+
+    // Start, APnDP, RnW, A2, A3, parity, stop, park
+    WriteBits<kDelay, 8>(0x81U | (req4 << 1) | (Parity(req4) << 5));
+
+    pins_.OutputDisable();
+    Cycles<kDelay>(turnaround_);
+    auto ack = static_cast<uint8_t>(ReadBits<kDelay, 3>());
+
+    if (ack == DAP_TRANSFER_OK)
+    {
+      if (read)
+      {
+        const uint32_t value = ReadBits<kDelay, 32>();
+        const uint32_t parity = ReadBits<kDelay, 1>();
+        Cycles<kDelay>(turnaround_);
+        pins_.OutputEnable();
+        if (parity != Parity(value))
+        {
+          ack = DAP_TRANSFER_ERROR;
+        }
+        data = value;
+      }
+      else
+      {
+        Cycles<kDelay>(turnaround_);
+        pins_.OutputEnable();
+        WriteBits<kDelay, 32>(data);
+        WriteBits<kDelay, 1>(Parity(data));
+      }
+      Idle<kDelay>();
+      return ack;
+    }
+
+    if (ack == DAP_TRANSFER_WAIT || ack == DAP_TRANSFER_FAULT)
+    {
+      if (data_phase_ && read)
+      {
+        Cycles<kDelay>(33);
+      }
+      Cycles<kDelay>(turnaround_);
+      pins_.OutputEnable();
+      if (data_phase_ && !read)
+      {
+        pins_.Out(false);
+        Cycles<kDelay>(33);
+      }
+      pins_.Out(true);
+      return ack;
+    }
+
+    // Protocol error: back off the whole data phase
+    Cycles<kDelay>(turnaround_ + 33);
+    pins_.OutputEnable();
+    pins_.Out(true);
+    return ack;
+  }
+
+  /**
+   * @brief Fit the SWCLK timing model to the CPU cycle counter.
+   *
+   * Times 32 delayed bits at two delay settings: the difference gives the
+   * cycles per Delay() iteration, the rest the per-bit overhead, for the code
+   * the compiler actually emitted at the actual SystemCoreClock. Runs from the
+   * constructor, before Setup() claims the pins, so the writes do not reach
+   * the target. Without a counter the nominal Pins figures stay in use.
+   */
+  void Calibrate()
+  {
+    if constexpr (Pins::kCycleCounter)
+    {
+      const uint32_t low = TimeBits(kCalibrateDelayLow);
+      const uint32_t high = TimeBits(kCalibrateDelayHigh);
+      if (high > low)
+      {
+        constexpr uint32_t kIterations =
+            32 * 2 * (kCalibrateDelayHigh - kCalibrateDelayLow);
+        const uint32_t loop = (high - low + kIterations / 2) / kIterations;
+        loop_cycles_ = (loop != 0) ? loop : 1;
+        const uint32_t bit = low / 32;
+        const uint32_t delay = 2 * kCalibrateDelayLow * loop_cycles_;
+        overhead_cycles_ = (bit > delay) ? bit - delay : 0;
+      }
+      delay_ = 0;
+    }
+  }
+
+  /**
+   * @brief Shortest of a few timed 32-bit writes, so an interrupt or a
+   *        counter wrap in one run is discarded
+   * @param delay Delay() iterations per half period
+   * @return CPU cycles for 32 bits
+   */
+  uint32_t TimeBits(uint32_t delay)
+  {
+    delay_ = delay;
+    uint32_t best = UINT32_MAX;
+    for (int i = 0; i < 4; i++)
+    {
+      const uint32_t start = pins_.CycleCount();
+      WriteBits<true, 32>(0);
+      const uint32_t cycles = pins_.CycleCount() - start;
+      best = (cycles < best) ? cycles : best;
+    }
+    return best;
+  }
+
+  static constexpr uint32_t kCalibrateDelayLow = 2;
+  static constexpr uint32_t kCalibrateDelayHigh = 18;
+
+  Pins pins_;
+  uint32_t delay_ = 0;  // Delay() iterations per half SWCLK period
+  uint32_t loop_cycles_ = Pins::kDelayLoopCycles;
+  uint32_t overhead_cycles_ = Pins::kBitOverheadCycles;
+};
+
+}  // namespace DAP
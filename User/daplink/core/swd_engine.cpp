@@ -0,0 +1,301 @@
+#include "swd_engine.hpp"
+
+#include <cstring>
+
+#include "dap_constants.hpp"
+#include "event_trace.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+constexpr uint32_t kSpiTimeoutMs = 10;
+
+// CH32 SPI shifts MSB first while SWD is LSB first
+constexpr uint8_t ReverseBits(uint8_t v)
+{
+  v = static_cast<uint8_t>(((v & 0xF0) >> 4) | ((v & 0x0F) << 4));
+  v = static_cast<uint8_t>(((v & 0xCC) >> 2) | ((v & 0x33) << 2));
+  v = static_cast<uint8_t>(((v & 0xAA) >> 1) | ((v & 0x55) << 1));
+  return v;
+}
+
+struct ReverseTable
+{
+  uint8_t value[256];
+  constexpr ReverseTable() : value()
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      value[i] = ReverseBits(static_cast<uint8_t>(i));
+    }
+  }
+};
+
+constexpr ReverseTable kReverse;
+
+inline uint8_t Parity32(uint32_t v)
+{
+  v ^= v >> 16;
+  v ^= v >> 8;
+  v ^= v >> 4;
+  v ^= v >> 2;
+  v ^= v >> 1;
+  return v & 1U;
+}
+
+// LSB-first bit packer for SWD packet phases
+struct BitWriter
+{
+  uint8_t* buf;
+  uint32_t pos = 0;
+
+  explicit BitWriter(uint8_t* buffer, uint8_t len) : buf(buffer)
+  {
+    std::memset(buf, 0, len);
+  }
+
+  void Put(uint32_t value, uint8_t bits)
+  {
+    for (uint8_t i = 0; i < bits; i++, pos++)
+    {
+      if (value & (1UL << i))
+      {
+        buf[pos >> 3] |= static_cast<uint8_t>(1U << (pos & 7));
+      }
+    }
+  }
+
+  void Skip(uint32_t bits) { pos += bits; }
+
+  uint8_t Bytes() const { return static_cast<uint8_t>((pos + 7) >> 3); }
+};
+
+inline uint32_t GetBits(const uint8_t* buf, uint32_t pos, uint8_t bits)
+{
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < bits; i++, pos++)
+  {
+    if (buf[pos >> 3] & (1U << (pos & 7)))
+    {
+      value |= (1UL << i);
+    }
+  }
+  return value;
+}
+
+}  // namespace
+
+SwdEngine::SwdEngine(DapIo& io) : SwdWire(io) {}
+
+LibXR::ErrorCode SwdEngine::SetupPins()
+{
+  // Configure SPI to generate SWCLK (SPI Mode 0 is typical for SWD), at the
+  // rate last chosen by SetClock()
+  auto err = io_.spi.SetConfig(SpiConfig());
+  if (err != LibXR::ErrorCode::OK)
+  {
+    return err;
+  }
+
+  // SWDIO is driven by MOSI through the series resistor and sampled on MISO.
+  // The direct SWDIO pin stays released so it does not fight either of them.
+  return io_.gpio_swdio.SetConfig({
+      LibXR::GPIO::Direction::INPUT,
+      LibXR::GPIO::Pull::NONE  // NOTE - Assuming external pull-up
+  });
+}
+
+void SwdEngine::SetClock(uint32_t hz)
+{
+  if (hz == 0)
+  {
+    return;
+  }
+
+  // Prescaler::DIV_n is log2(n); the SPI divides its bus clock by 2 at least
+  const uint32_t bus = io_.spi.GetMaxBusSpeed();
+  const auto max_shift = static_cast<uint32_t>(io_.spi.GetMaxPrescaler());
+  uint32_t shift = 1;
+  while (shift < max_shift && (bus >> shift) > hz)
+  {
+    shift++;
+  }
+  prescaler_ = static_cast<LibXR::SPI::Prescaler>(shift);
+  io_.spi.SetConfig(SpiConfig());
+}
+
+LibXR::ErrorCode SwdEngine::Shift(const uint8_t* tx, uint8_t* rx, uint8_t len)
+{
+  for (uint8_t i = 0; i < len; i++)
+  {
+    tx_buf_[i] = kReverse.value[tx[i]];
+  }
+
+  // Completion is seen here, once the DMA interrupt released the semaphore
+  auto& events = EventTrace::Instance();
+  events.Record(EventType::SpiStart, len);
+  LibXR::WriteOperation op(spi_sem_, kSpiTimeoutMs);
+  auto err = io_.spi.ReadAndWrite({rx_buf_, len}, {tx_buf_, len}, op);
+  events.Record(EventType::SpiDone, (err == LibXR::ErrorCode::OK) ? len : 0);
+  if (err != LibXR::ErrorCode::OK)
+  {
+    return err;
+  }
+
+  if (rx)
+  {
+    for (uint8_t i = 0; i < len; i++)
+    {
+      rx[i] = kReverse.value[rx_buf_[i]];
+    }
+  }
+
+  return LibXR::ErrorCode::OK;
+}
+
+uint8_t SwdEngine::Transfer(uint8_t request, uint32_t& data)
+{
+  uint8_t tx[kMaxShiftBytes];
+  uint8_t rx[kMaxShiftBytes];
+  const bool read = (request & DAP_TRANSFER_RnW) != 0;
+
+  // Phase 1: [idle pad] [header] [trn] [ack] ([trn] for writes)
+  const auto header_bits =
+      static_cast<uint8_t>(8 + turnaround_ + 3 + (read ? 0 : turnaround_));
+  const uint8_t pad = static_cast<uint8_t>((8 - (header_bits & 7)) & 7);
+
+  const uint8_t req4 = request & 0x0F;
+  const auto header = static_cast<uint8_t>(0x81 | (req4 << 1) | (Parity32(req4) << 5));
+
+  BitWriter w(tx, sizeof(tx));
+  w.Skip(pad);
+  w.Put(header, 8);
+  w.Skip(turnaround_);
+  const uint32_t ack_pos = w.pos;
+  w.Skip(3);
+  if (!read)
+  {
+    w.Skip(turnaround_);
+  }
+
+  if (Shift(tx, rx, w.Bytes()) != LibXR::ErrorCode::OK)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  const auto ack = static_cast<uint8_t>(GetBits(rx, ack_pos, 3));
+
+  // Phase 2: data phase padded with idle cycles
+  w = BitWriter(tx, sizeof(tx));
+  if (ack == DAP_TRANSFER_OK)
+  {
+    if (read)
+    {
+      w.Skip(33 + turnaround_ + idle_cycles_);
+      if (Shift(tx, rx, w.Bytes()) != LibXR::ErrorCode::OK)
+      {
+        return DAP_TRANSFER_ERROR;
+      }
+      uint32_t value = GetBits(rx, 0, 32);
+      if (GetBits(rx, 32, 1) != Parity32(value))
+      {
+        return DAP_TRANSFER_ERROR;
+      }
+      data = value;
+    }
+    else
+    {
+      w.Put(data, 32);
+      w.Put(Parity32(data), 1);
+      w.Skip(idle_cycles_);
+      if (Shift(tx, nullptr, w.Bytes()) != LibXR::ErrorCode::OK)
+      {
+        return DAP_TRANSFER_ERROR;
+      }
+    }
+    return ack;
+  }
+
+  if ((ack == DAP_TRANSFER_WAIT || ack == DAP_TRANSFER_FAULT) && !data_phase_)
+  {
+    if (read)
+    {
+      // Turnaround back to the host
+      w.Skip(turnaround_);
+      Shift(tx, nullptr, w.Bytes());
+    }
+    return ack;
+  }
+
+  // Data phase on WAIT/FAULT, or protocol error recovery: 33 released/low cycles
+  w.Skip(33 + (read ? turnaround_ : 0));
+  Shift(tx, nullptr, w.Bytes());
+  return ack;
+}
+
+LibXR::ErrorCode SwdEngine::TargetSel(uint32_t value)
+{
+  uint8_t tx[kMaxShiftBytes];
+
+  // [idle pad] [header] [trn] [ack, undriven] [trn] [data] [parity] [idle]
+  constexpr uint8_t req4 = DP_TARGETSEL;
+  constexpr auto header = static_cast<uint8_t>(0x81 | (req4 << 1));  // Parity 0
+  const auto bits = static_cast<uint8_t>(8 + 2 * turnaround_ + 3 + 33 + idle_cycles_);
+
+  BitWriter w(tx, sizeof(tx));
+  w.Skip((8 - (bits & 7)) & 7);
+  w.Put(header, 8);
+  w.Skip(2 * turnaround_ + 3);
+  w.Put(value, 32);
+  w.Put(Parity32(value), 1);
+  w.Skip(idle_cycles_);
+
+  return Shift(tx, nullptr, w.Bytes());
+}
+
+LibXR::ErrorCode SwdEngine::SequenceOut(const uint8_t* data, uint32_t bit_count)
+{
+  uint8_t tx[kMaxShiftBytes];
+  const uint8_t bytes = static_cast<uint8_t>((bit_count + 7) >> 3);
+  if (bytes == 0 || bytes > kMaxShiftBytes)
+  {
+    return LibXR::ErrorCode::ARG_ERR;
+  }
+
+  std::memcpy(tx, data, bytes);
+
+  // Repeat the last bit into the padding so the line state does not change
+  const uint8_t rem = bit_count & 7;
+  if (rem)
+  {
+    const bool last = (tx[bytes - 1] >> (rem - 1)) & 1U;
+    const auto mask = static_cast<uint8_t>(0xFF << rem);
+    tx[bytes - 1] = last ? (tx[bytes - 1] | mask) : (tx[bytes - 1] & ~mask);
+  }
+
+  return Shift(tx, nullptr, bytes);
+}
+
+LibXR::ErrorCode SwdEngine::SequenceIn(uint8_t* data, uint32_t bit_count)
+{
+  const uint8_t bytes = static_cast<uint8_t>((bit_count + 7) >> 3);
+  if (bytes == 0 || bytes > kMaxShiftBytes)
+  {
+    return LibXR::ErrorCode::ARG_ERR;
+  }
+
+  // MOSI parks low through the resistor, the target overrides it
+  static const uint8_t idle[kMaxShiftBytes] = {};
+  return Shift(idle, data, bytes);
+}
+
+LibXR::ErrorCode SwdEngine::LineReset()
+{
+  static const uint8_t reset_pack[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00};
+  return Shift(reset_pack, nullptr, sizeof(reset_pack));
+}
+
+}  // namespace DAP
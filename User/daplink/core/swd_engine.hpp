@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dap_io.hpp"
+#include "libxr.hpp"
+#include "swd_wire.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class SwdEngine
+ * @brief SWD wire layer clocked by the SPI peripheral.
+ *
+ * Wiring: SWCLK = SCK, MOSI drives SWDIO through a series resistor and MISO
+ * samples SWDIO, so the target overrides MOSI whenever it drives the line.
+ * The SPI shifts whole bytes only; every packet phase is therefore padded with
+ * idle (low) cycles in front of the start bit, which SWD permits, so that each
+ * SPI transaction ends exactly where the host has to look at the ACK.
+ */
+class SwdEngine : public SwdWire
+{
+ public:
+  explicit SwdEngine(DapIo& io);
+
+  uint8_t Transfer(uint8_t request, uint32_t& data) override;
+  LibXR::ErrorCode TargetSel(uint32_t value) override;
+
+  /**
+   * @brief Pick the SPI prescaler giving the fastest SCK not above hz
+   * @param hz Requested SWCLK frequency in Hz; 0 leaves the clock unchanged
+   */
+  void SetClock(uint32_t hz) override;
+
+  // Sequences are rounded up to whole bytes; SequenceOut repeats the last bit
+  LibXR::ErrorCode SequenceOut(const uint8_t* data, uint32_t bit_count) override;
+  LibXR::ErrorCode SequenceIn(uint8_t* data, uint32_t bit_count) override;
+  LibXR::ErrorCode LineReset() override;
+
+ protected:
+  LibXR::ErrorCode SetupPins() override;
+
+ private:
+  /**
+   * @brief Full-duplex SPI exchange with SWD (LSB first) bit order
+   * @param tx Bytes to shift out, LSB first
+   * @param rx Bytes shifted in, LSB first (may be nullptr)
+   * @param len Number of bytes
+   * @return ErrorCode indicating operation status
+   */
+  LibXR::ErrorCode Shift(const uint8_t* tx, uint8_t* rx, uint8_t len);
+
+  static constexpr uint8_t kMaxShiftBytes = 40;
+
+  /**
+   * @brief SPI Mode 0 at the current prescaler
+   */
+  LibXR::SPI::Configuration SpiConfig() const
+  {
+    return {LibXR::SPI::ClockPolarity::LOW, LibXR::SPI::ClockPhase::EDGE_1, prescaler_};
+  }
+
+  // UNKNOWN keeps the rate the SPI driver was constructed with
+  LibXR::SPI::Prescaler prescaler_ = LibXR::SPI::Prescaler::UNKNOWN;
+  LibXR::Semaphore spi_sem_{0};
+  uint8_t tx_buf_[kMaxShiftBytes] = {};  // Per engine: gang ports shift concurrently
+  uint8_t rx_buf_[kMaxShiftBytes] = {};
+};
+
+}  // namespace DAP
@@ -0,0 +1,139 @@
+#include "swd_gang.hpp"
+
+#include "dap_constants.hpp"
+
+namespace DAP
+{
+
+SwdGang::Port::Port(DapIo& port_io, SwdGang& owner)
+    : io(port_io), gang(owner), swd(port_io), transfer(swd)
+{
+  worker.Create<Port*>(this, WorkerTask, "gang_worker", kGangWorkerStackSize,
+                       LibXR::Thread::Priority::MEDIUM);
+}
+
+void SwdGang::Port::WorkerTask(Port* self)
+{
+  while (true)
+  {
+    self->start_sem.Wait();
+    self->Execute();
+    self->gang.done_sem_.Post();
+  }
+}
+
+void SwdGang::Port::Execute()
+{
+  result = {};
+
+  if (gang.job_ == Job::CONNECT)
+  {
+    if (swd.Setup() != LibXR::ErrorCode::OK)
+    {
+      result.ack = DAP_TRANSFER_ERROR;
+      return;
+    }
+    transfer.InvalidateSelect();
+    result.ack = transfer.ReadDp(DP_IDCODE, result.data);
+    result.done = (result.ack == DAP_TRANSFER_OK) ? 1 : 0;
+    return;
+  }
+
+  uint32_t done = 0;
+  if (gang.request_ & DAP_TRANSFER_RnW)
+  {
+    result.ack = transfer.ReadBlock(gang.request_, read_buf, gang.words_, done);
+    result.data = (done > 0) ? read_buf[done - 1] : 0;
+  }
+  else
+  {
+    result.ack = transfer.WriteBlock(gang.request_, gang.data_, gang.words_, done);
+  }
+  result.done = static_cast<uint8_t>(done);
+}
+
+SwdGang::SwdGang(const DapGangIo* io)
+{
+  if (io == nullptr)
+  {
+    return;
+  }
+
+  count_ = (io->count > kGangMaxPorts) ? kGangMaxPorts : io->count;
+  for (uint8_t i = 0; i < count_; i++)
+  {
+    ports_[i].emplace(*io->ports[i], *this);
+  }
+}
+
+uint8_t SwdGang::Run(Job job, uint8_t mask, PortResult* results)
+{
+  job_ = job;
+
+  uint8_t started = 0;
+  for (uint8_t i = 0; i < count_; i++)
+  {
+    if (mask & (1U << i))
+    {
+      ports_[i]->start_sem.Post();
+      started++;
+    }
+  }
+  for (uint8_t i = 0; i < started; i++)
+  {
+    done_sem_.Wait();
+  }
+
+  uint8_t ack = DAP_TRANSFER_OK;
+  for (uint8_t i = 0; i < count_; i++)
+  {
+    results[i] = (mask & (1U << i)) ? ports_[i]->result : PortResult{};
+    if ((mask & (1U << i)) && results[i].ack != DAP_TRANSFER_OK)
+    {
+      ack = results[i].ack;
+    }
+  }
+  return ack;
+}
+
+uint8_t SwdGang::Connect(uint8_t mask, PortResult* results)
+{
+  mask &= static_cast<uint8_t>((1U << count_) - 1);
+
+  const uint8_t ack = Run(Job::CONNECT, mask, results);
+
+  active_ = 0;
+  for (uint8_t i = 0; i < count_; i++)
+  {
+    if (results[i].ack == DAP_TRANSFER_OK && (mask & (1U << i)))
+    {
+      active_ |= static_cast<uint8_t>(1U << i);
+    }
+    else
+    {
+      ports_[i]->io.gpio_swdio.SetConfig(
+          {LibXR::GPIO::Direction::INPUT, LibXR::GPIO::Pull::NONE});
+    }
+  }
+  return ack;
+}
+
+uint8_t SwdGang::TransferBlock(uint8_t request, const uint32_t* data, uint32_t count,
+                               PortResult* results)
+{
+  if (count > kMaxBlockWords || active_ == 0)
+  {
+    for (uint8_t i = 0; i < count_; i++)
+    {
+      results[i] = {};
+    }
+    return DAP_TRANSFER_ERROR;
+  }
+
+  request_ = request;
+  data_ = data;
+  words_ = count;
+  return Run(Job::BLOCK, active_, results);
+}
+
+}  // namespace DAP
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "dap_config.hpp"
+#include "dap_io.hpp"
+#include "libxr.hpp"
+#include "swd_engine.hpp"
+#include "transfer_engine.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class SwdGang
+ * @brief Issues the same SWD transfers to several targets at once.
+ *
+ * Each port of the DapGangIo gets its own SWD and transfer engine and a worker
+ * thread, so the SPI transfers of all ports overlap while the caller waits for
+ * the slowest one. Results are reported per port in the DAP transfer response
+ * bits.
+ */
+class SwdGang
+{
+ public:
+  struct PortResult
+  {
+    uint8_t ack;    // DAP transfer response bits, 0 if the port did not take part
+    uint8_t done;   // Transfers completed
+    uint32_t data;  // DPIDR on connect, last value read by a read block
+  };
+
+  static constexpr uint32_t kMaxBlockWords = (kPacketSize - 5) / 4;
+
+  explicit SwdGang(const DapGangIo* io);
+
+  uint8_t PortCount() const { return count_; }
+  uint8_t ActiveMask() const { return active_; }
+
+  /**
+   * @brief Set up SWD on the selected ports and read their DPIDR
+   * @param mask Ports to use, bit n for port n; 0 releases all ports
+   * @param results Per port results, PortCount() entries
+   * @return DAP_TRANSFER_OK if every selected port answered
+   */
+  uint8_t Connect(uint8_t mask, PortResult* results);
+
+  /**
+   * @brief Run one transfer block on every connected port in parallel
+   * @param request DAP transfer request byte
+   * @param data Write data (ignored for reads)
+   * @param count Number of transfers, at most kMaxBlockWords
+   * @param results Per port results, PortCount() entries
+   * @return DAP_TRANSFER_OK if every connected port completed the block
+   */
+  uint8_t TransferBlock(uint8_t request, const uint32_t* data, uint32_t count,
+                        PortResult* results);
+
+  // Prevent copying
+  SwdGang(const SwdGang&) = delete;
+  SwdGang& operator=(const SwdGang&) = delete;
+
+ private:
+  enum class Job : uint8_t
+  {
+    CONNECT,
+    BLOCK,
+  };
+
+  struct Port
+  {
+    Port(DapIo& port_io, SwdGang& owner);
+
+    static void WorkerTask(Port* self);
+    void Execute();
+
+    DapIo& io;
+    SwdGang& gang;
+    SwdEngine swd;
+    TransferEngine transfer;
+    LibXR::Thread worker;
+    LibXR::Semaphore start_sem{0};
+    PortResult result = {};
+    uint32_t read_buf[kMaxBlockWords] = {};
+  };
+
+  uint8_t Run(Job job, uint8_t mask, PortResult* results);
+
+  std::array<std::optional<Port>, kGangMaxPorts> ports_;
+  uint8_t count_ = 0;
+  uint8_t active_ = 0;
+  LibXR::Semaphore done_sem_{0};
+
+  // Current job, read by the workers between start_sem and done_sem_
+  Job job_ = Job::CONNECT;
+  uint8_t request_ = 0;
+  const uint32_t* data_ = nullptr;
+  uint32_t words_ = 0;
+};
+
+}  // namespace DAP
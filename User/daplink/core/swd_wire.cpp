@@ -0,0 +1,48 @@
+#include "swd_wire.hpp"
+
+namespace DAP
+{
+
+SwdWire::SwdWire(DapIo& io) : io_(io) {}
+
+void SwdWire::Configure(uint8_t turnaround, bool data_phase)
+{
+  turnaround_ = (turnaround < 1) ? 1 : (turnaround > 4) ? 4 : turnaround;
+  data_phase_ = data_phase;
+}
+
+LibXR::ErrorCode SwdWire::Setup()
+{
+  // nRESET is open-drain, kept high (de-asserted)
+  auto err = io_.gpio_nreset.SetConfig({
+      LibXR::GPIO::Direction::OUTPUT_OPEN_DRAIN,
+      LibXR::GPIO::Pull::NONE  // NOTE - Assuming external pull-up
+  });
+  if (err != LibXR::ErrorCode::OK)
+  {
+    return err;
+  }
+  io_.gpio_nreset.Write(true);  // Deassert nRESET
+
+  err = SetupPins();
+  if (err != LibXR::ErrorCode::OK)
+  {
+    return err;
+  }
+
+  // JTAG-to-SWD switching: line reset, 16-bit sequence 0xE79E (LSB first), line reset
+  static const uint8_t jtag_to_swd[] = {0x9E, 0xE7};
+
+  err = LineReset();
+  if (err == LibXR::ErrorCode::OK)
+  {
+    err = SequenceOut(jtag_to_swd, 16);
+  }
+  if (err == LibXR::ErrorCode::OK)
+  {
+    err = LineReset();
+  }
+  return err;
+}
+
+}  // namespace DAP
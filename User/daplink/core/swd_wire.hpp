@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dap_io.hpp"
+#include "libxr.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class SwdWire
+ * @brief SWD wire layer interface, implemented by the SPI engine and the GPIO
+ *        bit-bang engine.
+ *
+ * Setup() is shared: it takes nRESET, lets the implementation claim its pins
+ * and sends the JTAG-to-SWD switching sequence.
+ */
+class SwdWire
+{
+ public:
+  explicit SwdWire(DapIo& io);
+  virtual ~SwdWire() = default;
+
+  /**
+   * @brief Configure pins for SWD and switch the target from JTAG
+   * @return ErrorCode indicating operation status
+   */
+  LibXR::ErrorCode Setup();
+
+  /**
+   * @brief Hand the pins back, before another engine takes them
+   */
+  virtual void Release() {}
+
+  /**
+   * @brief Set the SWCLK frequency requested by DAP_SWJ_Clock
+   * @param hz Clock frequency in Hz
+   */
+  virtual void SetClock(uint32_t hz) { UNUSED(hz); }
+
+  /**
+   * @brief Set the SWD turnaround period and data phase behaviour
+   * @param turnaround Turnaround period in clock cycles (1..4)
+   * @param data_phase Generate a data phase on WAIT/FAULT responses
+   */
+  void Configure(uint8_t turnaround, bool data_phase);
+
+  /**
+   * @brief Set idle cycles appended after each transfer
+   * @param idle_cycles Number of idle cycles
+   */
+  void SetIdleCycles(uint8_t idle_cycles) { idle_cycles_ = idle_cycles; }
+
+  /**
+   * @brief Execute one SWD packet without retry
+   * @param request DAP transfer request byte (APnDP, RnW, A2, A3)
+   * @param data Write data in, read data out
+   * @return DAP transfer response bits (ACK, or DAP_TRANSFER_ERROR on parity error)
+   */
+  virtual uint8_t Transfer(uint8_t request, uint32_t& data) = 0;
+
+  /**
+   * @brief Write DP TARGETSEL, whose ACK is not driven by the target
+   * @param value TARGETSEL value (TINSTANCE, TPARTNO, TDESIGNER)
+   * @return ErrorCode indicating operation status
+   */
+  virtual LibXR::ErrorCode TargetSel(uint32_t value) = 0;
+
+  /**
+   * @brief Clock out an SWDIO sequence, LSB first
+   * @param data Sequence bits
+   * @param bit_count Number of bits
+   * @return ErrorCode indicating operation status
+   */
+  virtual LibXR::ErrorCode SequenceOut(const uint8_t* data, uint32_t bit_count) = 0;
+
+  /**
+   * @brief Clock in an SWDIO sequence while the host releases the line
+   * @param data Captured bits, LSB first
+   * @param bit_count Number of bits
+   * @return ErrorCode indicating operation status
+   */
+  virtual LibXR::ErrorCode SequenceIn(uint8_t* data, uint32_t bit_count) = 0;
+
+  /**
+   * @brief SWD line reset: 56 cycles high followed by idle cycles
+   * @return ErrorCode indicating operation status
+   */
+  virtual LibXR::ErrorCode LineReset() = 0;
+
+ protected:
+  /**
+   * @brief Claim SWCLK and SWDIO for this engine
+   * @return ErrorCode indicating operation status
+   */
+  virtual LibXR::ErrorCode SetupPins() = 0;
+
+  DapIo& io_;
+
+  uint8_t turnaround_ = 1;
+  bool data_phase_ = false;
+  uint8_t idle_cycles_ = 0;
+};
+
+}  // namespace DAP
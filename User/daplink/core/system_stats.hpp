@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DAP
+{
+
+/**
+ * @class SystemStats
+ * @brief Task and heap usage of the probe firmware, reported by SYS_Stats.
+ *
+ * Implemented by the RTOS port, so the DAP core does not depend on FreeRTOS.
+ * Run times are in ticks of the run-time stats timer; a task's CPU share is
+ * its run time over the total run time of the same snapshot.
+ */
+class SystemStats
+{
+ public:
+  static constexpr size_t kNameSize = 16;
+
+  struct Task
+  {
+    uint8_t number = 0;       // Task number, stable for the life of the task
+    uint8_t state = 0;        // eTaskState: running, ready, blocked, ...
+    uint8_t priority = 0;
+    uint32_t stack_free = 0;  // Stack high-water mark in words, lowest ever free
+    uint32_t run_time = 0;
+    char name[kNameSize] = {};  // Not terminated if all kNameSize bytes are used
+  };
+
+  struct Heap
+  {
+    uint32_t size = 0;
+    uint32_t free = 0;
+    uint32_t min_free = 0;  // Lowest free since boot
+  };
+
+  virtual ~SystemStats() = default;
+
+  /**
+   * @brief Snapshot tasks, ordered by task number
+   * @param first Lowest task number to return
+   * @param tasks Destination
+   * @param max_tasks Maximum tasks to return
+   * @param total_run_time Total run time of the snapshot
+   * @return Tasks copied
+   */
+  virtual size_t ReadTasks(uint8_t first, Task* tasks, size_t max_tasks,
+                           uint32_t& total_run_time) = 0;
+
+  virtual Heap ReadHeap() = 0;
+
+  /**
+   * @brief Rate of the run-time stats timer in Hz
+   */
+  virtual uint32_t RunTimeHz() const = 0;
+};
+
+}  // namespace DAP
@@ -0,0 +1,209 @@
+#include "transfer_engine.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+constexpr uint8_t kRdBuffRead = DAP_TRANSFER_RnW | DP_RDBUFF;
+
+inline bool IsSelectWrite(uint8_t request)
+{
+  return (request & (DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | DAP_TRANSFER_A2 |
+                     DAP_TRANSFER_A3)) == DP_SELECT;
+}
+
+inline bool IsTargetSelWrite(uint8_t request)
+{
+  return (request & (DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | DAP_TRANSFER_A2 |
+                     DAP_TRANSFER_A3)) == DP_TARGETSEL;
+}
+
+}  // namespace
+
+TransferEngine::TransferEngine(SwdWire& swd) : swd_(&swd) {}
+
+void TransferEngine::SetWire(SwdWire& swd)
+{
+  swd_ = &swd;
+  swd_->SetIdleCycles(config_.idle_cycles);
+  select_valid_ = false;
+  target_valid_ = false;
+}
+
+void TransferEngine::SetConfig(const TransferConfig& config)
+{
+  config_ = config;
+  swd_->SetIdleCycles(config.idle_cycles);
+}
+
+void TransferEngine::Count(uint8_t ack)
+{
+  stats_.packets++;
+  switch (ack)
+  {
+    case DAP_TRANSFER_OK:
+      break;
+    case DAP_TRANSFER_WAIT:
+      stats_.waits++;
+      break;
+    case DAP_TRANSFER_FAULT:
+      stats_.faults++;
+      break;
+    case DAP_TRANSFER_ERROR:
+      stats_.parity_errors++;
+      break;
+    default:
+      stats_.protocol_errors++;
+      break;
+  }
+}
+
+uint8_t TransferEngine::Transfer(uint8_t request, uint32_t& data)
+{
+  if (IsTargetSelWrite(request))
+  {
+    // No target drives the ACK; the write cannot be retried or checked
+    if (swd_->TargetSel(data) != LibXR::ErrorCode::OK)
+    {
+      return DAP_TRANSFER_ERROR;
+    }
+    target_ = data;
+    target_valid_ = true;
+    select_valid_ = false;  // SELECT is per target
+    return DAP_TRANSFER_OK;
+  }
+
+  uint8_t ack = 0;
+  uint16_t retry = config_.retry_count;
+
+  do
+  {
+    ack = swd_->Transfer(request, data);
+    Count(ack);
+  } while (ack == DAP_TRANSFER_WAIT && retry-- != 0 && !abort_);
+
+  if (IsSelectWrite(request))
+  {
+    select_ = data;
+    select_valid_ = (ack == DAP_TRANSFER_OK);
+  }
+
+  return ack;
+}
+
+uint8_t TransferEngine::ReadDp(uint8_t reg, uint32_t& value)
+{
+  return Transfer(DAP_TRANSFER_RnW | (reg & 0x0C), value);
+}
+
+uint8_t TransferEngine::WriteDp(uint8_t reg, uint32_t value)
+{
+  return Transfer(reg & 0x0C, value);
+}
+
+uint8_t TransferEngine::Select(uint32_t value)
+{
+  if (select_valid_ && select_ == value)
+  {
+    return DAP_TRANSFER_OK;
+  }
+  return WriteDp(DP_SELECT, value);
+}
+
+uint8_t TransferEngine::SwitchTarget(uint32_t targetsel, uint32_t& dpidr)
+{
+  target_valid_ = false;
+
+  // The line reset ends with idle cycles, as TARGETSEL requires
+  if (swd_->LineReset() != LibXR::ErrorCode::OK)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+  WriteDp(DP_TARGETSEL, targetsel);
+
+  // DPIDR read leaves the reset state; no response means no such target
+  const uint8_t ack = ReadDp(DP_IDCODE, dpidr);
+  target_valid_ = (ack == DAP_TRANSFER_OK);
+  return ack;
+}
+
+uint8_t TransferEngine::ReadAp(uint8_t reg, uint32_t& value)
+{
+  uint8_t ack = Transfer(DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | (reg & 0x0C), value);
+  if (ack != DAP_TRANSFER_OK)
+  {
+    return ack;
+  }
+  return Transfer(kRdBuffRead, value);
+}
+
+uint8_t TransferEngine::WriteAp(uint8_t reg, uint32_t value)
+{
+  return Transfer(DAP_TRANSFER_APnDP | (reg & 0x0C), value);
+}
+
+uint8_t TransferEngine::ReadBlock(uint8_t request, uint32_t* data, uint32_t count,
+                                  uint32_t& done)
+{
+  done = 0;
+  if (count == 0)
+  {
+    return DAP_TRANSFER_OK;
+  }
+
+  uint8_t ack = DAP_TRANSFER_OK;
+
+  if ((request & DAP_TRANSFER_APnDP) == 0)
+  {
+    while (done < count)
+    {
+      ack = Transfer(request, data[done]);
+      if (ack != DAP_TRANSFER_OK || abort_)
+      {
+        return ack;
+      }
+      done++;
+    }
+    return ack;
+  }
+
+  // AP reads are posted: each read returns the previous value, RDBUFF the last
+  uint32_t dummy = 0;
+  ack = Transfer(request, dummy);
+  while (ack == DAP_TRANSFER_OK && done < count && !abort_)
+  {
+    const uint8_t next = (done + 1 == count) ? kRdBuffRead : request;
+    ack = Transfer(next, data[done]);
+    if (ack == DAP_TRANSFER_OK)
+    {
+      done++;
+    }
+  }
+  return ack;
+}
+
+uint8_t TransferEngine::WriteBlock(uint8_t request, const uint32_t* data, uint32_t count,
+                                   uint32_t& done)
+{
+  done = 0;
+  uint8_t ack = DAP_TRANSFER_OK;
+
+  while (done < count && !abort_)
+  {
+    uint32_t value = data[done];
+    ack = Transfer(request, value);
+    if (ack != DAP_TRANSFER_OK)
+    {
+      return ack;
+    }
+    done++;
+  }
+
+  // Posted writes complete once RDBUFF reads back OK
+  uint32_t dummy = 0;
+  return Transfer(kRdBuffRead, dummy);
+}
+
+}  // namespace DAP
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dap_constants.hpp"
+#include "swd_wire.hpp"
+
+namespace DAP
+{
+
+constexpr uint16_t kDefaultRetryCount = 100;
+constexpr uint8_t kDefaultIdleCycles = 0;
+
+struct TransferConfig
+{
+  uint8_t idle_cycles = kDefaultIdleCycles;
+  uint16_t retry_count = kDefaultRetryCount;
+  uint16_t match_retry = 0;
+  uint32_t match_mask = 0;
+};
+
+/**
+ * @brief SWD packet outcomes seen by Transfer(), each WAIT retry counted
+ */
+struct TransferStats
+{
+  uint32_t packets = 0;
+  uint32_t waits = 0;
+  uint32_t faults = 0;
+  uint32_t parity_errors = 0;    // DAP_TRANSFER_ERROR: read parity or wire failure
+  uint32_t protocol_errors = 0;  // No valid ACK
+};
+
+/**
+ * @class TransferEngine
+ * @brief DP/AP register access on top of the SWD wire layer.
+ *
+ * Adds WAIT retry, abort, the posted AP read pipeline and a shadow of DP SELECT,
+ * and is shared by DAP_Transfer/TransferBlock and the probe-side features.
+ * Results use the DAP transfer response bits (DAP_TRANSFER_OK on success).
+ */
+class TransferEngine
+{
+ public:
+  explicit TransferEngine(SwdWire& swd);
+
+  /**
+   * @brief Run subsequent transfers on another SWD engine
+   * @param swd SWD wire layer
+   */
+  void SetWire(SwdWire& swd);
+
+  void SetConfig(const TransferConfig& config);
+  const TransferConfig& GetConfig() const { return config_; }
+  TransferConfig& MutableConfig() { return config_; }
+
+  const TransferStats& GetStats() const { return stats_; }
+  void ResetStats() { stats_ = TransferStats(); }
+
+  void Abort() { abort_ = true; }
+  void ClearAbort() { abort_ = false; }
+  bool Aborted() const { return abort_; }
+
+  /**
+   * @brief Single DP/AP transfer with WAIT retry
+   * @param request DAP transfer request byte
+   * @param data Write data in, read data out (AP reads return the posted value)
+   * @return DAP transfer response bits
+   */
+  uint8_t Transfer(uint8_t request, uint32_t& data);
+
+  uint8_t ReadDp(uint8_t reg, uint32_t& value);
+  uint8_t WriteDp(uint8_t reg, uint32_t value);
+
+  /**
+   * @brief Write DP SELECT unless the shadow already holds the value
+   * @param value SELECT value
+   * @return DAP transfer response bits
+   */
+  uint8_t Select(uint32_t value);
+  uint32_t GetSelect() const { return select_; }
+  bool SelectValid() const { return select_valid_; }
+  void InvalidateSelect() { select_valid_ = false; }
+
+  /**
+   * @brief Select a multi-drop target: line reset, TARGETSEL, DPIDR read
+   * @param targetsel TARGETSEL value
+   * @param dpidr DPIDR of the newly selected target
+   * @return DAP transfer response bits of the DPIDR read
+   */
+  uint8_t SwitchTarget(uint32_t targetsel, uint32_t& dpidr);
+
+  /**
+   * @brief Last TARGETSEL written, valid until the next SWD line setup
+   */
+  bool TargetSelected() const { return target_valid_; }
+  uint32_t GetTarget() const { return target_; }
+  void InvalidateTarget() { target_valid_ = false; }
+
+  /**
+   * @brief Non-posted AP read in the currently selected bank
+   * @param reg AP register address (A3:A2 used)
+   * @param value Read value
+   * @return DAP transfer response bits
+   */
+  uint8_t ReadAp(uint8_t reg, uint32_t& value);
+  uint8_t WriteAp(uint8_t reg, uint32_t value);
+
+  /**
+   * @brief Repeated reads of one register, AP reads pipelined through RDBUFF
+   * @param request DAP transfer request byte (RnW set)
+   * @param data Read values
+   * @param count Number of reads
+   * @param done Number of values stored
+   * @return DAP transfer response bits
+   */
+  uint8_t ReadBlock(uint8_t request, uint32_t* data, uint32_t count, uint32_t& done);
+
+  /**
+   * @brief Repeated writes of one register, completion checked via RDBUFF
+   * @param request DAP transfer request byte (RnW clear)
+   * @param data Values to write
+   * @param count Number of writes
+   * @param done Number of values written
+   * @return DAP transfer response bits
+   */
+  uint8_t WriteBlock(uint8_t request, const uint32_t* data, uint32_t count,
+                     uint32_t& done);
+
+ private:
+  void Count(uint8_t ack);
+
+  SwdWire* swd_;
+  TransferConfig config_;
+  TransferStats stats_;
+  volatile bool abort_ = false;
+
+  uint32_t select_ = 0;
+  bool select_valid_ = false;
+
+  uint32_t target_ = 0;
+  bool target_valid_ = false;
+};
+
+}  // namespace DAP
@@ -0,0 +1,193 @@
+#include "wch_rvswd.hpp"
+
+#include <cstring>
+
+#include "dap_config.hpp"
+#include "dap_constants.hpp"
+
+namespace DAP
+{
+
+namespace
+{
+
+constexpr uint32_t kSpiTimeoutMs = 10;
+
+// Frame layout, bit positions from the start of the SPI transfer (MSB first)
+constexpr uint8_t kAddrBits = 7;
+constexpr uint32_t kReqAddrPos = 0;
+constexpr uint32_t kReqDataPos = kReqAddrPos + kAddrBits;
+constexpr uint32_t kReqOpPos = kReqDataPos + 32;
+constexpr uint32_t kReqParityPos = kReqOpPos + 2;
+constexpr uint32_t kRespStatusPos = kReqParityPos + 1 + 1;  // After turnaround
+constexpr uint32_t kRespDataPos = kRespStatusPos + 2;
+constexpr uint32_t kRespParityPos = kRespDataPos + 32;
+constexpr uint32_t kRespEndPos = kRespParityPos + 1;
+
+constexpr uint8_t DMI_OP_READ = 1;
+constexpr uint8_t DMI_OP_WRITE = 2;
+constexpr uint8_t DMI_STATUS_OK = 0;
+constexpr uint8_t DMI_STATUS_BUSY = 3;
+constexpr uint8_t kFrameError = 0xFF;
+
+constexpr uint32_t DMSTATUS_VERSION_MASK = 0xF;
+constexpr uint32_t DMSTATUS_VERSION_013 = 2;
+constexpr uint32_t DMCONTROL_DMACTIVE = (1UL << 0);
+
+inline void PutBits(uint8_t* buf, uint32_t pos, uint32_t value, uint8_t bits)
+{
+  for (uint8_t i = bits; i > 0; i--, pos++)
+  {
+    const auto mask = static_cast<uint8_t>(0x80U >> (pos & 7));
+    if (value & (1UL << (i - 1)))
+    {
+      buf[pos >> 3] |= mask;
+    }
+    else
+    {
+      buf[pos >> 3] &= static_cast<uint8_t>(~mask);
+    }
+  }
+}
+
+inline uint32_t GetBits(const uint8_t* buf, uint32_t pos, uint8_t bits)
+{
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < bits; i++, pos++)
+  {
+    value = (value << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1U);
+  }
+  return value;
+}
+
+inline uint32_t Parity(uint32_t v)
+{
+  v ^= v >> 16;
+  v ^= v >> 8;
+  v ^= v >> 4;
+  v ^= v >> 2;
+  v ^= v >> 1;
+  return v & 1U;
+}
+
+}  // namespace
+
+WchRvswd::WchRvswd(DapIo& io) : io_(io) {}
+
+void WchRvswd::Start()
+{
+  // Clock idles high: a falling data edge is START
+  io_.gpio_swdio.Write(false);
+  io_.gpio_swdio.SetConfig({LibXR::GPIO::Direction::INPUT, LibXR::GPIO::Pull::NONE});
+}
+
+void WchRvswd::Stop()
+{
+  // MOSI was left low by the frame tail: a rising data edge is STOP
+  io_.gpio_swdio.Write(false);
+  io_.gpio_swdio.SetConfig(
+      {LibXR::GPIO::Direction::OUTPUT_PUSH_PULL, LibXR::GPIO::Pull::NONE});
+  io_.gpio_swdio.Write(true);
+}
+
+uint8_t WchRvswd::Frame(uint8_t op, uint8_t addr, uint32_t& data)
+{
+  static_assert(kFrameBytes * 8 >= kRespEndPos + 2, "Frame needs >= 2 low tail bits");
+
+  // Host releases the line (MOSI high) while the target answers
+  std::memset(tx_buf_, 0xFF, kFrameBytes);
+  PutBits(tx_buf_, kReqAddrPos, addr, kAddrBits);
+  PutBits(tx_buf_, kReqDataPos, data, 32);
+  PutBits(tx_buf_, kReqOpPos, op, 2);
+  PutBits(tx_buf_, kReqParityPos, Parity(addr ^ data ^ op), 1);
+  PutBits(tx_buf_, kRespEndPos, 0, static_cast<uint8_t>(kFrameBytes * 8 - kRespEndPos));
+
+  Start();
+  LibXR::WriteOperation write_op(spi_sem_, kSpiTimeoutMs);
+  const auto err =
+      io_.spi.ReadAndWrite({rx_buf_, kFrameBytes}, {tx_buf_, kFrameBytes}, write_op);
+  Stop();
+  if (err != LibXR::ErrorCode::OK)
+  {
+    return kFrameError;
+  }
+
+  const auto status = static_cast<uint8_t>(GetBits(rx_buf_, kRespStatusPos, 2));
+  const uint32_t value = GetBits(rx_buf_, kRespDataPos, 32);
+  if (GetBits(rx_buf_, kRespParityPos, 1) != Parity(status ^ value))
+  {
+    return kFrameError;
+  }
+
+  if (op == DMI_OP_READ)
+  {
+    data = value;
+  }
+  return status;
+}
+
+uint8_t WchRvswd::Access(uint8_t op, uint8_t addr, uint32_t& data)
+{
+  for (uint32_t retry = 0; retry <= kDmiBusyRetries; retry++)
+  {
+    const uint8_t status = Frame(op, addr, data);
+    if (status == DMI_STATUS_OK)
+    {
+      return DAP_TRANSFER_OK;
+    }
+    if (status != DMI_STATUS_BUSY)
+    {
+      return DAP_TRANSFER_ERROR;
+    }
+  }
+  return DAP_TRANSFER_WAIT;
+}
+
+uint8_t WchRvswd::Connect(uint32_t& dmstatus)
+{
+  dmstatus = 0;
+
+  // Debug clock idles high; data changes on the falling edge
+  auto err = io_.spi.SetConfig(
+      {LibXR::SPI::ClockPolarity::HIGH, LibXR::SPI::ClockPhase::EDGE_2});
+  if (err != LibXR::ErrorCode::OK)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  // Idle state: direct pin holds the line high, MOSI parked low
+  Stop();
+  tx_buf_[0] = 0x00;
+  LibXR::WriteOperation op(spi_sem_, kSpiTimeoutMs);
+  err = io_.spi.ReadAndWrite({rx_buf_, 1}, {tx_buf_, 1}, op);
+  if (err != LibXR::ErrorCode::OK)
+  {
+    return DAP_TRANSFER_ERROR;
+  }
+
+  uint32_t value = DMCONTROL_DMACTIVE;
+  uint8_t ack = Access(DMI_OP_WRITE, DM_DMCONTROL, value);
+  if (ack == DAP_TRANSFER_OK)
+  {
+    ack = Access(DMI_OP_READ, DM_DMSTATUS, dmstatus);
+  }
+  if (ack == DAP_TRANSFER_OK &&
+      (dmstatus & DMSTATUS_VERSION_MASK) != DMSTATUS_VERSION_013)
+  {
+    ack = DAP_TRANSFER_ERROR;
+  }
+  return ack;
+}
+
+uint8_t WchRvswd::Read(uint8_t addr, uint32_t& value)
+{
+  value = 0;
+  return Access(DMI_OP_READ, addr, value);
+}
+
+uint8_t WchRvswd::Write(uint8_t addr, uint32_t value)
+{
+  return Access(DMI_OP_WRITE, addr, value);
+}
+
+}  // namespace DAP
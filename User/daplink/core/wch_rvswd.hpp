@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dap_io.hpp"
+#include "dmi_port.hpp"
+#include "libxr.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class WchRvswd
+ * @brief WCH single-wire debug (RVSWD/SDI) access to the RISC-V Debug Module.
+ *
+ * Uses the SWD wiring: the SPI clock idles high as the debug clock and MOSI
+ * drives the data line through the series resistor. START and STOP are edges
+ * on the data line while the clock is high, so they are generated with the
+ * direct gpio_swdio pin, which overrides MOSI. Between frames gpio_swdio keeps
+ * driving the line high; each frame ends with MOSI low so that releasing the
+ * pin after START does not look like a STOP.
+ *
+ * A frame carries one DMI access in the JTAG DMI register layout, MSB first:
+ * host sends address(7), data(32), op(2) and even parity, one turnaround cycle,
+ * then the target answers status(2), data(32) and parity. Results use the DAP
+ * transfer response bits (WAIT when the DM stays busy).
+ *
+ * This layout, the turnaround width, the response parity and the START/STOP
+ * handling have not been checked against a WCH-Link capture or WCH
+ * documentation, so WCH_Connect stays out of the command table (kRvswdEnabled)
+ * until they are.
+ */
+class WchRvswd : public DmiPort
+{
+ public:
+  explicit WchRvswd(DapIo& io);
+
+  /**
+   * @brief Switch the pins to RVSWD and read the debug module status
+   * @param dmstatus DMSTATUS value
+   * @return DAP transfer response bits, ERROR without a 0.13 debug module
+   */
+  uint8_t Connect(uint32_t& dmstatus);
+
+  uint8_t Read(uint8_t addr, uint32_t& value) override;
+  uint8_t Write(uint8_t addr, uint32_t value) override;
+
+ private:
+  /**
+   * @brief One START, frame, STOP sequence
+   * @param op DMI operation (1 read, 2 write)
+   * @param addr DM register address
+   * @param data Write data in, read data out
+   * @return DMI status field, or 0xFF on a bus or parity error
+   */
+  uint8_t Frame(uint8_t op, uint8_t addr, uint32_t& data);
+
+  /**
+   * @brief Frame with busy retry, mapped to DAP transfer response bits
+   */
+  uint8_t Access(uint8_t op, uint8_t addr, uint32_t& data);
+
+  void Start();
+  void Stop();
+
+  static constexpr uint8_t kFrameBytes = 10;
+
+  DapIo& io_;
+  LibXR::Semaphore spi_sem_{0};
+  uint8_t tx_buf_[kFrameBytes] = {};
+  uint8_t rx_buf_[kFrameBytes] = {};
+};
+
+}  // namespace DAP
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+
+#include "cdc_base.hpp"
+#include "dap_config.hpp"
+#include "rtt_engine.hpp"
+
+namespace LibXR::USB
+{
+
+class CDCRttStream : public CDCBase, public DAP::RttSink
+{
+ public:
+  /**
+   * @brief CDC-ACM port carrying the target's RTT up-buffer to the host
+   * @param data_in_ep_num Bulk IN endpoint number
+   * @param data_out_ep_num Bulk OUT endpoint number
+   * @param comm_ep_num Interrupt notification endpoint number
+   *
+   * The DAP worker fills a ring through the RttSink interface while RTT_Start
+   * has streaming on. IN transfers drain it, chained from the completion
+   * interrupt like the UART bridge. The ring only takes what fits, so data the
+   * host does not read stays in the target's up-buffer. OUT data is discarded;
+   * host input goes to the down-buffer with RTT_Write.
+   */
+  CDCRttStream(Endpoint::EPNumber data_in_ep_num = Endpoint::EPNumber::EP_AUTO,
+               Endpoint::EPNumber data_out_ep_num = Endpoint::EPNumber::EP_AUTO,
+               Endpoint::EPNumber comm_ep_num = Endpoint::EPNumber::EP_AUTO)
+      : CDCBase(data_in_ep_num, data_out_ep_num, comm_ep_num)
+  {
+  }
+
+  size_t Space() const override
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return (tail + DAP::kRttStreamSize - head - 1) % DAP::kRttStreamSize;
+  }
+
+  void Write(const uint8_t* data, size_t len) override
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < len; i++)
+    {
+      ring_[head] = data[i];
+      head = (head + 1) % DAP::kRttStreamSize;
+    }
+    head_.store(head, std::memory_order_release);
+
+    KickIn();
+  }
+
+ private:
+  uint8_t ring_[DAP::kRttStreamSize] = {};
+  std::atomic<size_t> head_{0};  // Written by the DAP worker only
+  std::atomic<size_t> tail_{0};  // Written by the IN submitter only
+
+  std::atomic<bool> in_busy_{false};
+  bool in_last_full_ = false;  // Previous IN packet was max size, ZLP may be due
+
+  /**
+   * @brief Start an IN transfer if the endpoint is idle and data is queued
+   *
+   * Runs from the DAP worker and the IN completion interrupt; in_busy_ lets
+   * only one of them submit.
+   */
+  void KickIn()
+  {
+    while (!in_busy_.exchange(true))
+    {
+      Endpoint* ep = GetDataInEndpoint();
+      RawData buffer = ep->GetBuffer();
+      auto* out = static_cast<uint8_t*>(buffer.addr_);
+
+      size_t tail = tail_.load(std::memory_order_relaxed);
+      const size_t head = head_.load(std::memory_order_acquire);
+      size_t len = 0;
+      while (tail != head && len < ep->MaxPacketSize())
+      {
+        out[len++] = ring_[tail];
+        tail = (tail + 1) % DAP::kRttStreamSize;
+      }
+      tail_.store(tail, std::memory_order_release);
+
+      if (len == 0 && !in_last_full_)
+      {
+        in_busy_ = false;
+        // Bytes written after head was read would otherwise wait for the next
+        // Write(); check once more now that the endpoint is free
+        if (head_.load(std::memory_order_acquire) == tail)
+        {
+          return;
+        }
+        continue;
+      }
+
+      // A full packet with nothing behind it is terminated by a ZLP
+      in_last_full_ = (len == ep->MaxPacketSize());
+      if (ep->Transfer(len) != ErrorCode::OK)
+      {
+        in_busy_ = false;
+      }
+      return;
+    }
+  }
+
+ protected:
+  /**
+   * @brief Host data arrived on the bulk OUT endpoint, dropped
+   * @param in_isr Whether called from interrupt context
+   * @param data Received data
+   */
+  void OnDataOutComplete(bool in_isr, ConstRawData& data) override
+  {
+    UNUSED(in_isr);
+    UNUSED(data);
+
+    GetDataOutEndpoint()->Transfer(GetDataOutEndpoint()->MaxPacketSize());
+  }
+
+  /**
+   * @brief Bulk IN transfer finished, chain the next one
+   * @param in_isr Whether called from interrupt context
+   * @param data Transferred data
+   */
+  void OnDataInComplete(bool in_isr, ConstRawData& data) override
+  {
+    UNUSED(in_isr);
+    UNUSED(data);
+
+    in_busy_ = false;
+    KickIn();
+  }
+};
+
+}  // namespace LibXR::USB
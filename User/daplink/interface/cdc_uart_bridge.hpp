@@ -0,0 +1,239 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+
+#include "cdc_base.hpp"
+#include "dap_config.hpp"
+#include "uart.hpp"
+
+namespace LibXR::USB
+{
+
+class CDCUartBridge : public CDCBase
+{
+ public:
+  /**
+   * @brief CDC-ACM virtual COM port bridged to a hardware UART
+   * @param uart UART backing the port, configured with DMA RX/TX buffers
+   * @param data_in_ep_num Bulk IN endpoint number
+   * @param data_out_ep_num Bulk OUT endpoint number
+   * @param comm_ep_num Interrupt notification endpoint number
+   *
+   * OUT packets are handed to the UART straight from the endpoint buffer, and the
+   * endpoint is re-armed only after the UART accepted them, so a slow line NAKs
+   * the host instead of dropping data. UART RX bytes are read directly into the
+   * IN endpoint buffer. Each IN completion chains the next submission from the
+   * interrupt; the pump thread only restarts the chain when the line was idle.
+   */
+  CDCUartBridge(LibXR::UART& uart,
+                Endpoint::EPNumber data_in_ep_num = Endpoint::EPNumber::EP_AUTO,
+                Endpoint::EPNumber data_out_ep_num = Endpoint::EPNumber::EP_AUTO,
+                Endpoint::EPNumber comm_ep_num = Endpoint::EPNumber::EP_AUTO)
+      : CDCBase(data_in_ep_num, data_out_ep_num, comm_ep_num), uart_(uart)
+  {
+    pump_.Create<CDCUartBridge*>(this, PumpTask, "cdc_pump", DAP::kCdcPumpStackSize,
+                                 LibXR::Thread::Priority::HIGH);
+  }
+
+ private:
+  // CDC PSTN class request and line coding layout (USB CDC PSTN 1.2, 6.3.11)
+  static constexpr uint8_t SET_LINE_CODING = 0x20;
+  static constexpr size_t LINE_CODING_SIZE = 7;
+
+  LibXR::UART& uart_;
+  LibXR::Thread pump_;
+
+  std::atomic<bool> in_busy_{false};
+  bool in_last_full_ = false;  // Previous IN packet was max size, ZLP may be due
+
+  // OUT packet the UART could not take yet, still owned by the endpoint buffer
+  ConstRawData out_pending_{nullptr, 0};
+  volatile bool out_stalled_ = false;
+
+  LibXR::WriteOperation write_op_;  // UART operations stay valid while queued
+  LibXR::ReadOperation read_op_;
+
+  // Written by the USB interrupt, which bumps line_coding_seq_ after each update.
+  // The pump copies it and keeps the copy only if the sequence did not move
+  // meanwhile, so it never applies a half-written configuration.
+  LibXR::UART::Configuration line_coding_ = {DAP::kCdcDefaultBaudrate,
+                                             LibXR::UART::Parity::NO_PARITY, 8, 1};
+  std::atomic<uint32_t> line_coding_seq_{0};
+  uint32_t line_coding_applied_ = 0;  // Pump only
+
+  /**
+   * @brief Background pump, applies line coding and restarts stalled directions
+   * @param self Owning bridge
+   */
+  static void PumpTask(CDCUartBridge* self)
+  {
+    while (true)
+    {
+      self->ApplyLineCoding();
+
+      if (self->out_stalled_ && self->ForwardOut(false))
+      {
+        self->out_stalled_ = false;
+        self->GetDataOutEndpoint()->Transfer(self->GetDataOutEndpoint()->MaxPacketSize());
+      }
+
+      self->KickIn(false);
+
+      LibXR::Thread::Sleep(DAP::kCdcPumpPeriodMs);
+    }
+  }
+
+  /**
+   * @brief Copy the latest line coding out of the interrupt's hands and apply it
+   */
+  void ApplyLineCoding()
+  {
+    const uint32_t seq = line_coding_seq_.load(std::memory_order_acquire);
+    if (seq == line_coding_applied_)
+    {
+      return;
+    }
+
+    const LibXR::UART::Configuration config = line_coding_;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (line_coding_seq_.load(std::memory_order_relaxed) != seq)
+    {
+      return;  // Updated mid-copy, the next pass takes the new one
+    }
+
+    line_coding_applied_ = seq;
+    uart_.SetConfig(config);
+  }
+
+  /**
+   * @brief Push the pending OUT packet into the UART TX queue
+   * @param in_isr Whether called from interrupt context
+   * @return true if the UART accepted the whole packet
+   */
+  bool ForwardOut(bool in_isr)
+  {
+    UNUSED(in_isr);
+
+    return uart_.Write(out_pending_, write_op_) == ErrorCode::OK;
+  }
+
+  /**
+   * @brief Start an IN transfer if the endpoint is idle and UART data is ready
+   * @param in_isr Whether called from interrupt context
+   */
+  void KickIn(bool in_isr)
+  {
+    UNUSED(in_isr);
+
+    if (in_busy_.exchange(true))
+    {
+      return;
+    }
+
+    Endpoint* ep = GetDataInEndpoint();
+    RawData buffer = ep->GetBuffer();
+    size_t available = uart_.read_port_->Size();
+    size_t len = (available > ep->MaxPacketSize()) ? ep->MaxPacketSize() : available;
+
+    if (len == 0 && !in_last_full_)
+    {
+      in_busy_ = false;
+      return;
+    }
+
+    if (len > 0)
+    {
+      uart_.Read({buffer.addr_, len}, read_op_);
+    }
+
+    // A full packet with nothing behind it is terminated by a ZLP
+    in_last_full_ = (len == ep->MaxPacketSize());
+    if (ep->Transfer(len) != ErrorCode::OK)
+    {
+      in_busy_ = false;
+    }
+  }
+
+ protected:
+  /**
+   * @brief Host data arrived on the bulk OUT endpoint
+   * @param in_isr Whether called from interrupt context
+   * @param data Received data, located in the endpoint buffer
+   */
+  void OnDataOutComplete(bool in_isr, ConstRawData& data) override
+  {
+    out_pending_ = data;
+    if (data.size_ == 0 || ForwardOut(in_isr))
+    {
+      GetDataOutEndpoint()->Transfer(GetDataOutEndpoint()->MaxPacketSize());
+    }
+    else
+    {
+      // UART queue full, the pump retries and re-arms the endpoint
+      out_stalled_ = true;
+    }
+  }
+
+  /**
+   * @brief Bulk IN transfer finished, chain the next one
+   * @param in_isr Whether called from interrupt context
+   * @param data Transferred data
+   */
+  void OnDataInComplete(bool in_isr, ConstRawData& data) override
+  {
+    UNUSED(data);
+
+    in_busy_ = false;
+    KickIn(in_isr);
+  }
+
+  /**
+   * @brief Handle class request data stage, applies SET_LINE_CODING live
+   * @param in_isr Whether called from interrupt context
+   * @param bRequest Class request code
+   * @param data Data stage payload
+   * @return ErrorCode indicating operation status
+   */
+  ErrorCode OnClassData(bool in_isr, uint8_t bRequest, ConstRawData& data) override
+  {
+    const bool set_coding = bRequest == SET_LINE_CODING && data.size_ >= LINE_CODING_SIZE;
+    const auto* coding = static_cast<const uint8_t*>(data.addr_);
+    uint32_t baudrate = 0;
+    if (set_coding)
+    {
+      std::memcpy(&baudrate, coding, sizeof(baudrate));
+
+      // bCharFormat: 0 = 1 stop bit, 1 = 1.5 stop bits, 2 = 2 stop bits
+      // bParityType: 0 = none, 1 = odd, 2 = even, 3 = mark, 4 = space
+      // The USART frames 8 data bits (9 on the wire with parity), 1 or 2 stop
+      // bits and no mark/space parity; stall anything else before CDCBase
+      // stores it for GET_LINE_CODING
+      if (baudrate == 0 || coding[4] == 1 || coding[4] > 2 || coding[5] > 2 ||
+          coding[6] != 8)
+      {
+        return ErrorCode::NOT_SUPPORT;
+      }
+    }
+
+    ErrorCode ans = CDCBase::OnClassData(in_isr, bRequest, data);
+    if (ans != ErrorCode::OK || !set_coding)
+    {
+      return ans;
+    }
+
+    line_coding_.baudrate = baudrate;
+    line_coding_.stop_bits = (coding[4] == 2) ? 2 : 1;
+    line_coding_.parity = (coding[5] == 1)   ? LibXR::UART::Parity::ODD
+                          : (coding[5] == 2) ? LibXR::UART::Parity::EVEN
+                                             : LibXR::UART::Parity::NO_PARITY;
+    line_coding_.data_bits = 8;
+
+    // Reconfiguring the USART touches its DMA streams, leave it to the pump
+    line_coding_seq_.fetch_add(1, std::memory_order_release);
+
+    return ErrorCode::OK;
+  }
+};
+
+}  // namespace LibXR::USB
@@ -3,6 +3,7 @@
 #include <array>
 #include <cstring>
 
+#include "dap_config.hpp"
 #include "dap_protocol.hpp"
 #include "hid.hpp"
 
@@ -36,16 +37,165 @@ class HIDCmsisDap : public HID<sizeof(CMSIS_DAP_REPORT_DESC), 64, 64>
    * @param io DAP I/O interface reference
    * @param in_ep_interval IN endpoint polling interval (ms)
    * @param out_ep_interval OUT endpoint polling interval (ms)
+   * @param gang Extra SWD ports for gang programming (optional)
+   * @param interface_string USB interface string (iInterface) naming this port
+   *
+   * Every CMSIS-DAP interface of the device shares the USB serial number, so a
+   * host tells them apart by interface: the string shows up as the `interface`
+   * attribute of the USB interface in sysfs (udev: ATTRS{interface}=="...") and
+   * in the Windows device properties, and hidapi reports the interface number of
+   * each HID path. Give every instance a distinct string.
    */
-  HIDCmsisDap(DAP::DapIo& io, uint8_t in_ep_interval = 1, uint8_t out_ep_interval = 1)
+  HIDCmsisDap(DAP::DapIo& io, uint8_t in_ep_interval = 1, uint8_t out_ep_interval = 1,
+              const DAP::DapGangIo* gang = nullptr,
+              const char* interface_string = "CMSIS-DAP")
       : HID(false, in_ep_interval, out_ep_interval, Endpoint::EPNumber::EP_AUTO,
             Endpoint::EPNumber::EP_AUTO),
-        dap_engine_(io)
+        dap_engine_(io, gang),
+        interface_string_(interface_string)
   {
+    worker_.Create<HIDCmsisDap*>(this, WorkerTask, "dap_worker", DAP::kWorkerStackSize,
+                                 LibXR::Thread::Priority::MEDIUM);
   }
 
+  /**
+   * @brief GPIO bit-bang SWD engine offered through SWD_SelectEngine
+   * @param engine Engine bound to the same pins as the DapIo, null to remove
+   */
+  void SetSwdBitbang(DAP::SwdWire* engine) { dap_engine_.SetSwdBitbang(engine); }
+
+  /**
+   * @brief Task and heap statistics reported through SYS_Stats
+   * @param stats Provider of the RTOS port, null to remove
+   */
+  void SetSystemStats(DAP::SystemStats* stats) { dap_engine_.SetSystemStats(stats); }
+
+  /**
+   * @brief Stream for RTT_Start with streaming requested
+   * @param sink RTT port of the board, null to remove
+   */
+  void SetRttSink(DAP::RttSink* sink) { dap_engine_.SetRttSink(sink); }
+
  private:
   DAP::DapProtocol dap_engine_;
+  const char* interface_string_;
+
+  // Requests are queued from the USB interrupt and executed by the worker, so a
+  // long SWD transfer never blocks other interfaces on the same USB device.
+  LibXR::Thread worker_;
+  LibXR::Semaphore request_sem_{0};
+  static constexpr uint8_t REQUEST_SLOTS = DAP::kPacketCount + 1;
+  uint8_t request_pool_[REQUEST_SLOTS][DAP::kPacketSize] = {};
+  uint16_t request_len_[REQUEST_SLOTS] = {};  // Bytes received per queued request
+  volatile uint8_t request_head_ = 0;  // Written by USB ISR only
+  volatile uint8_t request_tail_ = 0;  // Written by worker only
+  uint8_t response_packet_[DAP::kPacketSize] = {};
+  uint8_t report_buffer_[DAP::kPacketSize] = {};  // SET_REPORT control data
+  uint8_t empty_report_[DAP::kPacketSize] = {};   // Answer to an empty request
+
+  // One input report in flight at a time. The worker sleeps on in_sem_ until the
+  // IN-complete callback frees the endpoint; a USB reset bumps usb_epoch_ so a
+  // response for the previous session is dropped.
+  LibXR::Semaphore in_sem_{0};
+  volatile bool in_busy_ = false;   // Report handed to the IN endpoint
+  volatile uint32_t usb_epoch_ = 0;  // Incremented on USB reset
+
+  // Packet capture: arrival time per queued request, and the request in flight
+  uint32_t request_us_[REQUEST_SLOTS] = {};
+  const uint8_t* trace_request_ = nullptr;
+
+  /**
+   * @brief DAP worker thread, executes queued requests in order
+   * @param self Owning interface
+   */
+  static void WorkerTask(HIDCmsisDap* self)
+  {
+    auto response_callback = LibXR::Callback<const uint8_t*, size_t>::Create(
+        [](bool in_isr, HIDCmsisDap* hid, const uint8_t* response_data,
+           size_t response_len)
+        {
+          UNUSED(in_isr);
+
+          size_t copy_len =
+              (response_len > DAP::kPacketSize) ? DAP::kPacketSize : response_len;
+          if (!hid->SendResponse(response_data, copy_len))
+          {
+            return;
+          }
+
+          DAP::EventTrace::Instance().Record(DAP::EventType::UsbIn,
+                                             hid->response_packet_[0]);
+          hid->TraceResponse(response_data, copy_len);
+        },
+        self);
+
+    while (true)
+    {
+      // Wake up for background work (RTT polling) even without requests
+      if (self->request_sem_.Wait(self->dap_engine_.GetPollInterval()) == ErrorCode::OK)
+      {
+        const uint8_t* request = self->request_pool_[self->request_tail_];
+        self->trace_request_ = request;
+        self->dap_engine_.ExecuteCommand(request, response_callback,
+                                         self->request_len_[self->request_tail_]);
+        self->request_tail_ = (self->request_tail_ + 1) % REQUEST_SLOTS;
+      }
+
+      self->dap_engine_.Poll();
+    }
+  }
+
+  /**
+   * @brief Send a response once the previous report has left
+   * @param response Response bytes
+   * @param len Response length, at most kPacketSize
+   * @return False if the response was dropped: the host did not fetch the
+   *         previous report within kUsbInTimeoutMs, or the bus was reset
+   */
+  bool SendResponse(const uint8_t* response, size_t len)
+  {
+    const uint32_t epoch = usb_epoch_;
+
+    // A stale post from a completion nobody waited for just loops once more
+    while (in_busy_)
+    {
+      if (in_sem_.Wait(DAP::kUsbInTimeoutMs) != ErrorCode::OK || usb_epoch_ != epoch)
+      {
+        return false;
+      }
+    }
+
+    std::memcpy(response_packet_, response, len);
+    std::memset(response_packet_ + len, 0, sizeof(response_packet_) - len);
+
+    in_busy_ = true;
+    if (SendInputReport(ConstRawData{response_packet_, sizeof(response_packet_)}) !=
+        ErrorCode::OK)
+    {
+      in_busy_ = false;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Record the request in flight with its response, if capture is on
+   * @param response Response as sent to the host
+   * @param len Response length
+   */
+  void TraceResponse(const uint8_t* response, size_t len)
+  {
+    auto& trace = dap_engine_.Trace();
+    if (!trace.Enabled() || trace_request_ == nullptr ||
+        trace_request_[0] == static_cast<uint8_t>(DAP::VendorCommandId::TRACE_Control))
+    {
+      return;
+    }
+
+    trace.Record(request_us_[request_tail_], trace_request_, request_len_[request_tail_],
+                 static_cast<uint32_t>(LibXR::Timebase::GetMicroseconds()), response,
+                 len);
+  }
 
  protected:
   /**
@@ -57,6 +207,47 @@ class HIDCmsisDap : public HID<sizeof(CMSIS_DAP_REPORT_DESC), 64, 64>
     return ConstRawData(CMSIS_DAP_REPORT_DESC, sizeof(CMSIS_DAP_REPORT_DESC));
   }
 
+  /**
+   * @brief USB interface string of this port
+   * @param local_interface_index Interface index within the class (only 0)
+   * @return Null-terminated string for the iInterface descriptor
+   */
+  const char* GetInterfaceString(size_t local_interface_index) const override
+  {
+    UNUSED(local_interface_index);
+    return interface_string_;
+  }
+
+  /**
+   * @brief Input report delivered, wake the worker waiting for the endpoint
+   * @param in_isr Whether called from interrupt context
+   * @param data Transferred data
+   */
+  void OnDataInComplete(bool in_isr, ConstRawData& data) override
+  {
+    UNUSED(data);
+
+    if (in_busy_)
+    {
+      in_busy_ = false;
+      in_sem_.PostFromCallback(in_isr);
+    }
+  }
+
+  /**
+   * @brief USB reset or deconfiguration: the report in flight never completes
+   * @param endpoint_pool Endpoint pool the endpoints return to
+   * @param in_isr Whether called from interrupt context
+   */
+  void UnbindEndpoints(EndpointPool& endpoint_pool, bool in_isr) override
+  {
+    HID::UnbindEndpoints(endpoint_pool, in_isr);
+
+    usb_epoch_ = usb_epoch_ + 1;
+    in_busy_ = false;
+    in_sem_.PostFromCallback(in_isr);
+  }
+
   /**
    * @brief Handle HID SET_REPORT request
    * @param report_id Report ID (unused for CMSIS-DAP)
@@ -67,8 +258,7 @@ class HIDCmsisDap : public HID<sizeof(CMSIS_DAP_REPORT_DESC), 64, 64>
   {
     (void)report_id;
 
-    static uint8_t dummy_buffer[64];
-    result.read_data = {dummy_buffer, sizeof(dummy_buffer)};
+    result.read_data = {report_buffer_, sizeof(report_buffer_)};
 
     return ErrorCode::OK;
   }
@@ -81,42 +271,45 @@ class HIDCmsisDap : public HID<sizeof(CMSIS_DAP_REPORT_DESC), 64, 64>
    */
   ErrorCode OnSetReportData(bool in_isr, ConstRawData& data) override
   {
-    UNUSED(in_isr);
-
     if (data.size_ == 0 || data.addr_ == nullptr)
     {
-      static uint8_t error_response[64] = {0};
-      SendInputReport(ConstRawData{error_response, 64});
+      // Dropped if a response is in flight, the host gets that one instead
+      if (!in_busy_ &&
+          SendInputReport(ConstRawData{empty_report_, sizeof(empty_report_)}) ==
+              ErrorCode::OK)
+      {
+        in_busy_ = true;
+      }
       return ErrorCode::OK;
     }
 
     const auto* request = static_cast<const uint8_t*>(data.addr_);
+    DAP::EventTrace::Instance().Record(DAP::EventType::UsbOut, request[0]);
 
-    // Handle TransferAbort command
-    if (request[0] == 0x18)  // ID_DAP_TransferAbort
+    // TransferAbort bypasses the queue and has no response of its own
+    if (request[0] == static_cast<uint8_t>(DAP::CommandId::TransferAbort))
     {
-      static uint8_t abort_response[64] = {0};
-      abort_response[0] = request[0];
-      abort_response[1] = 0x00;
-      SendInputReport(ConstRawData{abort_response, 64});
+      dap_engine_.AbortTransfer();
       return ErrorCode::OK;
     }
 
-    auto response_callback = LibXR::Callback<const uint8_t*, size_t>::Create(
-        [](bool in_isr, HIDCmsisDap* self, const uint8_t* response_data, size_t response_len) {
-          UNUSED(in_isr);
-
-          static uint8_t response_packet[64];
-          std::memset(response_packet, 0, sizeof(response_packet));
-
-          size_t copy_len = (response_len > 64) ? 64 : response_len;
-          std::memcpy(response_packet, response_data, copy_len);
-
-          self->SendInputReport(ConstRawData{response_packet, 64});
-        },
-        this);
+    const uint8_t next_head = (request_head_ + 1) % REQUEST_SLOTS;
+    if (next_head == request_tail_)
+    {
+      // Host exceeded the advertised packet count
+      return ErrorCode::FULL;
+    }
 
-    dap_engine_.ExecuteCommand(request, response_callback);
+    size_t copy_len = (data.size_ > DAP::kPacketSize) ? DAP::kPacketSize : data.size_;
+    std::memcpy(request_pool_[request_head_], request, copy_len);
+    request_len_[request_head_] = static_cast<uint16_t>(copy_len);
+    if (dap_engine_.Trace().Enabled())
+    {
+      request_us_[request_head_] =
+          static_cast<uint32_t>(LibXR::Timebase::GetMicroseconds());
+    }
+    request_head_ = next_head;
+    request_sem_.PostFromCallback(in_isr);
 
     return ErrorCode::OK;
   }
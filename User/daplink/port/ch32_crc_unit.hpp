@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ch32v30x_crc.h"
+#include "ch32v30x_rcc.h"
+#include "crc_unit.hpp"
+
+namespace DAP
+{
+
+/**
+ * @class CH32CrcUnit
+ * @brief CrcUnit backed by the CH32V30x CRC peripheral.
+ */
+class CH32CrcUnit : public CrcUnit
+{
+ public:
+  CH32CrcUnit() { RCC_AHBPeriphClockCmd(RCC_AHBPeriph_CRC, ENABLE); }
+
+  void Reset() override { CRC_ResetDR(); }
+
+  void Feed(const uint32_t* words, size_t count) override
+  {
+    CRC_CalcBlockCRC(const_cast<uint32_t*>(words), count);
+  }
+
+  uint32_t Value() const override { return CRC_GetCRC(); }
+};
+
+}  // namespace DAP
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ch32v30x.h"
+#include "ch32v30x_gpio.h"
+
+namespace DAP
+{
+
+/**
+ * @struct CH32SwdPins
+ * @brief SwdBitbang pin policy for the PalmDAP wiring on CH32V30x.
+ *
+ * SWCLK is PA5 (SPI1 SCK) and SWDIO the direct line on PA8. While the
+ * bit-bang engine runs, PA5 is a GPIO output and PA7 (MOSI) floats, so the
+ * series resistor does not load SWDIO. Release() returns both to SPI1.
+ *
+ * The cycle counts are only a fallback: SwdBitbang measures both on SysTick,
+ * which FreeRTOS runs from HCLK, before the engine first takes the pins.
+ */
+struct CH32SwdPins
+{
+  static constexpr bool kCycleCounter = true;
+  static constexpr uint32_t kDelayLoopCycles = 4;
+  static constexpr uint32_t kBitOverheadCycles = 12;
+
+  // CFGLR/CFGHR nibbles (CNF[1:0] MODE[1:0])
+  static constexpr uint32_t kOutputPushPull50M = 0x3;
+  static constexpr uint32_t kInputFloating = 0x4;
+  static constexpr uint32_t kAltPushPull50M = 0xB;
+
+  static constexpr uint32_t kClkShift = 5 * 4;    // PA5 in CFGLR
+  static constexpr uint32_t kMosiShift = 7 * 4;   // PA7 in CFGLR
+  static constexpr uint32_t kSwdioShift = 0 * 4;  // PA8 in CFGHR
+
+  static void SetMode(volatile uint32_t& cfg, uint32_t shift, uint32_t mode)
+  {
+    cfg = (cfg & ~(0xFUL << shift)) | (mode << shift);
+  }
+
+  void Setup()
+  {
+    GPIOA->BSHR = GPIO_Pin_5;  // SWCLK idles high
+    SetMode(GPIOA->CFGLR, kClkShift, kOutputPushPull50M);
+    SetMode(GPIOA->CFGLR, kMosiShift, kInputFloating);
+  }
+
+  void Release()
+  {
+    SetMode(GPIOA->CFGHR, kSwdioShift, kInputFloating);
+    SetMode(GPIOA->CFGLR, kClkShift, kAltPushPull50M);
+    SetMode(GPIOA->CFGLR, kMosiShift, kAltPushPull50M);
+  }
+
+  void ClockLow() { GPIOA->BCR = GPIO_Pin_5; }
+  void ClockHigh() { GPIOA->BSHR = GPIO_Pin_5; }
+
+  void Out(bool high) { GPIOA->BSHR = high ? GPIO_Pin_8 : (GPIO_Pin_8 << 16); }
+  bool In() const { return (GPIOA->INDR & GPIO_Pin_8) != 0; }
+
+  void OutputEnable() { SetMode(GPIOA->CFGHR, kSwdioShift, kOutputPushPull50M); }
+  void OutputDisable() { SetMode(GPIOA->CFGHR, kSwdioShift, kInputFloating); }
+
+  uint32_t CoreClock() const { return SystemCoreClock; }
+  uint32_t CycleCount() const { return static_cast<uint32_t>(SysTick->CNT); }
+};
+
+}  // namespace DAP
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstring>
+
+#include "FreeRTOS.h"
+#include "runtime_stats_timer.h"
+#include "system_stats.hpp"
+#include "task.h"
+
+namespace DAP
+{
+
+/**
+ * @class FreeRtosSystemStats
+ * @brief SystemStats from the FreeRTOS kernel and heap_4.
+ *
+ * Run times come from the TIM7 run-time stats clock (runtime_stats_timer.h),
+ * stack high-water marks from uxTaskGetSystemState(). The snapshot buffer is
+ * a member, so an instance may only be given to one DAP interface.
+ */
+class FreeRtosSystemStats : public SystemStats
+{
+ public:
+  static constexpr UBaseType_t kMaxTasks = 16;
+
+  size_t ReadTasks(uint8_t first, Task* tasks, size_t max_tasks,
+                   uint32_t& total_run_time) override
+  {
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    const UBaseType_t count = uxTaskGetSystemState(status_, kMaxTasks, &total);
+    total_run_time = total;
+
+    // The kernel lists tasks by state, hand them out by task number instead
+    size_t n = 0;
+    UBaseType_t next = first;
+    while (n < max_tasks)
+    {
+      const TaskStatus_t* lowest = nullptr;
+      for (UBaseType_t i = 0; i < count; i++)
+      {
+        if (status_[i].xTaskNumber >= next &&
+            (lowest == nullptr || status_[i].xTaskNumber < lowest->xTaskNumber))
+        {
+          lowest = &status_[i];
+        }
+      }
+      if (lowest == nullptr || lowest->xTaskNumber > 0xFF)
+      {
+        break;
+      }
+
+      Task& task = tasks[n++];
+      task.number = static_cast<uint8_t>(lowest->xTaskNumber);
+      task.state = static_cast<uint8_t>(lowest->eCurrentState);
+      task.priority = static_cast<uint8_t>(lowest->uxCurrentPriority);
+      task.stack_free = lowest->usStackHighWaterMark;
+      task.run_time = lowest->ulRunTimeCounter;
+      std::strncpy(task.name, lowest->pcTaskName, kNameSize);
+      next = lowest->xTaskNumber + 1;
+    }
+
+    return n;
+  }
+
+  Heap ReadHeap() override
+  {
+    Heap heap;
+    heap.size = configTOTAL_HEAP_SIZE;
+    heap.free = xPortGetFreeHeapSize();
+    heap.min_free = xPortGetMinimumEverFreeHeapSize();
+    return heap;
+  }
+
+  uint32_t RunTimeHz() const override { return RUNTIME_STATS_TIMER_HZ; }
+
+ private:
+  TaskStatus_t status_[kMaxTasks];
+};
+
+}  // namespace DAP
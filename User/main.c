@@ -4,6 +4,25 @@
 #include "math.h"
 #include "task.h"
 
+// Statically allocated, app_main keeps its objects in static storage as well.
+// Check the stack high-water mark with SYS_Stats before shrinking it.
+#define DEFAULT_TASK_STACK_WORDS 1536
+
+static StackType_t default_task_stack[DEFAULT_TASK_STACK_WORDS];
+static StaticTask_t default_task_tcb;
+
+static StackType_t idle_task_stack[configMINIMAL_STACK_SIZE];
+static StaticTask_t idle_task_tcb;
+
+void vApplicationGetIdleTaskMemory(StaticTask_t** ppxIdleTaskTCBBuffer,
+                                   StackType_t** ppxIdleTaskStackBuffer,
+                                   uint32_t* pulIdleTaskStackSize)
+{
+  *ppxIdleTaskTCBBuffer = &idle_task_tcb;
+  *ppxIdleTaskStackBuffer = idle_task_stack;
+  *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
 static void DefaultTask(void* pvParameters)
 {
   (void)(pvParameters);
@@ -33,7 +52,8 @@ int main(void)
   SystemCoreClockUpdate();
   USB_RCC_Init();
   __enable_irq();
-  xTaskCreate(DefaultTask, "DefaultTask", 6000, NULL, 3, NULL);
+  xTaskCreateStatic(DefaultTask, "DefaultTask", DEFAULT_TASK_STACK_WORDS, NULL, 3,
+                    default_task_stack, &default_task_tcb);
   vTaskStartScheduler();
   return 0;
 }
@@ -0,0 +1,388 @@
+// DAP command throughput and latency against the simulated target.
+//
+//   dap_bench [--iterations N] [--engine spi|gpio|all] [--out FILE]
+//
+// Every workload is a scripted series of DAP commands run through
+// DapProtocol::ExecuteCommand, once per engine. Results are JSON. Wall time and
+// instruction counts include the simulated target, so compare engines and
+// builds against each other rather than reading them as probe timings; the
+// SWCLK and SPI figures are exact.
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "dap_constants.hpp"
+#include "dap_utils.hpp"
+#include "json_format.hpp"
+#include "sim_probe.hpp"
+
+using DAP::Sim::JsonNumber;
+using DAP::Sim::SimProbe;
+
+namespace
+{
+
+constexpr uint8_t Cmd(DAP::CommandId id) { return static_cast<uint8_t>(id); }
+
+constexpr uint8_t kApRead = DAP::DAP_TRANSFER_APnDP | DAP::DAP_TRANSFER_RnW;
+constexpr uint8_t kApWrite = DAP::DAP_TRANSFER_APnDP;
+constexpr uint8_t kDpRead = DAP::DAP_TRANSFER_RnW;
+constexpr uint8_t kDpWrite = 0;
+
+constexpr uint32_t kRamBase = 0x20000000;
+constexpr uint32_t kTarWrap = 1024;
+constexpr uint16_t kReadWordsPerPacket = (DAP::kPacketSize - 4) / 4;
+constexpr uint16_t kWriteWordsPerPacket = (DAP::kPacketSize - 5) / 4;
+
+/**
+ * @class InstructionCounter
+ * @brief User-space retired instructions via perf_event_open, if permitted
+ */
+class InstructionCounter
+{
+ public:
+  InstructionCounter()
+  {
+    perf_event_attr attr = {};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~InstructionCounter()
+  {
+    if (fd_ >= 0)
+    {
+      close(fd_);
+    }
+  }
+
+  bool Available() const { return fd_ >= 0; }
+
+  void Start()
+  {
+    if (fd_ >= 0)
+    {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  uint64_t Stop()
+  {
+    uint64_t count = 0;
+    if (fd_ >= 0)
+    {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count))
+      {
+        count = 0;
+      }
+    }
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+/**
+ * @class Session
+ * @brief Issues DAP commands on a SimProbe and counts them
+ */
+class Session
+{
+ public:
+  explicit Session(SimProbe& probe) : probe_(probe) {}
+
+  const std::vector<uint8_t>& Run(const std::vector<uint8_t>& request)
+  {
+    commands_++;
+    const auto& resp = probe_.Execute(request);
+    if (resp.empty() || resp[0] != request[0])
+    {
+      errors_++;
+    }
+    return resp;
+  }
+
+  void Transfer(uint8_t request, uint32_t value = 0)
+  {
+    std::vector<uint8_t> req = {Cmd(DAP::CommandId::Transfer), 0, 1, request};
+    if (!(request & DAP::DAP_TRANSFER_RnW))
+    {
+      Put32(req, value);
+    }
+    const auto& resp = Run(req);
+    if (resp.size() < 3 || resp[2] != DAP::DAP_TRANSFER_OK)
+    {
+      errors_++;
+    }
+  }
+
+  void Connect()
+  {
+    Run({Cmd(DAP::CommandId::Connect), 1});
+    Transfer(kDpRead | DAP::DP_IDCODE);
+    Transfer(kDpWrite | DAP::DP_ABORT, 0x1E);
+    Transfer(kDpWrite | DAP::DP_SELECT, 0);
+    Transfer(kDpWrite | DAP::DP_CTRL_STAT, 0x50000000);
+    Transfer(kDpRead | DAP::DP_CTRL_STAT);
+    Transfer(kApWrite | DAP::AP_CSW, 0x23000012);
+  }
+
+  /**
+   * @brief Word block at addr, split into packets and re-seeded at TAR wraps
+   */
+  void Block(uint32_t addr, uint32_t words, bool write)
+  {
+    std::vector<uint8_t> req;
+    const uint16_t per_packet = write ? kWriteWordsPerPacket : kReadWordsPerPacket;
+
+    while (words > 0)
+    {
+      Transfer(kApWrite | DAP::AP_TAR, addr);
+
+      uint32_t run = (kTarWrap - (addr & (kTarWrap - 1))) / 4;
+      run = (run < words) ? run : words;
+      words -= run;
+
+      while (run > 0)
+      {
+        const auto n = static_cast<uint16_t>((run < per_packet) ? run : per_packet);
+        req = {Cmd(DAP::CommandId::TransferBlock), 0, static_cast<uint8_t>(n),
+               static_cast<uint8_t>(n >> 8),
+               static_cast<uint8_t>(write ? (kApWrite | DAP::AP_DRW)
+                                          : (kApRead | DAP::AP_DRW))};
+        for (uint16_t i = 0; write && i < n; i++)
+        {
+          Put32(req, addr + 4U * i);
+        }
+
+        const auto& resp = Run(req);
+        if (resp.size() < 4 || resp[3] != DAP::DAP_TRANSFER_OK ||
+            DAP::GetU16(&resp[1]) != n)
+        {
+          errors_++;
+        }
+
+        addr += 4U * n;
+        run -= n;
+      }
+    }
+  }
+
+  uint64_t Commands() const { return commands_; }
+  uint64_t Errors() const { return errors_; }
+
+  static void Put32(std::vector<uint8_t>& v, uint32_t value)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      v.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+  }
+
+ private:
+  SimProbe& probe_;
+  uint64_t commands_ = 0;
+  uint64_t errors_ = 0;
+};
+
+struct Workload
+{
+  const char* name;
+  uint32_t payload_bytes;  // Target memory bytes moved per iteration
+  std::function<void(Session&)> run;
+};
+
+// pyOCD-style attach: probe info, SWD setup, DP power-up, AP discovery
+void PyocdConnect(Session& s)
+{
+  s.Run({Cmd(DAP::CommandId::Info), static_cast<uint8_t>(DAP::InfoId::Capabilities)});
+  s.Run({Cmd(DAP::CommandId::Info), static_cast<uint8_t>(DAP::InfoId::PacketCount)});
+  s.Run({Cmd(DAP::CommandId::Info), static_cast<uint8_t>(DAP::InfoId::PacketSize)});
+  s.Run({Cmd(DAP::CommandId::Connect), 1});
+  s.Run({Cmd(DAP::CommandId::SWJ_Clock), 0x40, 0x42, 0x0F, 0x00});  // 1 MHz
+  s.Run({Cmd(DAP::CommandId::TransferConfigure), 2, 0x50, 0x00, 0x00, 0x00});
+  s.Run({Cmd(DAP::CommandId::SWD_Configure), 0x00});
+  s.Run({Cmd(DAP::CommandId::SWJ_Sequence), 51, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+         0x07});
+  s.Run({Cmd(DAP::CommandId::SWJ_Sequence), 16, 0x9E, 0xE7});
+  s.Run({Cmd(DAP::CommandId::SWJ_Sequence), 51, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+         0x07});
+  s.Run({Cmd(DAP::CommandId::SWJ_Sequence), 8, 0x00});
+  s.Transfer(kDpRead | DAP::DP_IDCODE);
+  s.Transfer(kDpWrite | DAP::DP_ABORT, 0x1E);
+  s.Transfer(kDpWrite | DAP::DP_SELECT, 0);
+  s.Transfer(kDpWrite | DAP::DP_CTRL_STAT, 0x50000000);
+  s.Transfer(kDpRead | DAP::DP_CTRL_STAT);
+  s.Transfer(kDpWrite | DAP::DP_SELECT, 0xF0);
+  s.Transfer(kApRead | DAP::AP_DRW);  // IDR, posted
+  s.Transfer(kDpRead | DAP::DP_RDBUFF);
+  s.Transfer(kDpWrite | DAP::DP_SELECT, 0);
+  s.Transfer(kApRead | DAP::AP_CSW);
+  s.Transfer(kDpRead | DAP::DP_RDBUFF);
+  s.Transfer(kApWrite | DAP::AP_CSW, 0x23000012);
+}
+
+const std::vector<Workload>& Workloads()
+{
+  static const std::vector<Workload> workloads = {
+      {"dp_read", 0,
+       [](Session& s) { s.Transfer(kDpRead | DAP::DP_IDCODE); }},
+      {"swj_sequence", 0,
+       [](Session& s)
+       {
+         s.Run({Cmd(DAP::CommandId::SWJ_Sequence), 64, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0x00});
+       }},
+      {"block_read_1k", 1024, [](Session& s) { s.Block(kRamBase, 256, false); }},
+      {"block_write_1k", 1024, [](Session& s) { s.Block(kRamBase, 256, true); }},
+      {"block_read_64k", 65536, [](Session& s) { s.Block(kRamBase, 16384, false); }},
+      {"block_write_64k", 65536, [](Session& s) { s.Block(kRamBase, 16384, true); }},
+      {"pyocd_connect", 0, PyocdConnect},
+  };
+  return workloads;
+}
+
+std::string RunWorkload(const Workload& workload, const char* engine, uint32_t iterations,
+                        InstructionCounter& counter, bool& ok)
+{
+  SimProbe probe;
+  if (std::strcmp(engine, "gpio") == 0)
+  {
+    probe.Execute({static_cast<uint8_t>(DAP::VendorCommandId::SWD_SelectEngine), 1});
+  }
+
+  Session session(probe);
+  session.Connect();
+  const uint64_t setup_commands = session.Commands();
+
+  probe.Target().ClearStats();
+  probe.Spi().ClearStats();
+
+  counter.Start();
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    workload.run(session);
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const uint64_t instructions = counter.Stop();
+
+  const double seconds = std::chrono::duration<double>(end - start).count();
+  const auto commands = static_cast<double>(session.Commands() - setup_commands);
+  const double bytes = static_cast<double>(workload.payload_bytes) * iterations;
+  const auto& target = probe.Target().GetStats();
+  const auto& spi = probe.Spi().GetStats();
+  const double packets = target.packets ? static_cast<double>(target.packets) : 1.0;
+
+  ok = ok && session.Errors() == 0;
+
+  std::string json = "    {\"workload\": \"" + std::string(workload.name) +
+                     "\", \"engine\": \"" + engine + "\"";
+  json += ", \"iterations\": " + std::to_string(iterations);
+  json += ", \"commands\": " + JsonNumber(commands);
+  json += ", \"errors\": " + std::to_string(session.Errors());
+  json += ", \"seconds\": " + JsonNumber(seconds);
+  json += ", \"commands_per_s\": " + JsonNumber(commands / seconds);
+  json += ", \"us_per_command\": " + JsonNumber(seconds * 1e6 / commands);
+  json += ", \"bytes_per_s\": " + JsonNumber(bytes / seconds);
+  json += ", \"swd_packets\": " + std::to_string(target.packets);
+  json += ", \"swclk_per_command\": " + JsonNumber(target.clocks / commands);
+  json += ", \"swclk_per_transfer\": " + JsonNumber(target.clocks / packets);
+  json += ", \"spi_bytes_per_transfer\": " + JsonNumber(spi.bytes / packets);
+  json += ", \"spi_calls_per_transfer\": " + JsonNumber(spi.transactions / packets);
+  json += ", \"instructions_per_command\": ";
+  json += counter.Available() ? JsonNumber(instructions / commands) : "null";
+  json += "}";
+  return json;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  uint32_t iterations = 20;
+  std::string engine = "all";
+  const char* out_path = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--iterations" && i + 1 < argc)
+    {
+      iterations = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (arg == "--engine" && i + 1 < argc)
+    {
+      engine = argv[++i];
+    }
+    else if (arg == "--out" && i + 1 < argc)
+    {
+      out_path = argv[++i];
+    }
+    else
+    {
+      std::fprintf(stderr,
+                   "usage: %s [--iterations N] [--engine spi|gpio|all] [--out FILE]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<const char*> engines;
+  if (engine == "spi" || engine == "all")
+  {
+    engines.push_back("spi");
+  }
+  if (engine == "gpio" || engine == "all")
+  {
+    engines.push_back("gpio");
+  }
+
+  InstructionCounter counter;
+  bool ok = true;
+  std::string json = "{\n  \"packet_size\": " + std::to_string(DAP::kPacketSize) +
+                     ",\n  \"results\": [\n";
+
+  bool first = true;
+  for (const auto& workload : Workloads())
+  {
+    for (const char* name : engines)
+    {
+      json += first ? "" : ",\n";
+      json += RunWorkload(workload, name, iterations, counter, ok);
+      first = false;
+    }
+  }
+  json += "\n  ]\n}\n";
+
+  FILE* out = out_path ? std::fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    std::perror(out_path);
+    return 2;
+  }
+  std::fputs(json.c_str(), out);
+  if (out != stdout)
+  {
+    std::fclose(out);
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+// Converts a probe event dump to Chrome trace JSON.
+//
+//   dap_events DUMP [--out FILE]
+//
+// DUMP is "PDEV", the CyclesPerSecond word returned by EVENT_Read mode 1, then
+// the event bytes of EVENT_Read mode 0 responses drained until Count is 0.
+// Open the output in chrome://tracing or https://ui.perfetto.dev.
+
+#include <cstdio>
+#include <string>
+
+#include "event_dump.hpp"
+
+namespace
+{
+
+int Usage(const char* argv0)
+{
+  std::fprintf(stderr, "usage: %s DUMP [--out FILE]\n", argv0);
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const char* dump_path = nullptr;
+  const char* out_path = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc)
+    {
+      out_path = argv[++i];
+    }
+    else if (arg[0] != '-' && dump_path == nullptr)
+    {
+      dump_path = argv[i];
+    }
+    else
+    {
+      return Usage(argv[0]);
+    }
+  }
+
+  if (dump_path == nullptr)
+  {
+    return Usage(argv[0]);
+  }
+
+  DAP::Sim::EventDump dump;
+  std::string error;
+  if (!DAP::Sim::EventDump::Load(dump_path, dump, error))
+  {
+    std::fprintf(stderr, "%s: %s\n", dump_path, error.c_str());
+    return 2;
+  }
+
+  FILE* out = out_path ? std::fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    std::perror(out_path);
+    return 2;
+  }
+  std::fputs(DAP::Sim::ToChromeTrace(dump).c_str(), out);
+  if (out != stdout)
+  {
+    std::fclose(out);
+  }
+
+  return 0;
+}
@@ -0,0 +1,66 @@
+// libFuzzer target for DapProtocol::ExecuteCommand.
+//
+// The input is a sequence of packets, each [Length] [Bytes(Length)], run in
+// order on a fresh probe wired to the simulated target. Length is clipped to
+// the packet size, empty packets are skipped. Every request is copied into its
+// own heap buffer of exactly Length bytes and executed with that length, so a
+// handler reading past the request trips AddressSanitizer. Responses longer
+// than the command's entry in the dispatch table allows abort.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "dap_config.hpp"
+#include "dap_constants.hpp"
+#include "sim_probe.hpp"
+
+namespace
+{
+
+void CheckResponse(bool in_isr, const uint8_t* command, const uint8_t* data,
+                   size_t size)
+{
+  UNUSED(in_isr);
+  // Unsupported commands get the 1-byte Invalid response
+  const size_t max_size =
+      std::max<size_t>(1, DAP::DapProtocol::MaxResponseLength(*command));
+  if (size > max_size || (size > 0 && data == nullptr))
+  {
+    std::abort();
+  }
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  DAP::Sim::SimProbe probe;
+  uint8_t command = 0;
+  auto callback = LibXR::Callback<const uint8_t*, size_t>::Create(
+      CheckResponse, static_cast<const uint8_t*>(&command));
+
+  size_t pos = 0;
+  while (pos < size)
+  {
+    size_t len = data[pos++];
+    len = (len > size - pos) ? size - pos : len;
+    len = (len > DAP::kPacketSize) ? DAP::kPacketSize : len;
+
+    if (len == 0)
+    {
+      continue;
+    }
+
+    std::unique_ptr<uint8_t[]> request(new uint8_t[len]);
+    std::memcpy(request.get(), data + pos, len);
+    pos += len;
+
+    command = request[0];
+    probe.Dap().ExecuteCommand(request.get(), callback, len);
+  }
+
+  return 0;
+}
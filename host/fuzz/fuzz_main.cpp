@@ -0,0 +1,193 @@
+// Standalone driver for the fuzz target when libFuzzer is not available (gcc).
+//
+//   dap_fuzz [-runs=N] [-seed=S] [FILE|DIR ...]
+//
+// Replays the given inputs like libFuzzer does, then runs N random packet
+// sequences. These are not coverage guided: packets start with a known
+// command ID, lengths and payloads are random, and most sequences open with
+// DAP_Connect so the transfer paths are reached. An input that crashes is
+// written to crash-input for replaying.
+
+#include <dirent.h>
+#include <sanitizer/common_interface_defs.h>
+#include <sys/stat.h>
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "dap_config.hpp"
+#include "dap_constants.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace
+{
+
+const std::vector<uint8_t>* current_input = nullptr;
+
+void SaveCurrentInput()
+{
+  if (current_input == nullptr)
+  {
+    return;
+  }
+  if (FILE* file = std::fopen("crash-input", "wb"))
+  {
+    std::fwrite(current_input->data(), 1, current_input->size(), file);
+    std::fclose(file);
+    std::fprintf(stderr, "Input written to crash-input\n");
+  }
+  current_input = nullptr;
+}
+
+void OnAbort(int signal)
+{
+  SaveCurrentInput();
+  std::signal(signal, SIG_DFL);
+  std::raise(signal);
+}
+
+void RunFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  const std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)),
+                                   std::istreambuf_iterator<char>());
+  std::printf("Running: %s (%zu bytes)\n", path.c_str(), input.size());
+  LLVMFuzzerTestOneInput(input.data(), input.size());
+}
+
+void RunPath(const std::string& path)
+{
+  struct stat st = {};
+  if (stat(path.c_str(), &st) != 0)
+  {
+    std::perror(path.c_str());
+    std::exit(2);
+  }
+
+  if (!S_ISDIR(st.st_mode))
+  {
+    RunFile(path);
+    return;
+  }
+
+  DIR* dir = opendir(path.c_str());
+  while (dirent* entry = dir ? readdir(dir) : nullptr)
+  {
+    if (entry->d_name[0] != '.')
+    {
+      RunPath(path + "/" + entry->d_name);
+    }
+  }
+  if (dir)
+  {
+    closedir(dir);
+  }
+}
+
+uint8_t RandomCommand(std::mt19937& rng)
+{
+  using DAP::CommandId;
+  static const CommandId kCommands[] = {
+      CommandId::Info,          CommandId::HostStatus,        CommandId::Connect,
+      CommandId::Disconnect,    CommandId::TransferConfigure, CommandId::Transfer,
+      CommandId::TransferBlock, CommandId::ResetTarget,       CommandId::SWJ_Pins,
+      CommandId::SWJ_Clock,     CommandId::SWJ_Sequence,      CommandId::SWD_Configure,
+      CommandId::SWD_Sequence,  CommandId::JTAG_Sequence,     CommandId::JTAG_Configure,
+      CommandId::JTAG_IDCODE};
+
+  // One in four picks a vendor command, one in sixteen any byte at all
+  switch (rng() % 16)
+  {
+    case 0:
+      return static_cast<uint8_t>(rng());
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+      return static_cast<uint8_t>(0x80 + rng() % 32);
+    default:
+      return static_cast<uint8_t>(kCommands[rng() % std::size(kCommands)]);
+  }
+}
+
+std::vector<uint8_t> RandomInput(std::mt19937& rng)
+{
+  std::vector<uint8_t> input;
+  if (rng() % 4 != 0)
+  {
+    input = {2, static_cast<uint8_t>(DAP::CommandId::Connect), 1};
+  }
+
+  const size_t packets = 1 + rng() % 8;
+  for (size_t i = 0; i < packets; i++)
+  {
+    const size_t len = 1 + rng() % DAP::kPacketSize;
+    input.push_back(static_cast<uint8_t>(len));
+    input.push_back(RandomCommand(rng));
+    for (size_t j = 1; j < len; j++)
+    {
+      // Small values keep counts in range often enough to do real transfers
+      input.push_back(static_cast<uint8_t>((rng() % 2) ? rng() % 16 : rng()));
+    }
+  }
+  return input;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  unsigned long runs = 0;
+  unsigned long seed = 1;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::strncmp(argv[i], "-runs=", 6) == 0)
+    {
+      runs = std::strtoul(argv[i] + 6, nullptr, 10);
+    }
+    else if (std::strncmp(argv[i], "-seed=", 6) == 0)
+    {
+      seed = std::strtoul(argv[i] + 6, nullptr, 10);
+    }
+    else if (argv[i][0] == '-')
+    {
+      std::fprintf(stderr, "usage: %s [-runs=N] [-seed=S] [FILE|DIR ...]\n", argv[0]);
+      return 2;
+    }
+    else
+    {
+      paths.push_back(argv[i]);
+    }
+  }
+
+  for (const auto& path : paths)
+  {
+    RunPath(path);
+  }
+
+  __sanitizer_set_death_callback(SaveCurrentInput);
+  std::signal(SIGABRT, OnAbort);
+
+  std::mt19937 rng(static_cast<std::mt19937::result_type>(seed));
+  for (unsigned long i = 0; i < runs; i++)
+  {
+    const auto input = RandomInput(rng);
+    current_input = &input;
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+  current_input = nullptr;
+
+  std::printf("Done %lu random runs (seed %lu)\n", runs, seed);
+  return 0;
+}
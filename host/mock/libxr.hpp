@@ -0,0 +1,252 @@
+#pragma once
+
+// Host stand-in for the subset of LibXR used by User/daplink/core. Only the
+// interfaces the DAP engine touches are modelled; threads and semaphores map
+// onto the C++ standard library so the gang workers run for real.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#ifndef UNUSED
+#define UNUSED(x) (void)(x)
+#endif
+
+namespace LibXR
+{
+
+enum class ErrorCode : int8_t
+{
+  OK = 0,
+  FAILED = -1,
+  INIT_ERR = -2,
+  ARG_ERR = -3,
+  STATE_ERR = -4,
+  SIZE_ERR = -5,
+  CHECK_ERR = -6,
+  NOT_SUPPORT = -7,
+  NOT_FOUND = -8,
+  NO_RESPONSE = -9,
+  NO_MEM = -10,
+  NO_BUFF = -11,
+  TIMEOUT = -12,
+  EMPTY = -13,
+  FULL = -14,
+  BUSY = -15,
+  PTR_NULL = -16,
+  OUT_OF_RANGE = -17
+};
+
+struct RawData
+{
+  RawData(void* addr = nullptr, size_t size = 0) : addr_(addr), size_(size) {}
+
+  template <typename T>
+  RawData(T& data) : addr_(&data), size_(sizeof(T))
+  {
+  }
+
+  void* addr_;
+  size_t size_;
+};
+
+struct ConstRawData
+{
+  ConstRawData(const void* addr = nullptr, size_t size = 0) : addr_(addr), size_(size)
+  {
+  }
+
+  ConstRawData(const RawData& data) : addr_(data.addr_), size_(data.size_) {}
+
+  template <typename T>
+  ConstRawData(const T& data) : addr_(&data), size_(sizeof(T))
+  {
+  }
+
+  const void* addr_;
+  size_t size_;
+};
+
+template <typename... Args>
+class Callback
+{
+ public:
+  Callback() = default;
+
+  template <typename FunType, typename ArgType>
+  static Callback Create(FunType fun, ArgType arg)
+  {
+    Callback cb;
+    cb.fun_ = [fun, arg](bool in_isr, Args... args) { fun(in_isr, arg, args...); };
+    return cb;
+  }
+
+  template <typename... PassArgs>
+  void Run(bool in_isr, PassArgs&&... args) const
+  {
+    if (fun_)
+    {
+      fun_(in_isr, std::forward<PassArgs>(args)...);
+    }
+  }
+
+  bool Empty() const { return !fun_; }
+
+ private:
+  std::function<void(bool, Args...)> fun_;
+};
+
+class Semaphore
+{
+ public:
+  explicit Semaphore(uint32_t init_count = 0) : count_(init_count) {}
+
+  void Post()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    count_++;
+    cv_.notify_one();
+  }
+
+  void PostFromCallback(bool in_isr)
+  {
+    UNUSED(in_isr);
+    Post();
+  }
+
+  ErrorCode Wait(uint32_t timeout = UINT32_MAX)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [this] { return count_ > 0; };
+    if (timeout == UINT32_MAX)
+    {
+      cv_.wait(lock, ready);
+    }
+    else if (!cv_.wait_for(lock, std::chrono::milliseconds(timeout), ready))
+    {
+      return ErrorCode::TIMEOUT;
+    }
+    count_--;
+    return ErrorCode::OK;
+  }
+
+  size_t Value()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  uint32_t count_;
+};
+
+class Mutex
+{
+ public:
+  ErrorCode Lock()
+  {
+    mutex_.lock();
+    return ErrorCode::OK;
+  }
+
+  void Unlock() { mutex_.unlock(); }
+
+ private:
+  std::mutex mutex_;
+};
+
+template <typename... Args>
+class Operation
+{
+ public:
+  using Callback = LibXR::Callback<Args...>;
+
+  enum class OperationType : uint8_t
+  {
+    CALLBACK,
+    BLOCK,
+    POLLING,
+    NONE
+  };
+
+  Operation() : type(OperationType::NONE) {}
+
+  Operation(Semaphore& sem, uint32_t timeout = UINT32_MAX) : type(OperationType::BLOCK)
+  {
+    data.sem_info.sem = &sem;
+    data.sem_info.timeout = timeout;
+  }
+
+  Operation(Callback& callback) : type(OperationType::CALLBACK)
+  {
+    data.callback = &callback;
+  }
+
+  union
+  {
+    Callback* callback;
+    struct
+    {
+      Semaphore* sem;
+      uint32_t timeout;
+    } sem_info;
+  } data;
+
+  OperationType type;
+};
+
+using WriteOperation = Operation<ErrorCode>;
+using ReadOperation = Operation<ErrorCode>;
+
+class Timebase
+{
+ public:
+  static uint64_t GetMicroseconds();
+  static uint32_t GetMilliseconds();
+};
+
+class Thread
+{
+ public:
+  enum class Priority : uint8_t
+  {
+    IDLE,
+    LOW,
+    MEDIUM,
+    HIGH,
+    REALTIME
+  };
+
+  /**
+   * @brief Start a detached std::thread; name, stack and priority are ignored
+   */
+  template <typename ArgType>
+  void Create(ArgType arg, void (*function)(ArgType arg), const char* name,
+              size_t stack_depth, Priority priority)
+  {
+    UNUSED(name);
+    UNUSED(stack_depth);
+    UNUSED(priority);
+    std::thread(function, arg).detach();
+  }
+
+  static void Sleep(uint32_t milliseconds)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+  }
+
+  static void Yield() { std::this_thread::yield(); }
+};
+
+}  // namespace LibXR
+
+#include "gpio.hpp"
+#include "spi.hpp"
@@ -0,0 +1,27 @@
+#include <chrono>
+
+#include "libxr.hpp"
+
+namespace LibXR
+{
+
+namespace
+{
+
+const auto kStart = std::chrono::steady_clock::now();
+
+}  // namespace
+
+uint64_t Timebase::GetMicroseconds()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - kStart)
+                                   .count());
+}
+
+uint32_t Timebase::GetMilliseconds()
+{
+  return static_cast<uint32_t>(GetMicroseconds() / 1000);
+}
+
+}  // namespace LibXR
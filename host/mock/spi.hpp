@@ -0,0 +1,75 @@
+#pragma once
+
+#include "libxr.hpp"
+
+namespace LibXR
+{
+
+class SPI
+{
+ public:
+  enum class ClockPolarity : uint8_t
+  {
+    LOW,
+    HIGH
+  };
+
+  enum class ClockPhase : uint8_t
+  {
+    EDGE_1,
+    EDGE_2
+  };
+
+  enum class Prescaler : uint8_t
+  {
+    DIV_1,
+    DIV_2,
+    DIV_4,
+    DIV_8,
+    DIV_16,
+    DIV_32,
+    DIV_64,
+    DIV_128,
+    DIV_256,
+    DIV_512,
+    DIV_1024,
+    DIV_2048,
+    DIV_4096,
+    DIV_8192,
+    DIV_16384,
+    DIV_32768,
+    DIV_65536,
+    UNKNOWN
+  };
+
+  struct Configuration
+  {
+    ClockPolarity clock_polarity;
+    ClockPhase clock_phase;
+    Prescaler prescaler = Prescaler::UNKNOWN;
+    bool double_buffer = false;
+  };
+
+  using OperationRW = WriteOperation;
+
+  virtual ~SPI() = default;
+
+  virtual ErrorCode ReadAndWrite(RawData read_data, ConstRawData write_data,
+                                 OperationRW& op) = 0;
+
+  virtual ErrorCode Read(RawData read_data, OperationRW& op)
+  {
+    return ReadAndWrite(read_data, ConstRawData(nullptr, 0), op);
+  }
+
+  virtual ErrorCode Write(ConstRawData write_data, OperationRW& op)
+  {
+    return ReadAndWrite(RawData(nullptr, 0), write_data, op);
+  }
+
+  virtual ErrorCode SetConfig(Configuration config) = 0;
+  virtual uint32_t GetMaxBusSpeed() const = 0;
+  virtual Prescaler GetMaxPrescaler() const = 0;
+};
+
+}  // namespace LibXR
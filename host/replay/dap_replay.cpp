@@ -0,0 +1,156 @@
+// Replays a captured DAP packet trace against the simulated target.
+//
+//   dap_replay TRACE [--compare exact|status] [--engine spi|gpio]
+//              [--dpidr HEX] [--out FILE]
+//
+// TRACE is the stream drained from the probe with TRACE_Control (mode 1 to
+// start, 0 to read until Count is 0). Every request goes through
+// DapProtocol::ExecuteCommand in recorded order and its response is compared
+// with the recorded one. The summary is JSON; exit status is 1 on mismatches.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dap_constants.hpp"
+#include "json_format.hpp"
+#include "trace_replay.hpp"
+
+using DAP::Sim::JsonNumber;
+using DAP::Sim::SimProbe;
+using DAP::Sim::TraceReplayer;
+
+namespace
+{
+
+std::string Hex(const std::vector<uint8_t>& data)
+{
+  std::string text;
+  char buf[4];
+  for (uint8_t byte : data)
+  {
+    std::snprintf(buf, sizeof(buf), "%02x", byte);
+    text += buf;
+  }
+  return text;
+}
+
+int Usage(const char* argv0)
+{
+  std::fprintf(stderr,
+               "usage: %s TRACE [--compare exact|status] [--engine spi|gpio] "
+               "[--dpidr HEX] [--out FILE]\n",
+               argv0);
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const char* trace_path = nullptr;
+  const char* out_path = nullptr;
+  auto compare = TraceReplayer::Compare::Status;
+  bool gpio = false;
+  DAP::Sim::SwdTarget::Config config;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--compare" && i + 1 < argc)
+    {
+      const std::string mode = argv[++i];
+      if (mode != "exact" && mode != "status")
+      {
+        return Usage(argv[0]);
+      }
+      compare = (mode == "exact") ? TraceReplayer::Compare::Exact
+                                  : TraceReplayer::Compare::Status;
+    }
+    else if (arg == "--engine" && i + 1 < argc)
+    {
+      const std::string engine = argv[++i];
+      if (engine != "spi" && engine != "gpio")
+      {
+        return Usage(argv[0]);
+      }
+      gpio = (engine == "gpio");
+    }
+    else if (arg == "--dpidr" && i + 1 < argc)
+    {
+      config.dpidr = static_cast<uint32_t>(std::stoul(argv[++i], nullptr, 16));
+    }
+    else if (arg == "--out" && i + 1 < argc)
+    {
+      out_path = argv[++i];
+    }
+    else if (arg[0] != '-' && trace_path == nullptr)
+    {
+      trace_path = argv[i];
+    }
+    else
+    {
+      return Usage(argv[0]);
+    }
+  }
+
+  if (trace_path == nullptr)
+  {
+    return Usage(argv[0]);
+  }
+
+  std::vector<DAP::Sim::TraceRecord> records;
+  std::string error;
+  if (!DAP::Sim::LoadTrace(trace_path, records, error))
+  {
+    std::fprintf(stderr, "%s: %s\n", trace_path, error.c_str());
+    return 2;
+  }
+
+  SimProbe probe(config);
+  if (gpio)
+  {
+    probe.Execute({static_cast<uint8_t>(DAP::VendorCommandId::SWD_SelectEngine), 1});
+  }
+
+  TraceReplayer replayer(probe, compare);
+  const auto result = replayer.Run(records);
+  const double commands = result.records ? static_cast<double>(result.records) : 1.0;
+
+  std::string json = "{\n  \"trace\": \"" + std::string(trace_path) + "\"";
+  json += ",\n  \"engine\": \"" + std::string(gpio ? "gpio" : "spi") + "\"";
+  json += ",\n  \"compare\": \"" +
+          std::string(compare == TraceReplayer::Compare::Exact ? "exact" : "status") +
+          "\"";
+  json += ",\n  \"records\": " + std::to_string(result.records);
+  json += ",\n  \"mismatches\": " + std::to_string(result.mismatches);
+  json += ",\n  \"recorded_us_per_command\": " +
+          JsonNumber(result.recorded_us / commands);
+  json += ",\n  \"replay_us_per_command\": " +
+          JsonNumber(result.replay_seconds * 1e6 / commands);
+  json += ",\n  \"swclk_per_command\": " + JsonNumber(result.swclk / commands);
+  json += ",\n  \"first_mismatches\": [";
+  for (size_t i = 0; i < result.first_mismatches.size(); i++)
+  {
+    const auto& mismatch = result.first_mismatches[i];
+    json += (i ? ",\n" : "\n");
+    json += "    {\"index\": " + std::to_string(mismatch.index) + ", \"expected\": \"" +
+            Hex(mismatch.expected) + "\", \"actual\": \"" + Hex(mismatch.actual) + "\"}";
+  }
+  json += result.first_mismatches.empty() ? "]\n}\n" : "\n  ]\n}\n";
+
+  FILE* out = out_path ? std::fopen(out_path, "w") : stdout;
+  if (!out)
+  {
+    std::perror(out_path);
+    return 2;
+  }
+  std::fputs(json.c_str(), out);
+  if (out != stdout)
+  {
+    std::fclose(out);
+  }
+
+  return result.mismatches == 0 ? 0 : 1;
+}
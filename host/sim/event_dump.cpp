@@ -0,0 +1,230 @@
+#include "event_dump.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "dap_constants.hpp"
+#include "dap_utils.hpp"
+#include "event_trace.hpp"
+
+namespace DAP::Sim
+{
+
+namespace
+{
+
+// Chrome trace thread IDs, one track each
+constexpr int kUsbTrack = 1;
+constexpr int kCommandTrack = 2;
+constexpr int kSpiTrack = 3;
+constexpr int kTaskTrack = 4;
+
+std::string CommandName(uint8_t command)
+{
+  switch (static_cast<CommandId>(command))
+  {
+    case CommandId::Info:
+      return "DAP_Info";
+    case CommandId::HostStatus:
+      return "DAP_HostStatus";
+    case CommandId::Connect:
+      return "DAP_Connect";
+    case CommandId::Disconnect:
+      return "DAP_Disconnect";
+    case CommandId::TransferConfigure:
+      return "DAP_TransferConfigure";
+    case CommandId::Transfer:
+      return "DAP_Transfer";
+    case CommandId::TransferBlock:
+      return "DAP_TransferBlock";
+    case CommandId::TransferAbort:
+      return "DAP_TransferAbort";
+    case CommandId::ResetTarget:
+      return "DAP_ResetTarget";
+    case CommandId::SWJ_Pins:
+      return "DAP_SWJ_Pins";
+    case CommandId::SWJ_Clock:
+      return "DAP_SWJ_Clock";
+    case CommandId::SWJ_Sequence:
+      return "DAP_SWJ_Sequence";
+    case CommandId::SWD_Configure:
+      return "DAP_SWD_Configure";
+    case CommandId::SWD_Sequence:
+      return "DAP_SWD_Sequence";
+    case CommandId::JTAG_Sequence:
+      return "DAP_JTAG_Sequence";
+    case CommandId::JTAG_Configure:
+      return "DAP_JTAG_Configure";
+    case CommandId::JTAG_IDCODE:
+      return "DAP_JTAG_IDCODE";
+    default:
+      break;
+  }
+
+  char name[16];
+  std::snprintf(name, sizeof(name), "%s 0x%02X",
+                IsVendorCommand(static_cast<CommandId>(command)) ? "Vendor" : "Command",
+                command);
+  return name;
+}
+
+std::string Event(const char* phase, int track, double us, const std::string& name,
+                  const std::string& args = "")
+{
+  char ts[32];
+  std::snprintf(ts, sizeof(ts), "%.3f", us);
+  std::string json = "{\"ph\": \"" + std::string(phase) + "\", \"pid\": 1, \"tid\": " +
+                     std::to_string(track) + ", \"ts\": " + ts;
+  if (!name.empty())
+  {
+    json += ", \"name\": \"" + name + "\"";
+  }
+  if (phase[0] == 'i')
+  {
+    json += ", \"s\": \"t\"";
+  }
+  if (!args.empty())
+  {
+    json += ", \"args\": {" + args + "}";
+  }
+  return json + "}";
+}
+
+std::string TrackName(int track, const char* name)
+{
+  return "{\"ph\": \"M\", \"pid\": 1, \"tid\": " + std::to_string(track) +
+         ", \"name\": \"thread_name\", \"args\": {\"name\": \"" + name + "\"}}";
+}
+
+}  // namespace
+
+std::vector<uint8_t> EventDump::Serialize() const
+{
+  std::vector<uint8_t> data(kMagic, kMagic + sizeof(kMagic));
+  data.resize(8);
+  PutU32(&data[4], cycles_per_second);
+  data.insert(data.end(), events.begin(), events.end());
+  return data;
+}
+
+bool EventDump::Parse(const std::vector<uint8_t>& data, EventDump& dump,
+                      std::string& error)
+{
+  if (data.size() < 8 || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0)
+  {
+    error = "not an event dump";
+    return false;
+  }
+  if ((data.size() - 8) % EventTrace::kEventSize != 0)
+  {
+    error = "dump ends inside an event";
+    return false;
+  }
+
+  dump.cycles_per_second = GetU32(&data[4]);
+  if (dump.cycles_per_second == 0)
+  {
+    error = "cycle rate is 0";
+    return false;
+  }
+  dump.events.assign(data.begin() + 8, data.end());
+  return true;
+}
+
+bool EventDump::Load(const std::string& path, EventDump& dump, std::string& error)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    error = "cannot open " + path;
+    return false;
+  }
+
+  const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+  return Parse(data, dump, error);
+}
+
+std::string ToChromeTrace(const EventDump& dump)
+{
+  std::vector<std::string> out = {
+      TrackName(kUsbTrack, "USB"), TrackName(kCommandTrack, "DAP commands"),
+      TrackName(kSpiTrack, "SPI"), TrackName(kTaskTrack, "Tasks")};
+
+  const double us_per_cycle = 1e6 / dump.cycles_per_second;
+  int64_t cycles = 0;
+  uint32_t last = 0;
+  bool first = true;
+  bool task_running = false;
+  bool command_open = false;
+  bool spi_open = false;
+
+  for (size_t pos = 0; pos + EventTrace::kEventSize <= dump.events.size();
+       pos += EventTrace::kEventSize)
+  {
+    const uint32_t stamp = GetU32(&dump.events[pos]);
+    const auto type = static_cast<EventType>(dump.events[pos + 4]);
+    const uint16_t arg = GetU16(&dump.events[pos + 5]);
+
+    // Contexts interleave, so a slightly older stamp can follow a newer one
+    cycles += first ? 0 : static_cast<int32_t>(stamp - last);
+    last = stamp;
+    first = false;
+    const double us = static_cast<double>(cycles) * us_per_cycle;
+
+    switch (type)
+    {
+      case EventType::UsbOut:
+        out.push_back(Event("i", kUsbTrack, us, "OUT " + CommandName(arg & 0xFF)));
+        break;
+      case EventType::UsbIn:
+        out.push_back(Event("i", kUsbTrack, us, "IN " + CommandName(arg & 0xFF)));
+        break;
+      case EventType::CommandStart:
+        out.push_back(Event("B", kCommandTrack, us, CommandName(arg & 0xFF)));
+        command_open = true;
+        break;
+      case EventType::CommandEnd:
+        // A dump can start in the middle of a command
+        if (command_open)
+        {
+          out.push_back(Event("E", kCommandTrack, us, ""));
+          command_open = false;
+        }
+        break;
+      case EventType::SpiStart:
+        out.push_back(Event("B", kSpiTrack, us, "SPI",
+                            "\"bytes\": " + std::to_string(arg)));
+        spi_open = true;
+        break;
+      case EventType::SpiDone:
+        if (spi_open)
+        {
+          out.push_back(Event("E", kSpiTrack, us, "", arg ? "" : "\"error\": true"));
+          spi_open = false;
+        }
+        break;
+      case EventType::TaskSwitch:
+        if (task_running)
+        {
+          out.push_back(Event("E", kTaskTrack, us, ""));
+        }
+        out.push_back(Event("B", kTaskTrack, us, "Task " + std::to_string(arg)));
+        task_running = true;
+        break;
+      default:
+        break;
+    }
+  }
+
+  std::string json = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+  for (size_t i = 0; i < out.size(); i++)
+  {
+    json += "  " + out[i] + (i + 1 < out.size() ? ",\n" : "\n");
+  }
+  return json + "]}\n";
+}
+
+}  // namespace DAP::Sim
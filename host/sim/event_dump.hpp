@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DAP::Sim
+{
+
+/**
+ * @brief A dump of the probe event trace
+ *
+ * File format: "PDEV" [CyclesPerSecond(4)] followed by the event bytes of
+ * EVENT_Read responses, 7 per event, in the order they were read.
+ * CyclesPerSecond is the value returned by EVENT_Read start.
+ */
+struct EventDump
+{
+  static constexpr char kMagic[4] = {'P', 'D', 'E', 'V'};
+
+  uint32_t cycles_per_second = 0;
+  std::vector<uint8_t> events;
+
+  /**
+   * @brief Encode as a dump file
+   */
+  std::vector<uint8_t> Serialize() const;
+
+  /**
+   * @brief Decode a dump file
+   * @return False if the data is not a dump or ends inside an event
+   */
+  static bool Parse(const std::vector<uint8_t>& data, EventDump& dump,
+                    std::string& error);
+
+  /**
+   * @brief Read and decode a dump file
+   */
+  static bool Load(const std::string& path, EventDump& dump, std::string& error);
+};
+
+/**
+ * @brief Convert events to Chrome trace JSON (chrome://tracing, Perfetto)
+ *
+ * Commands, SPI transactions and running tasks become slices on their own
+ * tracks, USB reports instant events. Timestamps are unwrapped from the 32-bit
+ * cycle counter and start at 0.
+ */
+std::string ToChromeTrace(const EventDump& dump);
+
+}  // namespace DAP::Sim
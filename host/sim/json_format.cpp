@@ -0,0 +1,15 @@
+#include "json_format.hpp"
+
+#include <cstdio>
+
+namespace DAP::Sim
+{
+
+std::string JsonNumber(double value)
+{
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.6g", value);
+  return buf;
+}
+
+}  // namespace DAP::Sim
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace DAP::Sim
+{
+
+/**
+ * @brief Format a JSON number with six significant digits
+ *
+ * Shared by the host tools that print JSON summaries, so their figures
+ * round the same way.
+ */
+std::string JsonNumber(double value);
+
+}  // namespace DAP::Sim
@@ -0,0 +1,133 @@
+#include "sim_dm.hpp"
+
+#include "dap_constants.hpp"
+
+namespace DAP::Sim
+{
+
+namespace
+{
+
+// sbcs fields (Debug Spec 0.13, 3.12.18)
+constexpr uint32_t SBCS_VERSION_1 = (1UL << 29);
+constexpr uint32_t SBCS_BUSYERROR = (1UL << 22);
+constexpr uint32_t SBCS_READONADDR = (1UL << 20);
+constexpr uint32_t SBCS_ACCESS_MASK = (7UL << 17);
+constexpr uint32_t SBCS_AUTOINCREMENT = (1UL << 16);
+constexpr uint32_t SBCS_READONDATA = (1UL << 15);
+constexpr uint32_t SBCS_ERROR_SHIFT = 12;
+constexpr uint32_t SBCS_ERROR = (7UL << SBCS_ERROR_SHIFT);
+constexpr uint32_t SBCS_ASIZE_32 = (32UL << 5);
+constexpr uint32_t SBCS_ACCESS32_SUPPORTED = (1UL << 2);
+constexpr uint32_t SBCS_CONTROL =
+    SBCS_READONADDR | SBCS_ACCESS_MASK | SBCS_AUTOINCREMENT | SBCS_READONDATA;
+
+constexpr uint32_t kSbErrorBadAddress = 2;
+
+}  // namespace
+
+SimDebugModule::SimDebugModule(uint32_t base, size_t words)
+    : base_(base), memory_(words, 0)
+{
+}
+
+bool SimDebugModule::Fault(uint32_t addr)
+{
+  const bool outside = addr < base_ || ((addr - base_) >> 2) >= memory_.size();
+  if (addr == fault_addr_ || outside || (addr & 3U) != 0)
+  {
+    sberror_ = kSbErrorBadAddress;
+    return true;
+  }
+  return false;
+}
+
+void SimDebugModule::BusRead()
+{
+  if (sberror_ != 0 || Fault(sbaddress_))
+  {
+    return;
+  }
+  sbdata_ = memory_[(sbaddress_ - base_) >> 2];
+  if (sbcs_ & SBCS_AUTOINCREMENT)
+  {
+    sbaddress_ += 4;
+  }
+}
+
+void SimDebugModule::BusWrite()
+{
+  if (sberror_ != 0 || Fault(sbaddress_))
+  {
+    return;
+  }
+  memory_[(sbaddress_ - base_) >> 2] = sbdata_;
+  if (sbcs_ & SBCS_AUTOINCREMENT)
+  {
+    sbaddress_ += 4;
+  }
+}
+
+uint8_t SimDebugModule::Read(uint8_t addr, uint32_t& value)
+{
+  switch (addr)
+  {
+    case DM_DMSTATUS:
+      value = kDmStatus;
+      break;
+    case DM_SBCS:
+      value = SBCS_VERSION_1 | sbcs_ | (sberror_ << SBCS_ERROR_SHIFT) |
+              (sbbusyerror_ ? SBCS_BUSYERROR : 0) | SBCS_ASIZE_32 |
+              SBCS_ACCESS32_SUPPORTED;
+      break;
+    case DM_SBADDRESS0:
+      value = sbaddress_;
+      break;
+    case DM_SBDATA0:
+      value = sbdata_;
+      if (sbcs_ & SBCS_READONDATA)
+      {
+        BusRead();
+      }
+      break;
+    default:
+      value = regs_[addr & 0x7F];
+      break;
+  }
+  return DAP_TRANSFER_OK;
+}
+
+uint8_t SimDebugModule::Write(uint8_t addr, uint32_t value)
+{
+  switch (addr)
+  {
+    case DM_SBCS:
+      sbcs_ = value & SBCS_CONTROL;
+      if (value & SBCS_ERROR)
+      {
+        sberror_ &= ~((value & SBCS_ERROR) >> SBCS_ERROR_SHIFT);
+      }
+      if (value & SBCS_BUSYERROR)
+      {
+        sbbusyerror_ = false;
+      }
+      break;
+    case DM_SBADDRESS0:
+      sbaddress_ = value;
+      if (sbcs_ & SBCS_READONADDR)
+      {
+        BusRead();
+      }
+      break;
+    case DM_SBDATA0:
+      sbdata_ = value;
+      BusWrite();
+      break;
+    default:
+      regs_[addr & 0x7F] = value;
+      break;
+  }
+  return DAP_TRANSFER_OK;
+}
+
+}  // namespace DAP::Sim
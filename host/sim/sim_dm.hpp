@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "dmi_port.hpp"
+
+namespace DAP::Sim
+{
+
+/**
+ * @class SimDebugModule
+ * @brief RISC-V Debug Module with System Bus Access over a word array,
+ *        reached directly as a DmiPort.
+ *
+ * sbcs models 32-bit sbaccess, sbautoincrement, sbreadonaddr, sbreadondata and
+ * the write-1-to-clear sberror/sbbusyerror. While sberror is set no bus access
+ * starts and sbaddress does not advance, as the Debug Spec requires. One bus
+ * address can be made to fault with sberror = 2 (bad address). dmstatus reads
+ * as an authenticated 0.13 module; other registers just hold what was written.
+ */
+class SimDebugModule : public DmiPort
+{
+ public:
+  static constexpr uint32_t kDmStatus = 0x00000082;  // authenticated, version 2
+
+  SimDebugModule(uint32_t base, size_t words);
+
+  uint8_t Read(uint8_t addr, uint32_t& value) override;
+  uint8_t Write(uint8_t addr, uint32_t value) override;
+
+  void SetFaultAddress(uint32_t addr) { fault_addr_ = addr; }
+
+  std::vector<uint32_t>& Memory() { return memory_; }
+  uint32_t Register(uint8_t addr) const { return regs_[addr & 0x7F]; }
+
+ private:
+  void BusRead();
+  void BusWrite();
+  bool Fault(uint32_t addr);
+
+  uint32_t base_;
+  std::vector<uint32_t> memory_;
+  uint32_t regs_[0x80] = {};
+  uint32_t sbcs_ = 0;  // Control bits only, errors are kept below
+  uint32_t sberror_ = 0;
+  bool sbbusyerror_ = false;
+  uint32_t sbaddress_ = 0;
+  uint32_t sbdata_ = 0;
+  uint32_t fault_addr_ = 0xFFFFFFFF;
+};
+
+}  // namespace DAP::Sim
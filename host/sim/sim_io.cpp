@@ -0,0 +1,39 @@
+#include "sim_io.hpp"
+
+namespace DAP::Sim
+{
+
+LibXR::ErrorCode SimSpi::ReadAndWrite(LibXR::RawData read_data,
+                                      LibXR::ConstRawData write_data, OperationRW& op)
+{
+  const auto* tx = static_cast<const uint8_t*>(write_data.addr_);
+  auto* rx = static_cast<uint8_t*>(read_data.addr_);
+  const size_t len = (read_data.size_ > write_data.size_) ? read_data.size_
+                                                         : write_data.size_;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    const uint8_t out = (tx && i < write_data.size_) ? tx[i] : 0x00;
+    uint8_t in = 0;
+    for (int bit = 7; bit >= 0; bit--)
+    {
+      in = static_cast<uint8_t>((in << 1) | bus_.Cycle((out >> bit) & 1U, false));
+    }
+    if (rx && i < read_data.size_)
+    {
+      rx[i] = in;
+    }
+  }
+
+  stats_.transactions++;
+  stats_.bytes += len;
+
+  // Transfers complete synchronously; blocking callers return straight away
+  if (op.type == OperationRW::OperationType::CALLBACK)
+  {
+    op.data.callback->Run(false, LibXR::ErrorCode::OK);
+  }
+  return LibXR::ErrorCode::OK;
+}
+
+}  // namespace DAP::Sim
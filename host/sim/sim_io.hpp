@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "libxr.hpp"
+#include "swd_target.hpp"
+
+namespace DAP::Sim
+{
+
+/**
+ * @class SimGpio
+ * @brief LibXR::GPIO that records its configuration and output level.
+ *
+ * Inputs read the level given by SetInput(), or the last written level.
+ */
+class SimGpio : public LibXR::GPIO
+{
+ public:
+  bool Read() override { return (input_ && !Output()) ? input_() : level_; }
+
+  LibXR::ErrorCode Write(bool value) override
+  {
+    level_ = value;
+    return LibXR::ErrorCode::OK;
+  }
+
+  LibXR::ErrorCode EnableInterrupt() override { return LibXR::ErrorCode::OK; }
+  LibXR::ErrorCode DisableInterrupt() override { return LibXR::ErrorCode::OK; }
+
+  LibXR::ErrorCode SetConfig(Configuration config) override
+  {
+    config_ = config;
+    return LibXR::ErrorCode::OK;
+  }
+
+  void SetInput(std::function<bool()> input) { input_ = std::move(input); }
+
+  bool Output() const
+  {
+    return config_.direction == Direction::OUTPUT_PUSH_PULL ||
+           config_.direction == Direction::OUTPUT_OPEN_DRAIN;
+  }
+  bool Level() const { return level_; }
+
+ private:
+  Configuration config_{Direction::INPUT, Pull::NONE};
+  bool level_ = true;
+  std::function<bool()> input_;
+};
+
+/**
+ * @class SwdBus
+ * @brief SWDIO line between the probe and a SwdTarget.
+ *
+ * Models the PalmDAP wiring: MOSI drives SWDIO weakly through the series
+ * resistor, the target overrides it, and the direct SWDIO GPIO overrides both
+ * when it is an output. With nothing driving, the pull-up wins.
+ */
+class SwdBus
+{
+ public:
+  SwdBus(SwdTarget& target, SimGpio& swdio) : target_(target), swdio_(swdio) {}
+
+  /**
+   * @brief SWDIO level before the next rising edge
+   * @param level Level the probe puts on the line
+   * @param strong Probe drives directly rather than through the resistor
+   */
+  bool Line(bool level, bool strong) const
+  {
+    if (swdio_.Output())
+    {
+      return swdio_.Level();
+    }
+    if (strong || !target_.Driving())
+    {
+      return level;
+    }
+    return target_.Level();
+  }
+
+  /**
+   * @brief One SWCLK period: sample SWDIO, then clock the target
+   * @return Level sampled before the rising edge
+   */
+  bool Cycle(bool level, bool strong)
+  {
+    const bool line = Line(level, strong);
+    target_.Clock(line);
+    return line;
+  }
+
+  SwdTarget& Target() { return target_; }
+
+ private:
+  SwdTarget& target_;
+  SimGpio& swdio_;
+};
+
+/**
+ * @class SimSpi
+ * @brief LibXR::SPI that clocks a SwdBus: SCK is SWCLK, MOSI and MISO share
+ *        SWDIO. Bytes are shifted MSB first, as on the CH32 SPI.
+ */
+class SimSpi : public LibXR::SPI
+{
+ public:
+  struct Stats
+  {
+    uint64_t transactions = 0;
+    uint64_t bytes = 0;
+  };
+
+  explicit SimSpi(SwdBus& bus) : bus_(bus) {}
+
+  LibXR::ErrorCode ReadAndWrite(LibXR::RawData read_data, LibXR::ConstRawData write_data,
+                                OperationRW& op) override;
+
+  LibXR::ErrorCode SetConfig(Configuration config) override
+  {
+    config_ = config;
+    return LibXR::ErrorCode::OK;
+  }
+
+  uint32_t GetMaxBusSpeed() const override { return 72000000; }
+  Prescaler GetMaxPrescaler() const override { return Prescaler::DIV_256; }
+
+  const Configuration& GetConfig() const { return config_; }
+  const Stats& GetStats() const { return stats_; }
+  void ClearStats() { stats_ = {}; }
+
+ private:
+  SwdBus& bus_;
+  Configuration config_{ClockPolarity::LOW, ClockPhase::EDGE_1};
+  Stats stats_;
+};
+
+/**
+ * @struct SimSwdPins
+ * @brief SwdBitbang pin policy on a SwdBus, the host twin of CH32SwdPins.
+ *
+ * SwdBitbang owns its policy, so the bus is bound through a static pointer;
+ * only one simulated bit-bang engine can be active at a time.
+ */
+struct SimSwdPins
+{
+  static constexpr bool kCycleCounter = false;
+  static constexpr uint32_t kDelayLoopCycles = 4;
+  static constexpr uint32_t kBitOverheadCycles = 12;
+  static constexpr uint32_t kCoreClockHz = 144000000;
+
+  static inline SwdBus* bus = nullptr;
+
+  void Setup() { output_ = true; }
+  void Release() { output_ = false; }
+
+  void ClockLow() {}
+  void ClockHigh() { bus->Cycle(output_ ? level_ : true, output_); }
+
+  void Out(bool high) { level_ = high; }
+  bool In() const { return bus->Line(true, false); }
+
+  void OutputEnable() { output_ = true; }
+  void OutputDisable() { output_ = false; }
+
+  uint32_t CoreClock() const { return kCoreClockHz; }
+  uint32_t CycleCount() const { return 0; }
+
+  bool level_ = true;
+  bool output_ = false;
+};
+
+}  // namespace DAP::Sim
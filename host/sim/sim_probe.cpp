@@ -0,0 +1,57 @@
+#include "sim_probe.hpp"
+
+#include <cstring>
+
+namespace DAP::Sim
+{
+
+SimPort::SimPort(const SwdTarget::Config& config)
+    : target(config), bus(target, swdio), spi(bus), io(spi, swdio, tdo, nreset, led)
+{
+}
+
+SimProbe::SimProbe() : SimProbe(SwdTarget::Config{}) {}
+
+SimProbe::SimProbe(const SwdTarget::Config& config, const DapGangIo* gang)
+    : target_(config),
+      bus_(target_, swdio_),
+      spi_(bus_),
+      io_(spi_, swdio_, tdo_, nreset_, led_),
+      bitbang_(io_),
+      dap_(io_, gang)
+{
+  SimSwdPins::bus = &bus_;
+  dap_.SetSwdBitbang(&bitbang_);
+  response_.reserve(kPacketSize);
+}
+
+const std::vector<uint8_t>& SimProbe::Execute(const uint8_t* request, size_t len)
+{
+  len = (len > sizeof(request_)) ? sizeof(request_) : len;
+  std::memset(request_, 0, sizeof(request_));
+  std::memcpy(request_, request, len);
+
+  const auto request_us = static_cast<uint32_t>(LibXR::Timebase::GetMicroseconds());
+  response_.clear();
+  auto callback = LibXR::Callback<const uint8_t*, size_t>::Create(
+      [](bool in_isr, SimProbe* self, const uint8_t* data, size_t size)
+      {
+        UNUSED(in_isr);
+        self->response_.insert(self->response_.end(), data, data + size);
+      },
+      this);
+
+  dap_.ExecuteCommand(request_, callback, len);
+
+  // Same capture point as the HID class: after the response went out
+  if (dap_.Trace().Enabled() &&
+      request_[0] != static_cast<uint8_t>(VendorCommandId::TRACE_Control))
+  {
+    dap_.Trace().Record(request_us, request_, len,
+                        static_cast<uint32_t>(LibXR::Timebase::GetMicroseconds()),
+                        response_.data(), response_.size());
+  }
+  return response_;
+}
+
+}  // namespace DAP::Sim
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "dap_config.hpp"
+#include "dap_io.hpp"
+#include "dap_protocol.hpp"
+#include "sim_io.hpp"
+#include "swd_bitbang.hpp"
+#include "swd_target.hpp"
+
+namespace DAP::Sim
+{
+
+/**
+ * @struct SimPort
+ * @brief A further SWD port for DapGangIo: its own SwdTarget, SWDIO line and
+ *        SPI, wired into a DapIo like the primary one.
+ */
+struct SimPort
+{
+  explicit SimPort(const SwdTarget::Config& config = {});
+
+  SwdTarget target;
+  SimGpio swdio;
+  SimGpio tdo;
+  SimGpio nreset;
+  SimGpio led;
+  SwdBus bus;
+  SimSpi spi;
+  DapIo io;
+};
+
+/**
+ * @class SimProbe
+ * @brief A PalmDAP wired to a simulated target: DapProtocol over SimSpi, plus
+ *        the GPIO bit-bang engine on SimSwdPins for SWD_SelectEngine.
+ *
+ * Requests are copied into a zeroed packet-sized buffer like the HID class
+ * does and executed with their own length, so short requests are rejected
+ * the way a variable-length transport would see them. While TRACE_Control
+ * capture runs, packets are recorded the way the HID class records them.
+ */
+class SimProbe
+{
+ public:
+  SimProbe();
+  explicit SimProbe(const SwdTarget::Config& config, const DapGangIo* gang = nullptr);
+
+  /**
+   * @brief Execute one DAP command
+   * @param request Request bytes, at most kPacketSize
+   * @param len Request length
+   * @return Response bytes
+   */
+  const std::vector<uint8_t>& Execute(const uint8_t* request, size_t len);
+  const std::vector<uint8_t>& Execute(const std::vector<uint8_t>& request)
+  {
+    return Execute(request.data(), request.size());
+  }
+
+  SwdTarget& Target() { return target_; }
+  SimSpi& Spi() { return spi_; }
+  SimGpio& Swdio() { return swdio_; }
+  SimGpio& NReset() { return nreset_; }
+  DapProtocol& Dap() { return dap_; }
+  const std::vector<uint8_t>& Response() const { return response_; }
+
+ private:
+  SwdTarget target_;
+  SimGpio swdio_;
+  SimGpio tdo_;
+  SimGpio nreset_;
+  SimGpio led_;
+  SwdBus bus_;
+  SimSpi spi_;
+  DapIo io_;
+  SwdBitbang<SimSwdPins> bitbang_;
+  DapProtocol dap_;
+
+  uint8_t request_[kPacketSize] = {};
+  std::vector<uint8_t> response_;
+};
+
+}  // namespace DAP::Sim
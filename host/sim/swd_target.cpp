@@ -0,0 +1,507 @@
+#include "swd_target.hpp"
+
+#include <cstring>
+
+#include "dap_constants.hpp"
+
+namespace DAP::Sim
+{
+
+namespace
+{
+
+// DP CTRL/STAT
+constexpr uint32_t CTRL_REQ_MASK = 0x54000000;  // CSYSPWRUPREQ, CDBGPWRUPREQ, CDBGRSTREQ
+constexpr uint32_t CTRL_STICKYERR = (1UL << 5);
+constexpr uint32_t CTRL_READOK = (1UL << 6);
+constexpr uint32_t CTRL_WDATAERR = (1UL << 7);
+
+// DP ABORT
+constexpr uint32_t ABORT_STKERRCLR = (1UL << 2);
+constexpr uint32_t ABORT_WDERRCLR = (1UL << 3);
+
+// MEM-AP
+constexpr uint8_t AP_BD0 = 0x10;
+constexpr uint8_t AP_BASE = 0xF8;
+constexpr uint32_t CSW_DEVICE_EN = (1UL << 6);
+constexpr uint32_t CSW_TR_IN_PROG = (1UL << 7);
+constexpr uint32_t kTarIncrementMask = 0x3FF;  // ADIv5 only guarantees 1 KB
+
+inline uint32_t Parity(uint64_t v)
+{
+  return static_cast<uint32_t>(__builtin_parityll(v));
+}
+
+}  // namespace
+
+SwdTarget::SwdTarget() : SwdTarget(Config{}) {}
+
+SwdTarget::SwdTarget(const Config& config) : config_(config), ram_(config.ram_size, 0)
+{
+  PowerOn();
+}
+
+void SwdTarget::PowerOn()
+{
+  phase_ = Phase::LOCKOUT;
+  driving_ = false;
+  level_ = true;
+  high_run_ = 0;
+  turnaround_ = 1;
+  sticky_err_ = false;
+  wdata_err_ = false;
+  read_ok_ = false;
+  ctrl_stat_ = 0;
+  select_ = 0;
+  rdbuff_ = 0;
+  csw_ = 0;
+  tar_ = 0;
+}
+
+void SwdTarget::SetConnected(bool connected)
+{
+  if (connected && !connected_)
+  {
+    PowerOn();
+  }
+  connected_ = connected;
+  driving_ = false;
+}
+
+void SwdTarget::Clock(bool swdio)
+{
+  if (!connected_)
+  {
+    return;
+  }
+  stats_.clocks++;
+
+  if (!driving_)
+  {
+    if (!swdio)
+    {
+      high_run_ = 0;
+    }
+    else if (++high_run_ >= kLineResetCycles)
+    {
+      if (high_run_ == kLineResetCycles)
+      {
+        LineReset();
+      }
+      return;
+    }
+  }
+
+  switch (phase_)
+  {
+    case Phase::LOCKOUT:
+      break;
+
+    case Phase::RESET:
+      if (!swdio)
+      {
+        phase_ = Phase::IDLE;
+      }
+      break;
+
+    case Phase::IDLE:
+      if (swdio)
+      {
+        header_ = 1;
+        bit_ = 1;
+        phase_ = Phase::HEADER;
+      }
+      break;
+
+    case Phase::HEADER:
+      header_ |= static_cast<uint32_t>(swdio) << bit_;
+      if (++bit_ == 8)
+      {
+        DecodeHeader();
+      }
+      break;
+
+    case Phase::TRN_IN:
+      // The ACK's first bit goes out on the last turnaround edge
+      if (++bit_ == turnaround_)
+      {
+        driving_ = true;
+        level_ = ack_ & 1U;
+        bit_ = 0;
+        phase_ = Phase::ACK;
+      }
+      break;
+
+    case Phase::ACK:
+      if (++bit_ < 3)
+      {
+        level_ = (ack_ >> bit_) & 1U;
+      }
+      else if (ack_ == DAP_TRANSFER_OK && rnw_)
+      {
+        level_ = shift_ & 1U;
+        bit_ = 0;
+        phase_ = Phase::READ_DATA;
+      }
+      else
+      {
+        driving_ = false;
+        bit_ = 0;
+        next_ = (ack_ == DAP_TRANSFER_OK) ? Phase::WRITE_DATA : Phase::IDLE;
+        phase_ = Phase::TRN_OUT;
+      }
+      break;
+
+    case Phase::READ_DATA:
+      if (++bit_ < 33)
+      {
+        level_ = (shift_ >> bit_) & 1U;
+      }
+      else
+      {
+        driving_ = false;
+        bit_ = 0;
+        next_ = Phase::IDLE;
+        phase_ = Phase::TRN_OUT;
+      }
+      break;
+
+    case Phase::TRN_OUT:
+      if (++bit_ == turnaround_)
+      {
+        bit_ = 0;
+        shift_ = 0;
+        phase_ = next_;
+      }
+      break;
+
+    case Phase::WRITE_DATA:
+      shift_ |= static_cast<uint64_t>(swdio) << bit_;
+      if (++bit_ == 33)
+      {
+        const auto value = static_cast<uint32_t>(shift_);
+        if (Parity(value) != ((shift_ >> 32) & 1U))
+        {
+          stats_.parity_errors++;
+          wdata_err_ = true;
+        }
+        else if (apndp_)
+        {
+          WriteAp(addr_, value);
+        }
+        else
+        {
+          WriteDp(addr_, value);
+        }
+        phase_ = Phase::IDLE;
+      }
+      break;
+
+    case Phase::TARGETSEL:
+    {
+      // Turnaround, three undriven ACK bits, turnaround, then data and parity
+      const uint32_t skip = 2U * turnaround_ + 3U;
+      if (bit_ >= skip)
+      {
+        shift_ |= static_cast<uint64_t>(swdio) << (bit_ - skip);
+      }
+      if (++bit_ == skip + 33)
+      {
+        const auto value = static_cast<uint32_t>(shift_);
+        const bool parity_ok = Parity(value) == ((shift_ >> 32) & 1U);
+        const bool match = config_.targetsel == 0 || value == config_.targetsel;
+        phase_ = (parity_ok && match) ? Phase::IDLE : Phase::LOCKOUT;
+      }
+      break;
+    }
+  }
+}
+
+void SwdTarget::LineReset()
+{
+  stats_.line_resets++;
+  phase_ = Phase::RESET;
+  driving_ = false;
+  level_ = true;
+}
+
+void SwdTarget::DecodeHeader()
+{
+  const uint32_t req4 = (header_ >> 1) & 0x0F;
+  const bool parity_ok = Parity(req4) == ((header_ >> 5) & 1U);
+  const bool stop = (header_ >> 6) & 1U;
+  const bool park = (header_ >> 7) & 1U;
+
+  if (!parity_ok || stop || !park)
+  {
+    stats_.protocol_errors++;
+    phase_ = Phase::LOCKOUT;
+    return;
+  }
+
+  apndp_ = (req4 & DAP_TRANSFER_APnDP) != 0;
+  rnw_ = (req4 & DAP_TRANSFER_RnW) != 0;
+  addr_ = static_cast<uint8_t>(req4 & 0x0C);
+  bit_ = 0;
+  shift_ = 0;
+
+  if (!apndp_ && !rnw_ && addr_ == DP_TARGETSEL)
+  {
+    phase_ = Phase::TARGETSEL;
+    return;
+  }
+
+  stats_.packets++;
+
+  // DPIDR and CTRL/STAT reads and ABORT writes never WAIT or FAULT
+  const bool exempt = !apndp_ && ((rnw_ && addr_ <= DP_CTRL_STAT) ||
+                                  (!rnw_ && addr_ == DP_ABORT));
+  ack_ = Respond(exempt);
+
+  if (ack_ == DAP_TRANSFER_OK && rnw_)
+  {
+    const uint32_t value = apndp_ ? ReadAp(addr_) : ReadDp(addr_);
+    shift_ = value | (static_cast<uint64_t>(Parity(value)) << 32);
+  }
+
+  phase_ = Phase::TRN_IN;
+}
+
+uint8_t SwdTarget::Respond(bool exempt)
+{
+  uint8_t ack = DAP_TRANSFER_OK;
+
+  if (!exempt)
+  {
+    if (wait_budget_ > 0)
+    {
+      wait_budget_--;
+      ack = DAP_TRANSFER_WAIT;
+    }
+    else if (wait_period_ != 0 && stats_.packets % wait_period_ == 0)
+    {
+      ack = DAP_TRANSFER_WAIT;
+    }
+    else if (sticky_err_ || wdata_err_)
+    {
+      ack = DAP_TRANSFER_FAULT;
+    }
+  }
+
+  switch (ack)
+  {
+    case DAP_TRANSFER_OK:
+      stats_.ok++;
+      break;
+    case DAP_TRANSFER_WAIT:
+      stats_.waits++;
+      break;
+    default:
+      stats_.faults++;
+      break;
+  }
+  return ack;
+}
+
+uint32_t SwdTarget::ReadDp(uint8_t addr)
+{
+  switch (addr)
+  {
+    case DP_IDCODE:
+      return config_.dpidr;
+
+    case DP_CTRL_STAT:
+      if ((select_ & 0x0F) == 1)
+      {
+        return static_cast<uint32_t>(turnaround_ - 1) << 8;  // DLCR
+      }
+      if ((select_ & 0x0F) != 0)
+      {
+        return 0;
+      }
+      return (ctrl_stat_ & CTRL_REQ_MASK) | ((ctrl_stat_ & CTRL_REQ_MASK) << 1) |
+             (sticky_err_ ? CTRL_STICKYERR : 0) | (read_ok_ ? CTRL_READOK : 0) |
+             (wdata_err_ ? CTRL_WDATAERR : 0);
+
+    default:  // RESEND and RDBUFF
+      return rdbuff_;
+  }
+}
+
+void SwdTarget::WriteDp(uint8_t addr, uint32_t value)
+{
+  switch (addr)
+  {
+    case DP_ABORT:
+      if (value & ABORT_STKERRCLR)
+      {
+        sticky_err_ = false;
+      }
+      if (value & ABORT_WDERRCLR)
+      {
+        wdata_err_ = false;
+      }
+      break;
+
+    case DP_CTRL_STAT:
+      if ((select_ & 0x0F) == 1)
+      {
+        turnaround_ = static_cast<uint8_t>(((value >> 8) & 3U) + 1U);
+      }
+      else if ((select_ & 0x0F) == 0)
+      {
+        ctrl_stat_ = value & CTRL_REQ_MASK;
+      }
+      break;
+
+    case DP_SELECT:
+      select_ = value;
+      break;
+
+    default:
+      break;
+  }
+}
+
+uint32_t SwdTarget::ReadAp(uint8_t addr)
+{
+  const auto reg = static_cast<uint8_t>((select_ & 0xF0) | addr);
+  uint32_t value = 0;
+
+  if ((select_ >> 24) == 0)
+  {
+    switch (reg)
+    {
+      case AP_CSW:
+        value = (csw_ & ~CSW_TR_IN_PROG) | CSW_DEVICE_EN;
+        break;
+      case AP_TAR:
+        value = tar_;
+        break;
+      case AP_DRW:
+        MemAccess(tar_, csw_ & 7U, value, false);
+        AdvanceTar();
+        break;
+      case AP_BASE:
+        value = 0xE00FF003;
+        break;
+      case AP_IDR:
+        value = config_.ap_idr;
+        break;
+      default:
+        if (reg >= AP_BD0 && reg < AP_BD0 + 0x10)
+        {
+          MemAccess((tar_ & ~0x0FU) | (reg & 0x0CU), csw_ & 7U, value, false);
+        }
+        break;
+    }
+  }
+
+  // Posted: this access returns the previous result
+  const uint32_t posted = rdbuff_;
+  rdbuff_ = value;
+  read_ok_ = true;
+  return posted;
+}
+
+void SwdTarget::WriteAp(uint8_t addr, uint32_t value)
+{
+  const auto reg = static_cast<uint8_t>((select_ & 0xF0) | addr);
+  if ((select_ >> 24) != 0)
+  {
+    return;
+  }
+
+  switch (reg)
+  {
+    case AP_CSW:
+      csw_ = value & ~(CSW_DEVICE_EN | CSW_TR_IN_PROG);
+      break;
+    case AP_TAR:
+      tar_ = value;
+      break;
+    case AP_DRW:
+      MemAccess(tar_, csw_ & 7U, value, true);
+      AdvanceTar();
+      break;
+    default:
+      if (reg >= AP_BD0 && reg < AP_BD0 + 0x10)
+      {
+        MemAccess((tar_ & ~0x0FU) | (reg & 0x0CU), csw_ & 7U, value, true);
+      }
+      break;
+  }
+}
+
+bool SwdTarget::MemAccess(uint32_t addr, uint32_t size, uint32_t& value, bool write)
+{
+  const uint32_t bytes = (size > 2) ? 4 : (1U << size);
+  const uint32_t base = addr & ~(bytes - 1);
+  const uint32_t lane = base & 3U;
+
+  if (base < config_.ram_base || base - config_.ram_base + bytes > config_.ram_size)
+  {
+    sticky_err_ = true;  // Bus error
+    if (!write)
+    {
+      value = 0;
+    }
+    return false;
+  }
+
+  uint8_t* p = &ram_[(base - config_.ram_base) & address_mask_];
+  if (write)
+  {
+    for (uint32_t i = 0; i < bytes; i++)
+    {
+      p[i] = static_cast<uint8_t>(value >> ((lane + i) * 8));
+    }
+  }
+  else
+  {
+    value = 0;
+    for (uint32_t i = 0; i < bytes; i++)
+    {
+      value |= static_cast<uint32_t>(p[i]) << ((lane + i) * 8);
+    }
+    if ((base & ~3U) == stuck_addr_)
+    {
+      const uint32_t lanes =
+          (bytes == 4) ? 0xFFFFFFFFUL : ((1UL << (bytes * 8)) - 1) << (lane * 8);
+      const uint32_t mask = stuck_mask_ & lanes;
+      value = (value & ~mask) | (stuck_value_ & mask);
+    }
+  }
+  return true;
+}
+
+void SwdTarget::AdvanceTar()
+{
+  if (((csw_ >> 4) & 3U) == 0)
+  {
+    return;
+  }
+  const uint32_t size = csw_ & 7U;
+  const uint32_t bytes = (size > 2) ? 4 : (1U << size);
+  tar_ = (tar_ & ~kTarIncrementMask) | ((tar_ + bytes) & kTarIncrementMask);
+}
+
+uint32_t SwdTarget::ReadWord(uint32_t addr) const
+{
+  uint32_t value = 0;
+  if (addr >= config_.ram_base && addr - config_.ram_base + 4 <= config_.ram_size)
+  {
+    std::memcpy(&value, &ram_[addr - config_.ram_base], sizeof(value));
+  }
+  return value;
+}
+
+void SwdTarget::WriteWord(uint32_t addr, uint32_t value)
+{
+  if (addr >= config_.ram_base && addr - config_.ram_base + 4 <= config_.ram_size)
+  {
+    std::memcpy(&ram_[addr - config_.ram_base], &value, sizeof(value));
+  }
+}
+
+}  // namespace DAP::Sim
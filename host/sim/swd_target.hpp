@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace DAP::Sim
+{
+
+/**
+ * @class SwdTarget
+ * @brief Bit-accurate SWD target: an ADIv5 SW-DP with one MEM-AP in front of RAM.
+ *
+ * The probe side calls Clock() once per rising SWCLK edge with the level it
+ * drives on SWDIO, then reads Driving()/Level() for what the target puts on the
+ * line before the next edge. The DP follows the ADIv5.2 packet rules closely
+ * enough to catch off-by-one turnaround, parity and posted-read mistakes:
+ *
+ * - A line reset (50+ high cycles, then an idle low cycle) is required first
+ *   and after any protocol error; bad headers lock the target out.
+ * - AP reads are posted through RDBUFF; DRW auto-increment wraps at 1 KB.
+ * - Sticky errors make every access but DPIDR/CTRL-STAT reads and ABORT writes
+ *   answer FAULT until ABORT clears them.
+ * - With a TARGETSEL configured, only a matching TARGETSEL after a line reset
+ *   keeps the DP selected.
+ *
+ * WAIT and FAULT can be injected to exercise the probe's retry paths, and
+ * stuck bits or aliased address lines to exercise memory tests.
+ */
+class SwdTarget
+{
+ public:
+  struct Config
+  {
+    uint32_t dpidr = 0x2BA01477;   // ARM DPv1 (Cortex-M3/M4)
+    uint32_t targetsel = 0;        // Multi-drop TARGETSEL, 0 if not multi-drop
+    uint32_t ap_idr = 0x24770011;  // AHB-AP
+    uint32_t ram_base = 0x20000000;
+    uint32_t ram_size = 64 * 1024;
+  };
+
+  struct Stats
+  {
+    uint64_t clocks = 0;
+    uint64_t packets = 0;
+    uint64_t ok = 0;
+    uint64_t waits = 0;
+    uint64_t faults = 0;
+    uint64_t protocol_errors = 0;
+    uint64_t line_resets = 0;
+    uint64_t parity_errors = 0;
+  };
+
+  SwdTarget();
+  explicit SwdTarget(const Config& config);
+
+  /**
+   * @brief One rising SWCLK edge
+   * @param swdio SWDIO level seen by the target (ignored while it drives)
+   */
+  void Clock(bool swdio);
+
+  bool Driving() const { return driving_; }
+  bool Level() const { return level_; }
+
+  /**
+   * @brief Answer WAIT to the next packets that are allowed to WAIT
+   * @param count Number of packets
+   */
+  void InjectWait(uint32_t count) { wait_budget_ = count; }
+
+  /**
+   * @brief Answer WAIT to every n-th packet (retries are new packets)
+   * @param period 0 disables
+   */
+  void SetWaitPeriod(uint32_t period) { wait_period_ = period; }
+
+  /**
+   * @brief Raise STICKYERR as a failed bus access would
+   */
+  void InjectFault() { sticky_err_ = true; }
+
+  /**
+   * @brief Unplug or plug the target; unplugged it never drives SWDIO, so the
+   *        line floats high. Plugging in starts from power-on
+   */
+  void SetConnected(bool connected);
+
+  /**
+   * @brief Defective RAM cell: bits in mask of the word at addr read as in value
+   * @param mask 0 disables
+   */
+  void SetStuckBits(uint32_t addr, uint32_t mask, uint32_t value)
+  {
+    stuck_addr_ = addr & ~3U;
+    stuck_mask_ = mask;
+    stuck_value_ = value;
+  }
+
+  /**
+   * @brief Missing address lines: RAM offsets are ANDed with mask, so parts of
+   *        RAM alias each other
+   * @param mask 0xFFFFFFFF disables
+   */
+  void SetAddressMask(uint32_t mask) { address_mask_ = mask; }
+
+  /**
+   * @brief Power-on state: registers cleared, RAM kept, locked out until a line
+   *        reset
+   */
+  void PowerOn();
+
+  uint32_t ReadWord(uint32_t addr) const;
+  void WriteWord(uint32_t addr, uint32_t value);
+  uint8_t* Ram() { return ram_.data(); }
+  const Config& GetConfig() const { return config_; }
+
+  const Stats& GetStats() const { return stats_; }
+  void ClearStats() { stats_ = {}; }
+
+  uint8_t Turnaround() const { return turnaround_; }
+  bool StickyError() const { return sticky_err_; }
+
+ private:
+  enum class Phase : uint8_t
+  {
+    LOCKOUT,     // Waiting for a line reset
+    RESET,       // Line reset seen, waiting for the first idle cycle
+    IDLE,        // Waiting for a start bit
+    HEADER,      // Request bits 1..7
+    TRN_IN,      // Turnaround before the ACK
+    ACK,         // Driving ACK (and read data)
+    READ_DATA,   // Driving read data and parity
+    TRN_OUT,     // Turnaround back to the host
+    WRITE_DATA,  // Sampling write data and parity
+    TARGETSEL    // Undriven ACK, then TARGETSEL data
+  };
+
+  static constexpr uint32_t kLineResetCycles = 50;
+
+  void LineReset();
+  void DecodeHeader();
+  uint8_t Respond(bool exempt);
+
+  uint32_t ReadDp(uint8_t addr);
+  void WriteDp(uint8_t addr, uint32_t value);
+  uint32_t ReadAp(uint8_t addr);
+  void WriteAp(uint8_t addr, uint32_t value);
+
+  bool MemAccess(uint32_t addr, uint32_t size, uint32_t& value, bool write);
+  void AdvanceTar();
+
+  Config config_;
+  Stats stats_;
+  std::vector<uint8_t> ram_;
+
+  // Wire state
+  Phase phase_ = Phase::LOCKOUT;
+  Phase next_ = Phase::IDLE;  // Phase after TRN_OUT
+  bool driving_ = false;
+  bool level_ = true;
+  uint32_t high_run_ = 0;
+  uint32_t bit_ = 0;
+  uint32_t header_ = 0;
+  uint8_t ack_ = 0;
+  uint64_t shift_ = 0;
+  uint8_t turnaround_ = 1;
+
+  // Decoded request
+  bool apndp_ = false;
+  bool rnw_ = false;
+  uint8_t addr_ = 0;
+
+  // Fault injection
+  bool connected_ = true;
+  uint32_t wait_budget_ = 0;
+  uint32_t wait_period_ = 0;
+  uint32_t stuck_addr_ = 0;
+  uint32_t stuck_mask_ = 0;
+  uint32_t stuck_value_ = 0;
+  uint32_t address_mask_ = 0xFFFFFFFF;
+
+  // DP
+  bool sticky_err_ = false;
+  bool wdata_err_ = false;
+  bool read_ok_ = false;
+  uint32_t ctrl_stat_ = 0;
+  uint32_t select_ = 0;
+  uint32_t rdbuff_ = 0;
+
+  // MEM-AP
+  uint32_t csw_ = 0;
+  uint32_t tar_ = 0;
+};
+
+}  // namespace DAP::Sim
@@ -0,0 +1,148 @@
+#include "trace_replay.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "dap_constants.hpp"
+#include "dap_utils.hpp"
+#include "packet_trace.hpp"
+
+namespace DAP::Sim
+{
+
+bool ParseTrace(const std::vector<uint8_t>& data, std::vector<TraceRecord>& records,
+                std::string& error)
+{
+  if (data.size() < PacketTrace::kHeaderSize ||
+      std::memcmp(data.data(), PacketTrace::kMagic, sizeof(PacketTrace::kMagic)) != 0)
+  {
+    error = "not a packet trace";
+    return false;
+  }
+  if (GetU16(&data[4]) != PacketTrace::kVersion)
+  {
+    error = "unsupported trace version " + std::to_string(GetU16(&data[4]));
+    return false;
+  }
+  if (GetU16(&data[6]) > kPacketSize)
+  {
+    error = "trace packet size " + std::to_string(GetU16(&data[6])) +
+            " exceeds the probe's " + std::to_string(kPacketSize);
+    return false;
+  }
+
+  size_t pos = PacketTrace::kHeaderSize;
+  while (pos < data.size())
+  {
+    if (data.size() - pos < PacketTrace::kRecordHeaderSize)
+    {
+      error = "truncated record header at offset " + std::to_string(pos);
+      return false;
+    }
+
+    TraceRecord record;
+    record.request_us = GetU32(&data[pos]);
+    record.response_us = GetU32(&data[pos + 4]);
+    const size_t request_len = data[pos + 8];
+    const size_t response_len = data[pos + 9];
+    pos += PacketTrace::kRecordHeaderSize;
+
+    if (data.size() - pos < request_len + response_len)
+    {
+      error = "truncated record at offset " + std::to_string(pos);
+      return false;
+    }
+
+    record.request.assign(data.begin() + pos, data.begin() + pos + request_len);
+    pos += request_len;
+    record.response.assign(data.begin() + pos, data.begin() + pos + response_len);
+    pos += response_len;
+
+    records.push_back(std::move(record));
+  }
+
+  return true;
+}
+
+bool LoadTrace(const std::string& path, std::vector<TraceRecord>& records,
+               std::string& error)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    error = "cannot open " + path;
+    return false;
+  }
+
+  const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+  return ParseTrace(data, records, error);
+}
+
+TraceReplayer::Result TraceReplayer::Run(const std::vector<TraceRecord>& records,
+                                         size_t keep_mismatches)
+{
+  Result result;
+  const uint64_t clocks_before = probe_.Target().GetStats().clocks;
+  const auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < records.size(); i++)
+  {
+    const auto& record = records[i];
+
+    // Captured from full-size HID reports, with the trailing zeros trimmed
+    std::vector<uint8_t> request = record.request;
+    request.resize(kPacketSize, 0);
+    const auto& response = probe_.Execute(request);
+
+    result.records++;
+    result.recorded_us += record.response_us - record.request_us;
+
+    if (!Matches(record.response, response))
+    {
+      result.mismatches++;
+      if (result.first_mismatches.size() < keep_mismatches)
+      {
+        result.first_mismatches.push_back({i, record.response, response});
+      }
+    }
+  }
+
+  result.replay_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  result.swclk = probe_.Target().GetStats().clocks - clocks_before;
+  return result;
+}
+
+bool TraceReplayer::Matches(const std::vector<uint8_t>& expected,
+                            const std::vector<uint8_t>& actual) const
+{
+  if (compare_ == Compare::Exact || expected.empty())
+  {
+    return expected == actual;
+  }
+
+  if (expected.size() != actual.size())
+  {
+    return false;
+  }
+
+  // Command, Count, Ack for DAP_Transfer; Command, Count(2), Ack for blocks;
+  // Command, Status otherwise
+  size_t status_len = 2;
+  if (expected[0] == static_cast<uint8_t>(CommandId::Transfer))
+  {
+    status_len = 3;
+  }
+  else if (expected[0] == static_cast<uint8_t>(CommandId::TransferBlock))
+  {
+    status_len = 4;
+  }
+
+  status_len = (status_len < expected.size()) ? status_len : expected.size();
+  return std::memcmp(expected.data(), actual.data(), status_len) == 0;
+}
+
+}  // namespace DAP::Sim
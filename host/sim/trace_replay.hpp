@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sim_probe.hpp"
+
+namespace DAP::Sim
+{
+
+/**
+ * @brief One request/response pair of a PacketTrace stream
+ */
+struct TraceRecord
+{
+  uint32_t request_us = 0;
+  uint32_t response_us = 0;
+  std::vector<uint8_t> request;
+  std::vector<uint8_t> response;
+};
+
+/**
+ * @brief Decode a PacketTrace stream
+ * @param data Stream bytes as drained with TRACE_Control
+ * @param records Decoded records, appended
+ * @param error Reason on failure
+ * @return False on a bad header or a truncated record
+ */
+bool ParseTrace(const std::vector<uint8_t>& data, std::vector<TraceRecord>& records,
+                std::string& error);
+
+/**
+ * @brief Read and decode a trace file
+ */
+bool LoadTrace(const std::string& path, std::vector<TraceRecord>& records,
+               std::string& error);
+
+/**
+ * @class TraceReplayer
+ * @brief Feeds recorded requests through a SimProbe and compares responses.
+ *
+ * In Exact mode responses must match byte for byte, which holds for traces
+ * taken against the simulator. Traces from real targets read other memory
+ * and IDs, so Status mode only compares the response length and the status
+ * fields: command and status bytes, and for DAP_Transfer / DAP_TransferBlock
+ * the transfer count and acknowledge.
+ */
+class TraceReplayer
+{
+ public:
+  enum class Compare : uint8_t
+  {
+    Exact,
+    Status
+  };
+
+  struct Mismatch
+  {
+    size_t index = 0;
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> actual;
+  };
+
+  struct Result
+  {
+    size_t records = 0;
+    size_t mismatches = 0;
+    uint64_t recorded_us = 0;  // Sum of request-to-response times on the probe
+    double replay_seconds = 0;
+    uint64_t swclk = 0;
+    std::vector<Mismatch> first_mismatches;
+  };
+
+  TraceReplayer(SimProbe& probe, Compare compare) : probe_(probe), compare_(compare) {}
+
+  /**
+   * @brief Replay records in order
+   * @param records Trace to replay
+   * @param keep_mismatches Mismatches kept with their bytes for reporting
+   */
+  Result Run(const std::vector<TraceRecord>& records, size_t keep_mismatches = 8);
+
+  /**
+   * @brief Whether a replayed response matches the recorded one
+   */
+  bool Matches(const std::vector<uint8_t>& expected,
+               const std::vector<uint8_t>& actual) const;
+
+ private:
+  SimProbe& probe_;
+  Compare compare_;
+};
+
+}  // namespace DAP::Sim
@@ -0,0 +1,1241 @@
+// End-to-end checks of DapProtocol against the simulated SWD target, on both
+// SWD engines.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crc_unit.hpp"
+#include "dap_constants.hpp"
+#include "dap_utils.hpp"
+#include "event_dump.hpp"
+#include "event_trace.hpp"
+#include "riscv_sba.hpp"
+#include "sim_dm.hpp"
+#include "sim_probe.hpp"
+#include "trace_replay.hpp"
+
+using DAP::Sim::SimPort;
+using DAP::Sim::SimProbe;
+
+namespace
+{
+
+int failures = 0;
+
+#define CHECK(cond)                                                        \
+  do                                                                       \
+  {                                                                        \
+    if (!(cond))                                                           \
+    {                                                                      \
+      std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      failures++;                                                          \
+    }                                                                      \
+  } while (0)
+
+constexpr uint8_t kCmdConnect = static_cast<uint8_t>(DAP::CommandId::Connect);
+constexpr uint8_t kCmdWriteAbort = static_cast<uint8_t>(DAP::CommandId::WriteABORT);
+constexpr uint8_t kCmdSwjClock = static_cast<uint8_t>(DAP::CommandId::SWJ_Clock);
+constexpr uint8_t kCmdTransferConfigure =
+    static_cast<uint8_t>(DAP::CommandId::TransferConfigure);
+constexpr uint8_t kCmdTransfer = static_cast<uint8_t>(DAP::CommandId::Transfer);
+constexpr uint8_t kCmdTransferBlock = static_cast<uint8_t>(DAP::CommandId::TransferBlock);
+constexpr uint8_t kCmdSwjSequence = static_cast<uint8_t>(DAP::CommandId::SWJ_Sequence);
+constexpr uint8_t kCmdSwdConfigure = static_cast<uint8_t>(DAP::CommandId::SWD_Configure);
+constexpr uint8_t kCmdRttStart = static_cast<uint8_t>(DAP::VendorCommandId::RTT_Start);
+constexpr uint8_t kCmdRttStop = static_cast<uint8_t>(DAP::VendorCommandId::RTT_Stop);
+constexpr uint8_t kCmdRttRead = static_cast<uint8_t>(DAP::VendorCommandId::RTT_Read);
+constexpr uint8_t kCmdSwitchTarget =
+    static_cast<uint8_t>(DAP::VendorCommandId::SWD_SwitchTarget);
+constexpr uint8_t kCmdMemCrc32 = static_cast<uint8_t>(DAP::VendorCommandId::MEM_Crc32);
+constexpr uint8_t kCmdMemSectorDiff =
+    static_cast<uint8_t>(DAP::VendorCommandId::MEM_SectorDiff);
+constexpr uint8_t kCmdMemRead = static_cast<uint8_t>(DAP::VendorCommandId::MEM_Read);
+constexpr uint8_t kCmdMemWrite = static_cast<uint8_t>(DAP::VendorCommandId::MEM_Write);
+constexpr uint8_t kCmdMemFill = static_cast<uint8_t>(DAP::VendorCommandId::MEM_Fill);
+constexpr uint8_t kCmdMemBlankCheck =
+    static_cast<uint8_t>(DAP::VendorCommandId::MEM_BlankCheck);
+constexpr uint8_t kCmdMemRamTest =
+    static_cast<uint8_t>(DAP::VendorCommandId::MEM_RamTest);
+constexpr uint8_t kCmdMemSearch = static_cast<uint8_t>(DAP::VendorCommandId::MEM_Search);
+constexpr uint8_t kCmdSelectEngine =
+    static_cast<uint8_t>(DAP::VendorCommandId::SWD_SelectEngine);
+constexpr uint8_t kCmdTraceControl =
+    static_cast<uint8_t>(DAP::VendorCommandId::TRACE_Control);
+constexpr uint8_t kCmdStatsRead = static_cast<uint8_t>(DAP::VendorCommandId::STATS_Read);
+constexpr uint8_t kCmdEventRead = static_cast<uint8_t>(DAP::VendorCommandId::EVENT_Read);
+constexpr uint8_t kCmdSysStats = static_cast<uint8_t>(DAP::VendorCommandId::SYS_Stats);
+
+constexpr uint8_t kCmdGangConnect =
+    static_cast<uint8_t>(DAP::VendorCommandId::GANG_Connect);
+constexpr uint8_t kCmdGangBlock =
+    static_cast<uint8_t>(DAP::VendorCommandId::GANG_TransferBlock);
+
+constexpr uint8_t kStatusOk = static_cast<uint8_t>(DAP::Status::OK);
+constexpr uint8_t kStatusError = static_cast<uint8_t>(DAP::Status::Error);
+
+constexpr uint8_t kApRead = DAP::DAP_TRANSFER_APnDP | DAP::DAP_TRANSFER_RnW;
+constexpr uint8_t kApWrite = DAP::DAP_TRANSFER_APnDP;
+constexpr uint8_t kDpRead = DAP::DAP_TRANSFER_RnW;
+constexpr uint8_t kDpWrite = 0;
+
+void Put32(std::vector<uint8_t>& v, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    v.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+/**
+ * @brief Single DAP_Transfer
+ * @return Transfer response byte; value holds read data
+ */
+uint8_t Transfer(SimProbe& probe, uint8_t request, uint32_t& value)
+{
+  std::vector<uint8_t> req = {kCmdTransfer, 0, 1, request};
+  if (!(request & DAP::DAP_TRANSFER_RnW))
+  {
+    Put32(req, value);
+  }
+  const auto& resp = probe.Execute(req);
+  if (resp.size() < 3 || resp[0] != kCmdTransfer)
+  {
+    return 0;
+  }
+  if ((request & DAP::DAP_TRANSFER_RnW) && resp[1] == 1 && resp.size() >= 7)
+  {
+    value = DAP::GetU32(&resp[3]);
+  }
+  return resp[2];
+}
+
+uint8_t Write(SimProbe& probe, uint8_t request, uint32_t value)
+{
+  return Transfer(probe, request, value);
+}
+
+uint8_t Read(SimProbe& probe, uint8_t request, uint32_t& value)
+{
+  return Transfer(probe, request, value);
+}
+
+bool Connect(SimProbe& probe)
+{
+  const auto& resp = probe.Execute({kCmdConnect, 1});
+  return resp.size() == 2 && resp[1] == 1;
+}
+
+bool LineReset(SimProbe& probe)
+{
+  const auto& resp = probe.Execute(
+      {kCmdSwjSequence, 64, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00});
+  return resp.size() == 2 && resp[1] == static_cast<uint8_t>(DAP::Status::OK);
+}
+
+// Connect, clear errors and power up the debug domain for MEM-AP access
+bool PowerUp(SimProbe& probe)
+{
+  return Connect(probe) &&
+         Write(probe, kDpWrite | DAP::DP_ABORT, 0x1E) == DAP::DAP_TRANSFER_OK &&
+         Write(probe, kDpWrite | DAP::DP_SELECT, 0) == DAP::DAP_TRANSFER_OK &&
+         Write(probe, kDpWrite | DAP::DP_CTRL_STAT, 0x50000000) == DAP::DAP_TRANSFER_OK;
+}
+
+void TestConnect(SimProbe& probe)
+{
+  uint32_t dpidr = 0;
+  CHECK(Connect(probe));
+  CHECK(Read(probe, kDpRead | DAP::DP_IDCODE, dpidr) == DAP::DAP_TRANSFER_OK);
+  CHECK(dpidr == probe.Target().GetConfig().dpidr);
+
+  uint32_t ctrl = 0;
+  CHECK(Write(probe, kDpWrite | DAP::DP_ABORT, 0x1E) == DAP::DAP_TRANSFER_OK);
+  CHECK(Write(probe, kDpWrite | DAP::DP_SELECT, 0) == DAP::DAP_TRANSFER_OK);
+  CHECK(Write(probe, kDpWrite | DAP::DP_CTRL_STAT, 0x50000000) == DAP::DAP_TRANSFER_OK);
+  CHECK(Read(probe, kDpRead | DAP::DP_CTRL_STAT, ctrl) == DAP::DAP_TRANSFER_OK);
+  CHECK((ctrl & 0xF0000000) == 0xF0000000);
+
+  uint32_t idr = 0;
+  CHECK(Write(probe, kDpWrite | DAP::DP_SELECT, 0xF0) == DAP::DAP_TRANSFER_OK);
+  CHECK(Read(probe, kApRead | DAP::AP_DRW, idr) == DAP::DAP_TRANSFER_OK);  // 0xFC
+  CHECK(idr == probe.Target().GetConfig().ap_idr);
+  CHECK(Write(probe, kDpWrite | DAP::DP_SELECT, 0) == DAP::DAP_TRANSFER_OK);
+}
+
+void TestBlock(SimProbe& probe)
+{
+  constexpr uint32_t kAddr = 0x20000100;
+  constexpr uint16_t kWords = 14;  // One full-speed packet
+
+  CHECK(Write(probe, kApWrite | DAP::AP_CSW, 0x23000012) == DAP::DAP_TRANSFER_OK);
+  CHECK(Write(probe, kApWrite | DAP::AP_TAR, kAddr) == DAP::DAP_TRANSFER_OK);
+
+  std::vector<uint8_t> req = {kCmdTransferBlock, 0, kWords, 0, kApWrite | DAP::AP_DRW};
+  for (uint32_t i = 0; i < kWords; i++)
+  {
+    Put32(req, 0xA5000000 + i * 0x01010101);
+  }
+  auto resp = probe.Execute(req);
+  CHECK(resp.size() == 4 && DAP::GetU16(&resp[1]) == kWords &&
+        resp[3] == DAP::DAP_TRANSFER_OK);
+
+  for (uint32_t i = 0; i < kWords; i++)
+  {
+    CHECK(probe.Target().ReadWord(kAddr + 4 * i) == 0xA5000000 + i * 0x01010101);
+  }
+
+  CHECK(Write(probe, kApWrite | DAP::AP_TAR, kAddr) == DAP::DAP_TRANSFER_OK);
+  resp = probe.Execute({kCmdTransferBlock, 0, kWords, 0, kApRead | DAP::AP_DRW});
+  CHECK(resp.size() == 4 + 4 * kWords && resp[3] == DAP::DAP_TRANSFER_OK);
+  for (uint32_t i = 0; i < kWords && resp.size() >= 4 + 4 * kWords; i++)
+  {
+    CHECK(DAP::GetU32(&resp[4 + 4 * i]) == 0xA5000000 + i * 0x01010101);
+  }
+}
+
+void TestWaitFault(SimProbe& probe)
+{
+  uint32_t value = 0;
+
+  // WAITs within the retry budget are invisible to the host
+  probe.Target().InjectWait(5);
+  CHECK(Read(probe, kApRead | DAP::AP_TAR, value) == DAP::DAP_TRANSFER_OK);
+  CHECK(Read(probe, kDpRead | DAP::DP_RDBUFF, value) == DAP::DAP_TRANSFER_OK);
+
+  // ... beyond it the WAIT is reported
+  CHECK(probe.Execute({kCmdTransferConfigure, 0, 2, 0, 0, 0}).size() == 2);
+  probe.Target().InjectWait(10);
+  CHECK(Read(probe, kApRead | DAP::AP_TAR, value) == DAP::DAP_TRANSFER_WAIT);
+  probe.Target().InjectWait(0);
+  CHECK(probe.Execute({kCmdTransferConfigure, 0, 100, 0, 0, 0}).size() == 2);
+
+  // Sticky error: FAULT until ABORT.STKERRCLR
+  probe.Target().InjectFault();
+  CHECK(Read(probe, kApRead | DAP::AP_CSW, value) == DAP::DAP_TRANSFER_FAULT);
+  CHECK(Read(probe, kDpRead | DAP::DP_CTRL_STAT, value) == DAP::DAP_TRANSFER_OK);
+  CHECK(value & 0x20);
+  CHECK(Write(probe, kDpWrite | DAP::DP_ABORT, 0x04) == DAP::DAP_TRANSFER_OK);
+  CHECK(Read(probe, kApRead | DAP::AP_CSW, value) == DAP::DAP_TRANSFER_OK);
+
+  // A bus error on an unmapped address surfaces on a later access
+  CHECK(Write(probe, kApWrite | DAP::AP_TAR, 0x10000000) == DAP::DAP_TRANSFER_OK);
+  CHECK(Write(probe, kApWrite | DAP::AP_DRW, 0) == DAP::DAP_TRANSFER_FAULT);
+  CHECK(Write(probe, kDpWrite | DAP::DP_ABORT, 0x1E) == DAP::DAP_TRANSFER_OK);
+}
+
+void TestTurnaround(SimProbe& probe)
+{
+  uint32_t value = 0;
+
+  // The DLCR write switches the target at once, so the probe's RDBUFF check of
+  // that write runs with the old turnaround; resynchronise with a line reset
+  CHECK(Write(probe, kDpWrite | DAP::DP_SELECT, 1) == DAP::DAP_TRANSFER_OK);
+  Write(probe, kDpWrite | DAP::DP_CTRL_STAT, 0x100);
+  CHECK(probe.Target().Turnaround() == 2);
+  CHECK(probe.Execute({kCmdSwdConfigure, 0x01}).size() == 2);
+  CHECK(LineReset(probe));
+
+  const uint64_t errors = probe.Target().GetStats().protocol_errors;
+  CHECK(Read(probe, kDpRead | DAP::DP_IDCODE, value) == DAP::DAP_TRANSFER_OK);
+  CHECK(value == probe.Target().GetConfig().dpidr);
+  CHECK(Write(probe, kDpWrite | DAP::DP_SELECT, 0) == DAP::DAP_TRANSFER_OK);
+  TestBlock(probe);
+  CHECK(probe.Target().GetStats().protocol_errors == errors);
+}
+
+void TestMultidrop()
+{
+  DAP::Sim::SwdTarget::Config config;
+  config.dpidr = 0x0BC12477;  // DPv2
+  config.targetsel = 0x01002927;
+  SimProbe probe(config);
+
+  CHECK(Connect(probe));
+
+  std::vector<uint8_t> req = {kCmdSwitchTarget};
+  Put32(req, config.targetsel);
+  auto resp = probe.Execute(req);
+  CHECK(resp.size() == 6 && resp[1] == static_cast<uint8_t>(DAP::Status::OK));
+  CHECK(resp.size() == 6 && DAP::GetU32(&resp[2]) == config.dpidr);
+
+  // Another TARGETSEL deselects the DP, which then leaves the line undriven
+  req = {kCmdSwitchTarget};
+  Put32(req, 0x02002927);
+  resp = probe.Execute(req);
+  CHECK(resp.size() == 6 && resp[1] != static_cast<uint8_t>(DAP::Status::OK));
+}
+
+void TestOversizedCounts(SimProbe& probe)
+{
+  // 255 DP SELECT writes claimed, 12 fit the packet: those run, then ERROR
+  std::vector<uint8_t> req = {kCmdTransfer, 0, 255};
+  while (req.size() + 5 <= DAP::kPacketSize)
+  {
+    req.push_back(kDpWrite | DAP::DP_SELECT);
+    Put32(req, 0);
+  }
+  auto resp = probe.Execute(req);
+  CHECK(resp.size() == 3 && resp[1] == 12 && resp[2] == DAP::DAP_TRANSFER_ERROR);
+
+  // A block write is capped at the words the request carries
+  CHECK(Write(probe, kApWrite | DAP::AP_TAR, 0x20000000) == DAP::DAP_TRANSFER_OK);
+  req = {kCmdTransferBlock, 0, 0xFF, 0xFF, kApWrite | DAP::AP_DRW};
+  req.resize(DAP::kPacketSize);
+  resp = probe.Execute(req);
+  CHECK(resp.size() == 4 && DAP::GetU16(&resp[1]) == (DAP::kPacketSize - 5) / 4);
+
+  // A short report claiming more words than it holds writes only those
+  req.resize(5 + 2 * 4);
+  resp = probe.Execute(req);
+  CHECK(resp.size() == 4 && DAP::GetU16(&resp[1]) == 2);
+}
+
+std::vector<uint8_t> RttStart(SimProbe& probe, uint32_t address, uint32_t search_size,
+                              uint8_t flags = 0)
+{
+  std::vector<uint8_t> req = {kCmdRttStart};
+  Put32(req, address);
+  Put32(req, search_size);
+  req.insert(req.end(), {0, 0, 1, 0, flags});  // Up 0, down 0, 1 ms
+  return probe.Execute(req);
+}
+
+// Control block with one up and one down buffer in the last 72 bytes of RAM, the
+// up buffer holding "hello world"
+uint32_t PlantRttBlock(DAP::Sim::SwdTarget& target)
+{
+  const uint32_t ram_base = target.GetConfig().ram_base;
+  const uint32_t block = ram_base + target.GetConfig().ram_size - 72;
+  std::memcpy(target.Ram() + (block - ram_base), "SEGGER RTT", 11);
+  target.WriteWord(block + 16, 1);
+  target.WriteWord(block + 20, 1);
+  target.WriteWord(block + 28, ram_base + 0x100);  // Up buffer
+  target.WriteWord(block + 32, 16);
+  target.WriteWord(block + 36, 11);  // WrOff
+  std::memcpy(target.Ram() + 0x100, "hello world", 11);
+  return block;
+}
+
+void ClearRttBlock(DAP::Sim::SwdTarget& target, uint32_t block)
+{
+  const uint32_t ram_base = target.GetConfig().ram_base;
+  std::memset(target.Ram() + (block - ram_base), 0, 72);
+  std::memset(target.Ram() + 0x100, 0, 16);
+}
+
+void TestRttScan(SimProbe& probe)
+{
+  auto& target = probe.Target();
+  const uint32_t ram_end = target.GetConfig().ram_base + target.GetConfig().ram_size;
+
+  // A search ending at the end of RAM must not read past it
+  auto resp = RttStart(probe, ram_end - 16, 16);
+  CHECK(resp.size() == 6 && resp[1] == static_cast<uint8_t>(DAP::Status::Error));
+  CHECK(!target.StickyError());
+
+  const uint32_t block = PlantRttBlock(target);
+  resp = RttStart(probe, block, 0);
+  CHECK(resp.size() == 6 && resp[1] == static_cast<uint8_t>(DAP::Status::OK));
+  CHECK(resp.size() == 6 && DAP::GetU32(&resp[2]) == block);
+  resp = RttStart(probe, block - 8, 20);
+  CHECK(resp.size() == 6 && DAP::GetU32(&resp[2]) == block);
+  CHECK(probe.Execute({kCmdRttStop}).size() == 2);
+  ClearRttBlock(target, block);
+}
+
+class FakeRttSink : public DAP::RttSink
+{
+ public:
+  size_t Space() const override { return capacity - data.size(); }
+  void Write(const uint8_t* bytes, size_t len) override
+  {
+    data.insert(data.end(), bytes, bytes + len);
+  }
+
+  size_t capacity = 0;
+  std::vector<uint8_t> data;
+};
+
+void TestRttStream(SimProbe& probe)
+{
+  auto& target = probe.Target();
+  const uint32_t block = PlantRttBlock(target);
+
+  // Streaming needs a sink
+  CHECK(RttStart(probe, block, 0, 1).at(1) == static_cast<uint8_t>(DAP::Status::Error));
+
+  FakeRttSink sink;
+  sink.capacity = 5;
+  probe.Dap().SetRttSink(&sink);
+  CHECK(RttStart(probe, block, 0, 1).at(1) == static_cast<uint8_t>(DAP::Status::OK));
+
+  // Only what the sink takes leaves the target buffer
+  LibXR::Thread::Sleep(2);
+  probe.Dap().Poll();
+  CHECK(std::string(sink.data.begin(), sink.data.end()) == "hello");
+  CHECK(target.ReadWord(block + 40) == 5);  // RdOff
+
+  sink.capacity = 64;
+  LibXR::Thread::Sleep(2);
+  probe.Dap().Poll();
+  CHECK(std::string(sink.data.begin(), sink.data.end()) == "hello world");
+  CHECK(target.ReadWord(block + 40) == 11);
+  CHECK(probe.Execute({kCmdRttRead}).at(2) == 0);
+
+  CHECK(probe.Execute({kCmdRttStop}).size() == 2);
+  probe.Dap().SetRttSink(nullptr);
+  ClearRttBlock(target, block);
+}
+
+// SWD packets spent on a MEM_Crc32 over the start of RAM
+uint64_t CrcPackets(SimProbe& probe, uint32_t words)
+{
+  std::vector<uint8_t> req = {kCmdMemCrc32};
+  Put32(req, probe.Target().GetConfig().ram_base);
+  Put32(req, words * 4);
+
+  const uint64_t start = probe.Target().GetStats().packets;
+  const auto& resp = probe.Execute(req);
+  CHECK(resp.size() == 6 && resp[1] == static_cast<uint8_t>(DAP::Status::OK));
+  return probe.Target().GetStats().packets - start;
+}
+
+void TestMemChunks(SimProbe& probe)
+{
+  // A further 64-word chunk costs TAR, 64 DRW reads and RDBUFF; CSW stays put
+  const uint64_t one = CrcPackets(probe, 64);
+  const uint64_t two = CrcPackets(probe, 128);
+  CHECK(two - one == 66);
+}
+
+void TestStats(SimProbe& probe)
+{
+  CHECK(probe.Execute({kCmdStatsRead, 3, 0}).size() == 2);
+
+  uint32_t value = 0;
+  probe.Target().InjectWait(3);
+  CHECK(Read(probe, kApRead | DAP::AP_CSW, value) == DAP::DAP_TRANSFER_OK);
+  CHECK(Read(probe, kDpRead | DAP::DP_IDCODE, value) == DAP::DAP_TRANSFER_OK);
+  CHECK(probe.Execute({kCmdSwdConfigure, 0x00}).size() == 2);
+
+  // Counters: DAP_Transfer x2, then SWD_Configure, in slot order
+  auto resp = probe.Execute({kCmdStatsRead, 0, 0});
+  CHECK(resp.size() == 4 + 2 * 13 && resp[2] == 0xFF && resp[3] == 2);
+  if (resp.size() == 4 + 2 * 13)
+  {
+    CHECK(resp[4] == kCmdTransfer && DAP::GetU32(&resp[5]) == 2);
+    CHECK(resp[17] == kCmdSwdConfigure && DAP::GetU32(&resp[18]) == 1);
+  }
+
+  resp = probe.Execute({kCmdStatsRead, 1, kCmdTransfer});
+  CHECK(resp.size() == 4 + 2 * DAP::CommandStats::kBins && resp[3] == 16);
+  uint32_t total = 0;
+  for (size_t i = 4; i + 1 < resp.size(); i += 2)
+  {
+    total += DAP::GetU16(&resp[i]);
+  }
+  CHECK(total == 2);
+
+  // SWD outcomes: AP read, RDBUFF and DPIDR, the AP read answered WAIT 3 times
+  resp = probe.Execute({kCmdStatsRead, 2, 0});
+  CHECK(resp.size() == 22 && DAP::GetU32(&resp[2]) == 6 && DAP::GetU32(&resp[6]) == 3);
+  CHECK(resp.size() == 22 && DAP::GetU32(&resp[10]) == 0 && DAP::GetU32(&resp[18]) == 0);
+
+  CHECK(probe.Execute({kCmdStatsRead, 3, 0}).size() == 2);
+  resp = probe.Execute({kCmdStatsRead, 0, 0});
+  CHECK(resp.size() == 4 && resp[3] == 0);
+  CHECK(probe.Execute({kCmdStatsRead, 1, 0x40}).at(1) ==
+        static_cast<uint8_t>(DAP::Status::Error));
+}
+
+void TestTraceReplay()
+{
+  SimProbe recorder;
+  CHECK(recorder.Execute({kCmdTraceControl, 1}).size() == 3);
+  TestConnect(recorder);
+  TestBlock(recorder);
+  CHECK(recorder.Execute({kCmdTraceControl, 2}).size() == 3);
+
+  std::vector<uint8_t> stream;
+  while (true)
+  {
+    const auto& resp = recorder.Execute({kCmdTraceControl, 0});
+    CHECK(resp.size() >= 3 && resp[1] == static_cast<uint8_t>(DAP::Status::OK));
+    if (resp.size() <= 3)
+    {
+      break;
+    }
+    stream.insert(stream.end(), resp.begin() + 3, resp.end());
+  }
+
+  std::vector<DAP::Sim::TraceRecord> records;
+  std::string error;
+  CHECK(DAP::Sim::ParseTrace(stream, records, error));
+  CHECK(records.size() == 14);  // TestConnect 9, TestBlock 5
+
+  // A fresh target answers the same, byte for byte
+  SimProbe player;
+  DAP::Sim::TraceReplayer exact(player, DAP::Sim::TraceReplayer::Compare::Exact);
+  const auto result = exact.Run(records);
+  CHECK(result.records == records.size() && result.mismatches == 0);
+
+  // Another DPIDR only changes data, which status comparison ignores
+  DAP::Sim::SwdTarget::Config config;
+  config.dpidr = 0x0BC11477;
+  SimProbe other(config);
+  DAP::Sim::TraceReplayer status(other, DAP::Sim::TraceReplayer::Compare::Status);
+  CHECK(status.Run(records).mismatches == 0);
+
+  auto failed = records[1].response;
+  failed[2] = DAP::DAP_TRANSFER_FAULT;
+  CHECK(!status.Matches(failed, records[1].response));
+
+  stream.pop_back();
+  records.clear();
+  CHECK(!DAP::Sim::ParseTrace(stream, records, error));
+}
+
+void TestEventTrace()
+{
+  SimProbe probe;
+  auto resp = probe.Execute({kCmdEventRead, 1});
+  CHECK(resp.size() == 6 && DAP::GetU32(&resp[2]) == DAP::CyclesPerSecond());
+  TestConnect(probe);
+  CHECK(probe.Execute({kCmdEventRead, 2}).size() == 2);
+
+  DAP::Sim::EventDump dump;
+  dump.cycles_per_second = DAP::CyclesPerSecond();
+  while (true)
+  {
+    resp = probe.Execute({kCmdEventRead, 0});
+    CHECK(resp.size() >= 3 && resp[1] == static_cast<uint8_t>(DAP::Status::OK));
+    if (resp.size() <= 3)
+    {
+      break;
+    }
+    CHECK(resp.size() == 3 + resp[2] * DAP::EventTrace::kEventSize);
+    dump.events.insert(dump.events.end(), resp.begin() + 3, resp.end());
+  }
+
+  // Every command is bracketed, the transfers show up as SPI transactions
+  int starts = 0;
+  int ends = 0;
+  int spi = 0;
+  for (size_t i = 0; i < dump.events.size(); i += DAP::EventTrace::kEventSize)
+  {
+    const auto type = static_cast<DAP::EventType>(dump.events[i + 4]);
+    starts += (type == DAP::EventType::CommandStart);
+    ends += (type == DAP::EventType::CommandEnd);
+    spi += (type == DAP::EventType::SpiDone);
+  }
+  // TestConnect 9, plus the end of the start and the start of the stop
+  CHECK(starts == 10 && ends == 10);
+  CHECK(spi > 0);
+
+  DAP::Sim::EventDump parsed;
+  std::string error;
+  CHECK(DAP::Sim::EventDump::Parse(dump.Serialize(), parsed, error));
+  CHECK(parsed.events == dump.events);
+  const std::string json = DAP::Sim::ToChromeTrace(parsed);
+  CHECK(json.find("\"name\": \"DAP_Transfer\"") != std::string::npos);
+  CHECK(json.find("\"ph\": \"E\"") != std::string::npos);
+
+  auto truncated = dump.Serialize();
+  truncated.pop_back();
+  CHECK(!DAP::Sim::EventDump::Parse(truncated, parsed, error));
+}
+
+// Three tasks numbered 1, 2 and 5, listed out of order like the kernel does
+class FakeSystemStats : public DAP::SystemStats
+{
+ public:
+  size_t ReadTasks(uint8_t first, Task* tasks, size_t max_tasks,
+                   uint32_t& total_run_time) override
+  {
+    static const Task kTasks[] = {{5, 2, 3, 100, 250, "worker"},
+                                  {1, 0, 3, 1200, 500, "DefaultTask"},
+                                  {2, 1, 0, 40, 250, "IDLE"}};
+    static const size_t kOrder[] = {1, 2, 0};
+    size_t n = 0;
+    for (size_t i : kOrder)
+    {
+      if (kTasks[i].number >= first && n < max_tasks)
+      {
+        tasks[n++] = kTasks[i];
+      }
+    }
+    total_run_time = 1000;
+    return n;
+  }
+
+  Heap ReadHeap() override { return {51200, 20000, 18000}; }
+  uint32_t RunTimeHz() const override { return 100000; }
+};
+
+void TestSysStats()
+{
+  SimProbe probe;
+  CHECK(probe.Execute({kCmdSysStats, 0, 0}).at(1) ==
+        static_cast<uint8_t>(DAP::Status::Error));
+
+  FakeSystemStats stats;
+  probe.Dap().SetSystemStats(&stats);
+
+  auto resp = probe.Execute({kCmdSysStats, 0, 0});
+  CHECK(resp.size() == 22 && DAP::GetU32(&resp[2]) == 51200);
+  CHECK(resp.size() == 22 && DAP::GetU32(&resp[10]) == 18000);
+  CHECK(resp.size() == 22 && DAP::GetU32(&resp[14]) == 1000);
+  CHECK(resp.size() == 22 && DAP::GetU32(&resp[18]) == 100000);
+
+  // Two tasks per packet, in task number order
+  constexpr size_t kEntry = 11 + DAP::SystemStats::kNameSize;
+  resp = probe.Execute({kCmdSysStats, 1, 0});
+  CHECK(resp.size() == 4 + 2 * kEntry && resp[2] == 5 && resp[3] == 2);
+  if (resp.size() == 4 + 2 * kEntry)
+  {
+    CHECK(resp[4] == 1 && DAP::GetU16(&resp[7]) == 1200);
+    CHECK(DAP::GetU16(&resp[13]) == 5000);  // 50.00 %
+    CHECK(std::strcmp(reinterpret_cast<const char*>(&resp[15]), "DefaultTask") == 0);
+    CHECK(resp[4 + kEntry] == 2);
+  }
+
+  resp = probe.Execute({kCmdSysStats, 1, 5});
+  CHECK(resp.size() == 4 + kEntry && resp[2] == 0xFF && resp[3] == 1);
+  CHECK(resp.size() == 4 + kEntry && resp[4] == 5 && DAP::GetU16(&resp[13]) == 2500);
+
+  CHECK(probe.Execute({kCmdSysStats, 2, 0}).at(1) ==
+        static_cast<uint8_t>(DAP::Status::Error));
+}
+
+void CaptureResponse(bool in_isr, std::vector<uint8_t>* out, const uint8_t* data,
+                     size_t size)
+{
+  UNUSED(in_isr);
+  out->assign(data, data + size);
+}
+
+void TestDispatch()
+{
+  SimProbe probe;
+  const std::vector<uint8_t> invalid = {static_cast<uint8_t>(DAP::CommandId::Invalid)};
+
+  // No handler: an unimplemented standard command and an unassigned ID
+  CHECK(probe.Execute({kCmdWriteAbort, 0, 0, 0, 0, 0}) == invalid);
+  CHECK(probe.Execute({0x20}) == invalid);
+
+  // RVSWD framing is unverified, so WCH_Connect is not dispatched
+  CHECK(probe.Execute({static_cast<uint8_t>(DAP::VendorCommandId::WCH_Connect)}) ==
+        invalid);
+  CHECK(DAP::DapProtocol::MaxResponseLength(0x20) == 0);
+  CHECK(DAP::DapProtocol::MaxResponseLength(kCmdSysStats) == DAP::kPacketSize);
+
+  // A request shorter than the fixed parameters never reaches the handler
+  std::vector<uint8_t> resp;
+  auto callback = LibXR::Callback<const uint8_t*, size_t>::Create(CaptureResponse, &resp);
+  uint8_t req[DAP::kPacketSize] = {kCmdSwjClock, 0x40, 0x42, 0x0F, 0x00};
+  CHECK(probe.Dap().ExecuteCommand(req, callback, 4) == 1 && resp == invalid);
+  CHECK(probe.Dap().ExecuteCommand(req, callback, 5) == 2 && resp.size() == 2 &&
+        resp[1] == static_cast<uint8_t>(DAP::Status::OK));
+
+  // 1 MHz on the 72 MHz SPI bus: /64 would overshoot, /128 gives 562.5 kHz
+  CHECK(probe.Spi().GetConfig().prescaler == LibXR::SPI::Prescaler::DIV_128);
+  CHECK(probe.Execute({kCmdSwjClock, 0x00, 0x1B, 0xB7, 0x00})[1] == 0x00);  // 12 MHz
+  CHECK(probe.Spi().GetConfig().prescaler == LibXR::SPI::Prescaler::DIV_8);
+}
+
+void RunSuite(SimProbe& probe, const char* name)
+{
+  const int before = failures;
+
+  // Connecting parses the line reset and JTAG-to-SWD bits as bad headers
+  TestConnect(probe);
+  const uint64_t errors = probe.Target().GetStats().protocol_errors;
+
+  TestBlock(probe);
+  TestWaitFault(probe);
+  CHECK(probe.Target().GetStats().protocol_errors == errors);
+  CHECK(probe.Target().GetStats().parity_errors == 0);
+  TestOversizedCounts(probe);
+  TestRttScan(probe);
+  TestRttStream(probe);
+  TestMemChunks(probe);
+  TestStats(probe);
+  TestTurnaround(probe);
+
+  std::printf("%-10s %s (%llu SWCLK cycles)\n", name,
+              failures == before ? "ok" : "FAILED",
+              static_cast<unsigned long long>(probe.Target().GetStats().clocks));
+}
+
+void TestSba()
+{
+  constexpr uint32_t kBase = 0x20000000;
+  DAP::Sim::SimDebugModule dm(kBase, 64);
+  for (uint32_t i = 0; i < 64; i++)
+  {
+    dm.Memory()[i] = 0x5A000000 + i;
+  }
+  DAP::RiscvSba sba(dm);
+
+  // 20 words span two DMI batches
+  uint32_t words[20] = {};
+  CHECK(sba.ReadBlock(kBase, words, 20) == DAP::DAP_TRANSFER_OK);
+  bool match = true;
+  for (uint32_t i = 0; i < 20; i++)
+  {
+    match = match && words[i] == 0x5A000000 + i;
+  }
+  CHECK(match);
+
+  // A bus error partway through survives to the end-of-block check, in the
+  // same batch as the final read and in an earlier one
+  dm.SetFaultAddress(kBase + 5 * 4);
+  CHECK(sba.ReadBlock(kBase, words, 10) == DAP::DAP_TRANSFER_ERROR);
+  CHECK(sba.ReadBlock(kBase, words, 20) == DAP::DAP_TRANSFER_ERROR);
+  CHECK(sba.WriteBlock(kBase, words, 8) == DAP::DAP_TRANSFER_ERROR);
+
+  // The error was cleared, so the next block runs
+  dm.SetFaultAddress(0xFFFFFFFF);
+  const uint32_t pattern[3] = {0x11111111, 0x22222222, 0x33333333};
+  CHECK(sba.WriteBlock(kBase + 0x80, pattern, 3) == DAP::DAP_TRANSFER_OK);
+  CHECK(dm.Memory()[32] == pattern[0] && dm.Memory()[34] == pattern[2]);
+  CHECK(sba.ReadBlock(kBase + 0x80, words, 3) == DAP::DAP_TRANSFER_OK);
+  CHECK(words[1] == pattern[1]);
+}
+
+std::vector<uint8_t> MemRead(SimProbe& probe, uint32_t address, uint8_t len)
+{
+  std::vector<uint8_t> req = {kCmdMemRead};
+  Put32(req, address);
+  req.push_back(len);
+  return probe.Execute(req);
+}
+
+uint8_t MemWrite(SimProbe& probe, uint32_t address, const std::vector<uint8_t>& data)
+{
+  std::vector<uint8_t> req = {kCmdMemWrite};
+  Put32(req, address);
+  req.push_back(static_cast<uint8_t>(data.size()));
+  req.insert(req.end(), data.begin(), data.end());
+  const auto& resp = probe.Execute(req);
+  return (resp.size() == 2 && resp[0] == kCmdMemWrite) ? resp[1] : 0xFF;
+}
+
+void TestMemReadWrite()
+{
+  SimProbe probe;
+  CHECK(PowerUp(probe));
+  auto& target = probe.Target();
+  const uint32_t ram_base = target.GetConfig().ram_base;
+  const uint32_t ram_end = ram_base + target.GetConfig().ram_size;
+  uint8_t* ram = target.Ram();
+
+  // Unaligned head and tail go out as byte/halfword lanes; neighbours survive
+  std::memset(ram + 0x1F8, 0xEE, 0x18);
+  const std::vector<uint8_t> odd = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77};
+  CHECK(MemWrite(probe, ram_base + 0x201, odd) == kStatusOk);
+  CHECK(ram[0x200] == 0xEE && ram[0x208] == 0xEE);
+  CHECK(std::memcmp(ram + 0x201, odd.data(), odd.size()) == 0);
+  auto resp = MemRead(probe, ram_base + 0x201, 7);
+  CHECK(resp.size() == 10 && resp[1] == kStatusOk && resp[2] == 7);
+  CHECK(resp.size() == 10 && std::equal(odd.begin(), odd.end(), resp.begin() + 3));
+  resp = MemRead(probe, ram_base + 0x1FF, 3);
+  CHECK(resp.size() == 6 && resp[3] == 0xEE && resp[4] == 0xEE && resp[5] == 0x11);
+
+  // Auto-increment wraps at 1 KB, so TAR is re-seeded across the boundary
+  std::vector<uint8_t> span;
+  for (uint8_t i = 0; i < 50; i++)
+  {
+    span.push_back(static_cast<uint8_t>(0xA0 + i));
+  }
+  CHECK(MemWrite(probe, ram_base + 0x3E6, span) == kStatusOk);
+  CHECK(std::memcmp(ram + 0x3E6, span.data(), span.size()) == 0);
+  CHECK(ram[0x3E5] == 0 && ram[0x3E6 + 50] == 0);
+  resp = MemRead(probe, ram_base + 0x3E6, 50);
+  CHECK(resp.size() == 53 && resp[1] == kStatusOk && resp[2] == 50);
+  CHECK(resp.size() == 53 && std::equal(span.begin(), span.end(), resp.begin() + 3));
+
+  // Past the end of RAM: Error, no data, and the bus error is left to ABORT
+  resp = MemRead(probe, ram_end - 4, 8);
+  CHECK(resp.size() == 3 && resp[1] == kStatusError && resp[2] == 0);
+  CHECK(target.StickyError());
+  CHECK(Write(probe, kDpWrite | DAP::DP_ABORT, 0x1E) == DAP::DAP_TRANSFER_OK);
+  CHECK(MemWrite(probe, ram_end - 2, {1, 2, 3, 4}) == kStatusError);
+  CHECK(Write(probe, kDpWrite | DAP::DP_ABORT, 0x1E) == DAP::DAP_TRANSFER_OK);
+
+  // Longer than the response can hold
+  resp = MemRead(probe, ram_base, DAP::kPacketSize - 2);
+  CHECK(resp.size() == 3 && resp[1] == kStatusError);
+
+  resp = MemRead(probe, ram_base + 0x202, 2);
+  CHECK(resp.size() == 5 && resp[1] == kStatusOk && resp[3] == 0x22 && resp[4] == 0x33);
+}
+
+uint8_t MemFill(SimProbe& probe, uint32_t address, uint32_t size, uint32_t pattern,
+                uint32_t step)
+{
+  std::vector<uint8_t> req = {kCmdMemFill};
+  Put32(req, address);
+  Put32(req, size);
+  Put32(req, pattern);
+  Put32(req, step);
+  const auto& resp = probe.Execute(req);
+  return (resp.size() == 2 && resp[0] == kCmdMemFill) ? resp[1] : 0xFF;
+}
+
+/**
+ * @brief MEM_BlankCheck or MEM_RamTest
+ * @return Status byte; fail_addr holds the reported address
+ */
+uint8_t MemCheck(SimProbe& probe, uint8_t command, uint32_t address, uint32_t size,
+                 uint32_t& fail_addr)
+{
+  std::vector<uint8_t> req = {command};
+  Put32(req, address);
+  Put32(req, size);
+  const auto& resp = probe.Execute(req);
+  if (resp.size() != 6 || resp[0] != command)
+  {
+    return 0xFF;
+  }
+  fail_addr = DAP::GetU32(&resp[2]);
+  return resp[1];
+}
+
+void TestMemFillCheck()
+{
+  SimProbe probe;
+  CHECK(PowerUp(probe));
+  auto& target = probe.Target();
+  const uint32_t ram_base = target.GetConfig().ram_base;
+  uint32_t fail = 0;
+
+  // Constant fill over more than one chunk, nothing outside the range
+  const uint32_t blank = ram_base + 0x1000;
+  CHECK(MemFill(probe, blank, 0x200, 0xFFFFFFFF, 0) == kStatusOk);
+  bool filled = true;
+  for (uint32_t i = 0; i < 0x200; i += 4)
+  {
+    filled = filled && target.ReadWord(blank + i) == 0xFFFFFFFF;
+  }
+  CHECK(filled);
+  CHECK(target.ReadWord(blank - 4) == 0 && target.ReadWord(blank + 0x200) == 0);
+  CHECK(MemCheck(probe, kCmdMemBlankCheck, blank, 0x200, fail) == kStatusOk);
+  CHECK(fail == 0xFFFFFFFF);
+
+  // The first programmed word is reported, not a later one
+  target.Ram()[0x1123] = 0x7F;
+  target.Ram()[0x1180] = 0x00;
+  CHECK(MemCheck(probe, kCmdMemBlankCheck, blank, 0x200, fail) == kStatusOk);
+  CHECK(fail == blank + 0x120);
+
+  // Incrementing pattern
+  const uint32_t ramp = ram_base + 0x2000;
+  CHECK(MemFill(probe, ramp, 0x100, 0x1000, 4) == kStatusOk);
+  bool ramped = true;
+  for (uint32_t i = 0; i < 0x40; i++)
+  {
+    ramped = ramped && target.ReadWord(ramp + i * 4) == 0x1000 + i * 4;
+  }
+  CHECK(ramped);
+  CHECK(MemFill(probe, ramp, 6, 0, 0) == kStatusError);
+
+  // RAM test on good RAM
+  const uint32_t test = ram_base + 0x8000;
+  CHECK(MemCheck(probe, kCmdMemRamTest, test, 0x1000, fail) == kStatusOk);
+  CHECK(fail == 0xFFFFFFFF);
+
+  // A stuck bit fails at its word
+  target.SetStuckBits(test + 0x10, 1U << 5, 1U << 5);
+  CHECK(MemCheck(probe, kCmdMemRamTest, test, 0x1000, fail) == kStatusOk);
+  CHECK(fail == test + 0x10);
+  target.SetStuckBits(0, 0, 0);
+
+  // Address line 11 missing: the upper 2 KB overwrite the lower 2 KB. The alias
+  // distance is a multiple of 32 words, invisible to the walking ones alone
+  target.SetAddressMask(~0x800U);
+  CHECK(MemCheck(probe, kCmdMemRamTest, test, 0x1000, fail) == kStatusOk);
+  CHECK(fail == test);
+  target.SetAddressMask(0xFFFFFFFF);
+}
+
+/**
+ * @brief MEM_Search for "PALM" with the second byte masked out
+ * @return Match addresses, or {0} if the command did not return OK
+ */
+std::vector<uint32_t> MemSearch(SimProbe& probe, uint32_t address, uint32_t size,
+                                uint8_t max_matches)
+{
+  std::vector<uint8_t> req = {kCmdMemSearch};
+  Put32(req, address);
+  Put32(req, size);
+  req.insert(req.end(), {max_matches, 4, 'P', 0, 'L', 'M', 0xFF, 0x00, 0xFF, 0xFF});
+  const auto& resp = probe.Execute(req);
+  if (resp.size() < 3 || resp[1] != kStatusOk || resp.size() != 3U + resp[2] * 4U)
+  {
+    return {0};
+  }
+
+  std::vector<uint32_t> matches;
+  for (size_t i = 3; i < resp.size(); i += 4)
+  {
+    matches.push_back(DAP::GetU32(&resp[i]));
+  }
+  return matches;
+}
+
+void TestMemSearch()
+{
+  SimProbe probe;
+  CHECK(PowerUp(probe));
+  auto& target = probe.Target();
+  const uint32_t region = target.GetConfig().ram_base + 0x4000;
+  for (uint32_t offset : {0x003U, 0x0FEU, 0x1FDU, 0x2FCU})
+  {
+    std::memcpy(target.Ram() + 0x4000 + offset, "PALM", 4);
+  }
+
+  // An unaligned start, matches straddling the 256-byte read windows (the next
+  // window starts unaligned too), and one ending on the last byte
+  const std::vector<uint32_t> all = {region + 0x003, region + 0x0FE, region + 0x1FD,
+                                     region + 0x2FC};
+  CHECK(MemSearch(probe, region + 3, 0x2FD, 0) == all);
+
+  // A copy running past the end of the range is not a match
+  CHECK(MemSearch(probe, region + 3, 0x2FC, 0) ==
+        std::vector<uint32_t>(all.begin(), all.begin() + 3));
+
+  // The scan stops once max_matches are found, without reading further windows
+  const uint64_t before = target.GetStats().packets;
+  CHECK(MemSearch(probe, region + 3, 0x2FD, 0).size() == 4);
+  const uint64_t full = target.GetStats().packets - before;
+  CHECK(MemSearch(probe, region + 3, 0x2FD, 1) == std::vector<uint32_t>{all[0]});
+  CHECK(target.GetStats().packets - before - full < full / 2);
+  CHECK(MemSearch(probe, region + 3, 0x2FD, 2) ==
+        std::vector<uint32_t>(all.begin(), all.begin() + 2));
+
+  // size == len holds exactly one candidate, size < len none
+  CHECK(MemSearch(probe, region + 0xFE, 4, 0) == std::vector<uint32_t>{region + 0xFE});
+  CHECK(MemSearch(probe, region + 0xFD, 4, 0).empty());
+  CHECK(MemSearch(probe, region + 0xFE, 3, 0).empty());
+}
+
+uint32_t ExpectedCrc(DAP::Sim::SwdTarget& target, uint32_t address, uint32_t size)
+{
+  DAP::SoftwareCrc32 crc;
+  crc.Reset();
+  for (uint32_t i = 0; i < size; i += 4)
+  {
+    const uint32_t word = target.ReadWord(address + i);
+    crc.Feed(&word, 1);
+  }
+  return crc.Value();
+}
+
+void PutSector(std::vector<uint8_t>& req, uint32_t address, uint32_t size, uint32_t crc)
+{
+  Put32(req, address);
+  Put32(req, size);
+  Put32(req, crc);
+}
+
+void TestMemCrc()
+{
+  SimProbe probe;
+  CHECK(PowerUp(probe));
+  auto& target = probe.Target();
+  const uint32_t ram_base = target.GetConfig().ram_base;
+  const uint32_t ram_end = ram_base + target.GetConfig().ram_size;
+
+  // Planted data over several read chunks and a 1 KB TAR wrap
+  const uint32_t data = ram_base + 0x3000;
+  uint32_t seed = 0x12345678;
+  for (uint32_t i = 0; i < 0x600; i += 4)
+  {
+    seed = seed * 1664525 + 1013904223;
+    target.WriteWord(data + 0x100 + i, seed);
+  }
+  std::vector<uint8_t> req = {kCmdMemCrc32};
+  Put32(req, data + 0x100);
+  Put32(req, 0x600);
+  const uint32_t expected = ExpectedCrc(target, data + 0x100, 0x600);
+  auto resp = probe.Execute(req);
+  CHECK(resp.size() == 6 && resp[1] == kStatusOk);
+  CHECK(resp.size() == 6 && DAP::GetU32(&resp[2]) == expected);
+  req = {kCmdMemCrc32};
+  Put32(req, data + 2);
+  Put32(req, 0x10);
+  CHECK(probe.Execute(req).at(1) == kStatusError);
+
+  // One matching and one differing sector
+  const uint32_t good = ExpectedCrc(target, data, 0x200);
+  const uint32_t bad = ExpectedCrc(target, data + 0x200, 0x200) ^ 1;
+  req = {kCmdMemSectorDiff, 2};
+  PutSector(req, data, 0x200, good);
+  PutSector(req, data + 0x200, 0x200, bad);
+  resp = probe.Execute(req);
+  CHECK(resp.size() == 4 && resp[1] == kStatusOk && resp[2] == 2 && resp[3] == 0x02);
+
+  // An access error stops the check; only sectors before it are counted
+  req = {kCmdMemSectorDiff, 4};
+  PutSector(req, data + 0x200, 0x200, bad);
+  PutSector(req, data, 0x200, good);
+  PutSector(req, ram_end - 0x100, 0x200, 0);
+  PutSector(req, data, 0x200, 0);
+  resp = probe.Execute(req);
+  CHECK(resp.size() == 4 && resp[1] == kStatusError && resp[2] == 2 && resp[3] == 0x01);
+  CHECK(Write(probe, kDpWrite | DAP::DP_ABORT, 0x1E) == DAP::DAP_TRANSFER_OK);
+
+  // A count beyond the entries present is clamped to them
+  req = {kCmdMemSectorDiff, 200};
+  PutSector(req, data, 0x200, bad);
+  PutSector(req, data, 0x200, good);
+  resp = probe.Execute(req);
+  CHECK(resp.size() == 4 && resp[1] == kStatusOk && resp[2] == 2 && resp[3] == 0x01);
+}
+
+DAP::Sim::SwdTarget::Config GangTarget(uint32_t dpidr)
+{
+  DAP::Sim::SwdTarget::Config config;
+  config.dpidr = dpidr;
+  return config;
+}
+
+// A probe with three gang ports, each in front of its own target
+struct GangFixture
+{
+  SimPort ports[3] = {SimPort(GangTarget(0x2BA01477)), SimPort(GangTarget(0x0BC11477)),
+                      SimPort(GangTarget(0x6BA02477))};
+  DAP::DapGangIo io = {{&ports[0].io, &ports[1].io, &ports[2].io}, 3};
+  SimProbe probe{DAP::Sim::SwdTarget::Config{}, &io};
+};
+
+// Per port entry of a gang response: [Ack] [Done] [Data(4)]
+struct GangPort
+{
+  uint8_t ack;
+  uint8_t done;
+  uint32_t data;
+};
+
+/**
+ * @brief Decode a gang response
+ * @return Status byte, 0xFF if malformed; ports holds one entry per gang port
+ */
+uint8_t GangResponse(const std::vector<uint8_t>& resp, uint8_t command,
+                     std::vector<GangPort>& ports)
+{
+  ports.clear();
+  if (resp.size() < 3 || resp[0] != command || resp.size() != 3U + resp[2] * 6U)
+  {
+    return 0xFF;
+  }
+  for (size_t i = 3; i < resp.size(); i += 6)
+  {
+    ports.push_back({resp[i], resp[i + 1], DAP::GetU32(&resp[i + 2])});
+  }
+  return resp[1];
+}
+
+uint8_t GangBlock(SimProbe& probe, uint8_t request, const std::vector<uint32_t>& words,
+                  std::vector<GangPort>& ports, uint8_t count = 0)
+{
+  std::vector<uint8_t> req = {kCmdGangBlock,
+                              static_cast<uint8_t>(count ? count : words.size()),
+                              request};
+  for (uint32_t word : words)
+  {
+    Put32(req, word);
+  }
+  return GangResponse(probe.Execute(req), kCmdGangBlock, ports);
+}
+
+bool PortIs(const GangPort& port, uint8_t ack, uint8_t done)
+{
+  return port.ack == ack && port.done == done;
+}
+
+void TestGang()
+{
+  // Port workers never exit, so the gang is kept for the life of the process
+  auto* gang = new GangFixture;
+  SimProbe& probe = gang->probe;
+  SimPort* ports = gang->ports;
+  const uint32_t ram_base = ports[0].target.GetConfig().ram_base;
+  constexpr uint8_t kOk = DAP::DAP_TRANSFER_OK;
+  std::vector<GangPort> result;
+
+  // Port 2 has no target: it fails to connect and drops out of the blocks
+  ports[2].target.SetConnected(false);
+  CHECK(GangResponse(probe.Execute({kCmdGangConnect, 0x07}), kCmdGangConnect, result) ==
+        kStatusError);
+  CHECK(result.size() == 3);
+  if (result.size() != 3)
+  {
+    return;
+  }
+  CHECK(PortIs(result[0], kOk, 1) && result[0].data == 0x2BA01477);
+  CHECK(PortIs(result[1], kOk, 1) && result[1].data == 0x0BC11477);
+  CHECK(result[2].ack != kOk && result[2].done == 0);
+
+  // Plugged in afterwards, it still sees no traffic until the next connect
+  ports[2].target.SetConnected(true);
+  const uint64_t idle_packets = ports[2].target.GetStats().packets;
+  CHECK(GangBlock(probe, kDpWrite | DAP::DP_CTRL_STAT, {0x50000000}, result) ==
+        kStatusOk);
+  CHECK(PortIs(result[0], kOk, 1) && PortIs(result[1], kOk, 1));
+  CHECK(PortIs(result[2], 0, 0));
+  CHECK(GangBlock(probe, kApWrite | DAP::AP_CSW, {0x23000012}, result) == kStatusOk);
+  CHECK(GangBlock(probe, kApWrite | DAP::AP_TAR, {ram_base + 0x40}, result) ==
+        kStatusOk);
+  CHECK(GangBlock(probe, kApWrite | DAP::AP_DRW, {11, 22, 33, 44}, result) == kStatusOk);
+  CHECK(PortIs(result[0], kOk, 4) && PortIs(result[1], kOk, 4));
+  CHECK(PortIs(result[2], 0, 0));
+  CHECK(ports[0].target.ReadWord(ram_base + 0x4C) == 44);
+  CHECK(ports[1].target.ReadWord(ram_base + 0x4C) == 44);
+  CHECK(ports[2].target.ReadWord(ram_base + 0x40) == 0);
+  CHECK(ports[2].target.GetStats().packets == idle_packets);
+
+  // Port 1 answers WAIT beyond the retry limit; port 0 reads on regardless
+  CHECK(GangBlock(probe, kApWrite | DAP::AP_TAR, {ram_base + 0x40}, result) ==
+        kStatusOk);
+  ports[1].target.InjectWait(1000);
+  CHECK(GangBlock(probe, kApRead | DAP::AP_DRW, {}, result, 4) == kStatusError);
+  CHECK(PortIs(result[0], kOk, 4) && result[0].data == 44);
+  CHECK(PortIs(result[1], DAP::DAP_TRANSFER_WAIT, 0));
+  ports[1].target.InjectWait(0);
+
+  // Port 0 faults; ABORT clears it and both read again
+  ports[0].target.InjectFault();
+  CHECK(GangBlock(probe, kApWrite | DAP::AP_TAR, {ram_base + 0x44}, result) ==
+        kStatusError);
+  CHECK(PortIs(result[0], DAP::DAP_TRANSFER_FAULT, 0) && PortIs(result[1], kOk, 1));
+  CHECK(GangBlock(probe, kDpWrite | DAP::DP_ABORT, {0x1E}, result) == kStatusOk);
+  CHECK(GangBlock(probe, kApWrite | DAP::AP_TAR, {ram_base + 0x44}, result) ==
+        kStatusOk);
+  CHECK(GangBlock(probe, kApRead | DAP::AP_DRW, {}, result, 2) == kStatusOk);
+  CHECK(PortIs(result[0], kOk, 2) && result[0].data == 33);
+  CHECK(PortIs(result[1], kOk, 2) && result[1].data == 33);
+
+  // Mask 0 releases every port
+  CHECK(GangResponse(probe.Execute({kCmdGangConnect, 0}), kCmdGangConnect, result) ==
+        kStatusOk);
+  CHECK(GangBlock(probe, kDpRead | DAP::DP_IDCODE, {}, result, 1) == kStatusError);
+  CHECK(result.size() == 3 && PortIs(result[0], 0, 0) && PortIs(result[1], 0, 0));
+}
+
+struct ProbeRun
+{
+  SimProbe probe;
+  const char* serial = nullptr;
+  uint32_t seed = 0;
+  int mismatches = 0;
+};
+
+// Memory traffic and DAP_Info on one probe; no CHECK here, the counter is not
+// shared between threads
+void DriveProbe(ProbeRun& run)
+{
+  SimProbe& probe = run.probe;
+  probe.Dap().SetSerialNumber(run.serial);
+  if (!PowerUp(probe) || Write(probe, kApWrite | DAP::AP_CSW, 0x23000012) != 0x01)
+  {
+    run.mismatches++;
+    return;
+  }
+
+  const std::vector<uint8_t> serial_info = {
+      static_cast<uint8_t>(DAP::CommandId::Info),
+      static_cast<uint8_t>(DAP::InfoId::SerialNumber)};
+  const size_t serial_len = std::strlen(run.serial);
+  for (uint32_t i = 0; i < 400; i++)
+  {
+    const uint32_t addr = 0x20000000 + (i % 256) * 4;
+    uint32_t value = 0;
+    if (Write(probe, kApWrite | DAP::AP_TAR, addr) != 0x01 ||
+        Write(probe, kApWrite | DAP::AP_DRW, run.seed + i) != 0x01 ||
+        Write(probe, kApWrite | DAP::AP_TAR, addr) != 0x01 ||
+        Read(probe, kApRead | DAP::AP_DRW, value) != 0x01 || value != run.seed + i)
+    {
+      run.mismatches++;
+    }
+
+    const auto& resp = probe.Execute(serial_info);
+    if (resp.size() < 2 + serial_len || resp[1] != serial_len ||
+        std::memcmp(&resp[2], run.serial, serial_len) != 0)
+    {
+      run.mismatches++;
+    }
+  }
+}
+
+// Two probes in one process, as with two HIDCmsisDap interfaces: each keeps its
+// own transfer state, response buffer and DAP_Info serial
+void TestConcurrentProbes()
+{
+  ProbeRun runs[2];
+  runs[0].serial = "PROBE-A";
+  runs[0].seed = 0xA0000000;
+  runs[1].serial = "PROBE-B";
+  runs[1].seed = 0xB0000000;
+  std::thread other([&runs] { DriveProbe(runs[1]); });
+  DriveProbe(runs[0]);
+  other.join();
+
+  CHECK(runs[0].mismatches == 0);
+  CHECK(runs[1].mismatches == 0);
+  for (auto& run : runs)
+  {
+    bool own = true;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+      own = own && (run.probe.Target().ReadWord(0x20000000 + i * 4) >> 28) ==
+                       (run.seed >> 28);
+    }
+    CHECK(own);
+  }
+}
+
+// Runs a self-contained test group and reports only its own failures
+void RunSection(const char* name, void (*test)())
+{
+  const int before = failures;
+  test();
+  std::printf("%-10s %s\n", name, failures == before ? "ok" : "FAILED");
+}
+
+}  // namespace
+
+int main()
+{
+  {
+    SimProbe probe;
+    RunSuite(probe, "spi");
+  }
+
+  {
+    SimProbe probe;
+    const auto& resp = probe.Execute({kCmdSelectEngine, 1});
+    CHECK(resp.size() == 2 && resp[1] == static_cast<uint8_t>(DAP::Status::OK));
+    RunSuite(probe, "gpio");
+  }
+
+  RunSection("targetsel", TestMultidrop);
+  RunSection("trace", TestTraceReplay);
+  RunSection("events", TestEventTrace);
+  RunSection("sysstats", TestSysStats);
+  RunSection("dispatch", TestDispatch);
+  RunSection("sba", TestSba);
+  RunSection("concurrent", TestConcurrentProbes);
+  RunSection("memrw", TestMemReadWrite);
+  RunSection("memfill", TestMemFillCheck);
+  RunSection("memsearch", TestMemSearch);
+  RunSection("memcrc", TestMemCrc);
+  RunSection("gang", TestGang);
+
+  return failures == 0 ? 0 : 1;
+}